@@ -27,6 +27,17 @@ g_resources.setupUserWriteDir(('%s/'):format(g_app.getCompactName()))
 -- search all packages
 g_resources.searchAndAddPackages('/', '.otpkg', true)
 
+-- the binary otml cache can be disabled for comparing load times
+if g_app.getStartupOptions():find('--no-otml-cache') then
+  g_otmlcache.setEnabled(false)
+end
+
+-- record where startup time goes, open the dump in chrome://tracing
+local traceStartup = g_app.getStartupOptions():find('--trace-startup')
+if traceStartup then
+  g_tracer.setEnabled(true)
+end
+
 -- load settings
 g_configs.loadSettings("/config.otml")
 
@@ -48,6 +59,15 @@ g_modules.ensureModuleLoaded("game_interface")
 -- mods 1000-9999
 g_modules.autoLoadModules(9999)
 
+g_logger.debug(string.format("OTML documents loaded in %d ms (%d from cache, %d parsed)",
+  g_otmlcache.getLoadMillis(), g_otmlcache.getHits(), g_otmlcache.getMisses()))
+
+if traceStartup then
+  g_tracer.dump('/startup_trace.json')
+  g_tracer.logSummary()
+  g_tracer.setEnabled(false)
+end
+
 local script = '/' .. g_app.getCompactName() .. 'rc.lua'
 
 if g_resources.fileExists(script) then
@@ -37,6 +37,20 @@ local function onSessionKey(protocol, sessionKey)
   G.sessionKey = sessionKey
 end
 
+local function warmUpGameImages()
+  -- decode the game interface images in the background while a character is picked
+  local files = {}
+  for _,dir in ipairs({'/images/game/slots', '/images/game/states', '/images/game/combatmodes',
+                       '/images/game/skulls', '/images/game/shields', '/images/game/emblems'}) do
+    for _,file in ipairs(g_resources.listDirectoryFiles(dir)) do
+      if g_resources.isFileType(file, 'png') then
+        table.insert(files, dir .. '/' .. file)
+      end
+    end
+  end
+  g_textures.warmUp(files)
+end
+
 local function onCharacterList(protocol, characters, account, otui)
   -- Try add server to the server list
   ServerList.add(G.host, G.port, g_game.getClientVersion())
@@ -74,6 +88,7 @@ local function onCharacterList(protocol, characters, account, otui)
 
   CharacterList.create(characters, account, otui)
   CharacterList.show()
+  warmUpGameImages()
 
   if motdEnabled then
     local lastMotdNumber = g_settings.getNumber("motd")
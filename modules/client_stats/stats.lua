@@ -74,6 +74,20 @@ function onConnect(protocol)
   post = post .. '&painter_engine='    .. g_graphics.getPainterEngine()
   post = post .. '&fps='               .. g_app.getBackgroundPaneFps()
   post = post .. '&max_fps='           .. g_app.getBackgroundPaneMaxFps()
+  post = post .. '&lua_gc_micros='     .. g_app.getGarbageCollectMicros()
+  post = post .. '&fg_frame_micros='   .. g_app.getForegroundFrameMicros()
+  post = post .. '&fg_fps='            .. g_app.getForegroundPaneFps()
+  post = post .. '&draw_calls='        .. g_app.getDrawCallsPerFrame()
+  post = post .. '&frame_textures='    .. g_app.getTexturesPerFrame()
+  post = post .. '&ui_atlas_pages='    .. g_textures.getAtlasPageCount()
+  post = post .. '&ui_layer_redraws='  .. g_ui.getLayerRedraws()
+  post = post .. '&ui_layer_blits='    .. g_ui.getLayerBlits()
+  post = post .. '&ui_mouse_move_micros=' .. g_ui.getMouseMoveMicros()
+  post = post .. '&ui_layout_solves='  .. g_ui.getLayoutSolves()
+  post = post .. '&lua_memory='        .. g_app.getLuaUsedMemory()
+  post = post .. '&file_cache_hits='   .. g_resources.getCacheHits()
+  post = post .. '&file_cache_misses=' .. g_resources.getCacheMisses()
+  post = post .. '&file_cache_bytes='  .. g_resources.getCachedBytes()
   post = post .. '&fullscreen='        .. tostring(g_window.isFullscreen())
   post = post .. '&window_width='      .. g_window.getWidth()
   post = post .. '&window_height='     .. g_window.getHeight()
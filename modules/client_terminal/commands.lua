@@ -153,6 +153,34 @@ function ls(path)
   end
 end
 
+function draw_calls_benchmark()
+  -- open every mini window, then report once the frame counters had a full second to settle
+  for _,widget in ipairs(rootWidget:recursiveGetChildren()) do
+    if widget:getClassName() == 'UIMiniWindow' and not widget:isExplicitlyVisible() then
+      widget:open(true)
+    end
+  end
+  pcolored('Measuring draw calls...')
+  scheduleEvent(function()
+    pcolored('Draw calls per frame: ' .. g_app.getDrawCallsPerFrame() .. ' at ' .. g_app.getBackgroundPaneFps() .. ' fps')
+    pcolored('Textures bound per frame: ' .. g_app.getTexturesPerFrame() .. ', ui atlas pages: ' .. g_textures.getAtlasPageCount())
+  end, 2500)
+end
+
+function particles_benchmark()
+  -- about 50k live particles for five seconds, measured once the pools are full
+  local widget = UIParticles.create()
+  rootWidget:addChild(widget)
+  widget:fill('parent')
+  widget:setPhantom(true)
+  widget:addEffect('stress-effect')
+  pcolored('Measuring particles...')
+  scheduleEvent(function()
+    pcolored('Particles: ' .. g_app.getBackgroundPaneFps() .. ' fps, ' .. g_app.getDrawCallsPerFrame() .. ' draw calls per frame')
+    widget:destroy()
+  end, 3500)
+end
+
 function about_version()
   pcolored(g_app.getName() .. ' ' .. g_app.getVersion() .. '\n' ..
         'Rev  ' .. g_app.getBuildRevision() .. ' ('.. g_app.getBuildCommit() .. ')\n' ..
@@ -0,0 +1,36 @@
+-- @docclass UIVirtualList
+
+-- rows are recycled while scrolling, onRowBind must fully refill the row it gets
+function UIVirtualList:onStyleApply(styleName, styleNode)
+  for name,value in pairs(styleNode) do
+    if name == 'vertical-scrollbar' then
+      addEvent(function()
+        local parent = self:getParent()
+        if parent then
+          self:setVerticalScrollBar(parent:getChildById(value))
+        end
+      end)
+    end
+  end
+end
+
+function UIVirtualList:setVerticalScrollBar(scrollbar)
+  self.verticalScrollBar = scrollbar
+  connect(self.verticalScrollBar, 'onValueChange', function(scrollbar, value)
+    self:setScrollOffset(value)
+  end)
+  self:updateScrollBars()
+end
+
+function UIVirtualList:updateScrollBars()
+  local scrollbar = self.verticalScrollBar
+  if scrollbar then
+    scrollbar:setMinimum(0)
+    scrollbar:setMaximum(self:getMaxScrollOffset())
+    scrollbar:setValue(self:getScrollOffset())
+  end
+end
+
+function UIVirtualList:onListAreaUpdate(scrollOffset, maxScrollOffset)
+  self:updateScrollBars()
+end
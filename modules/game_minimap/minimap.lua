@@ -4,6 +4,7 @@ minimapWindow = nil
 otmm = true
 preloaded = false
 fullmapView = false
+saveEvent = nil
 oldZoom = nil
 oldPos = nil
 
@@ -42,6 +43,8 @@ function init()
 end
 
 function terminate()
+  removeEvent(saveEvent)
+  saveEvent = nil
   if g_game.isOnline() then
     saveMap()
   end
@@ -89,9 +92,16 @@ end
 function online()
   loadMap(not preloaded)
   updateCameraPosition()
+
+  -- otmm saves only append the blocks that changed, so they are cheap enough to run periodically
+  if otmm then
+    saveEvent = cycleEvent(saveMap, 5 * 60 * 1000)
+  end
 end
 
 function offline()
+  removeEvent(saveEvent)
+  saveEvent = nil
   saveMap()
 end
 
@@ -106,6 +116,7 @@ function loadMap(clean)
     local minimapFile = '/minimap.otmm'
     if g_resources.fileExists(minimapFile) then
       g_minimap.loadOtmm(minimapFile)
+      g_logger.debug('minimap loaded in ' .. g_minimap.getLastLoadDuration() .. 'ms')
     end
   else
     local minimapFile = '/minimap_' .. clientVersion .. '.otcm'
@@ -121,6 +132,7 @@ function saveMap()
   if otmm then
     local minimapFile = '/minimap.otmm'
     g_minimap.saveOtmm(minimapFile)
+    g_logger.debug('minimap saved in ' .. g_minimap.getLastSaveDuration() .. 'ms')
   else
     local minimapFile = '/minimap_' .. clientVersion .. '.otcm'
     g_map.saveOtcm(minimapFile)
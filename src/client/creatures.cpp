@@ -25,10 +25,184 @@
 #include "map.h"
 
 #include <framework/xml/tinyxml.h>
+#include <framework/xml/xmlreader.h>
+#include <framework/xml/xmlcache.h>
 #include <framework/core/resourcemanager.h>
+#include <framework/core/filestream.h>
 
 CreatureManager g_creatures;
 
+enum {
+    CREATURES_CACHE_VERSION = 1,
+    SPAWNS_CACHE_VERSION = 1
+};
+
+struct CreatureXmlData {
+    std::string name;
+    int32 type;
+    int32 typeEx;
+    int head;
+    int body;
+    int legs;
+    int feet;
+    int addons;
+    int mount;
+};
+
+struct SpawnCreatureXmlData {
+    std::string name;
+    int32 spawnTime;
+    int16 direction;
+    int32 x;
+    int32 y;
+    int32 z;
+    bool npc;
+};
+
+struct SpawnXmlData {
+    Position centerPos;
+    int32 radius;
+    std::vector<SpawnCreatureXmlData> creatures;
+};
+
+static std::string normalizeCreatureName(std::string name)
+{
+    stdext::tolower(name);
+    stdext::trim(name);
+    stdext::ucwords(name);
+    return name;
+}
+
+// only the look of a creature is used, the rest of the file is not read
+static bool readCreatureXml(const std::string& buffer, CreatureXmlData& data)
+{
+    XmlReader reader(buffer);
+    if(!reader.next() || reader.token() != XmlReader::StartElement || (reader.name() != "monster" && reader.name() != "npc"))
+        stdext::throw_exception("invalid root tag name");
+
+    data.name = normalizeCreatureName(reader.attribute("name"));
+    while(reader.next()) {
+        if(reader.token() != XmlReader::StartElement || reader.depth() != 1 || reader.name() != "look")
+            continue;
+
+        data.type = reader.readType<int32>("type");
+        data.typeEx = reader.readType<int32>("typeex");
+        data.head = reader.readType<int>("head");
+        data.body = reader.readType<int>("body");
+        data.legs = reader.readType<int>("legs");
+        data.feet = reader.readType<int>("feet");
+        data.addons = reader.readType<int>("addons");
+        data.mount = reader.readType<int>("mount");
+        return true;
+    }
+    return false;
+}
+
+static void serializeCreatureXml(const FileStreamPtr& fout, const CreatureXmlData& data)
+{
+    fout->addString(data.name);
+    fout->add32(data.type);
+    fout->add32(data.typeEx);
+    fout->add32(data.head);
+    fout->add32(data.body);
+    fout->add32(data.legs);
+    fout->add32(data.feet);
+    fout->add32(data.addons);
+    fout->add32(data.mount);
+}
+
+static void unserializeCreatureXml(const FileStreamPtr& fin, CreatureXmlData& data)
+{
+    data.name = fin->getString();
+    data.type = fin->get32();
+    data.typeEx = fin->get32();
+    data.head = fin->get32();
+    data.body = fin->get32();
+    data.legs = fin->get32();
+    data.feet = fin->get32();
+    data.addons = fin->get32();
+    data.mount = fin->get32();
+}
+
+static void readSpawnsXml(const std::string& buffer, std::vector<SpawnXmlData>& spawns)
+{
+    XmlReader reader(buffer);
+    if(!reader.next() || reader.token() != XmlReader::StartElement || reader.name() != "spawns")
+        stdext::throw_exception("malformed spawns file");
+
+    while(reader.next()) {
+        if(reader.token() != XmlReader::StartElement)
+            continue;
+
+        if(reader.depth() == 1) {
+            if(reader.name() != "spawn")
+                stdext::throw_exception("invalid spawn node");
+
+            spawns.push_back(SpawnXmlData());
+            SpawnXmlData& spawn = spawns.back();
+            spawn.centerPos.x = reader.readType<int>("centerx");
+            spawn.centerPos.y = reader.readType<int>("centery");
+            spawn.centerPos.z = reader.readType<int>("centerz");
+            spawn.radius = reader.readType<int32>("radius");
+        } else if(reader.depth() == 2) {
+            if(reader.name() != "monster" && reader.name() != "npc")
+                stdext::throw_exception(stdext::format("invalid spawn-subnode %s", reader.name()));
+
+            SpawnCreatureXmlData creature;
+            creature.name = normalizeCreatureName(reader.attribute("name"));
+            creature.spawnTime = reader.readType<int32>("spawntime");
+            creature.direction = reader.readType<int16>("direction");
+            creature.x = reader.readType<int32>("x");
+            creature.y = reader.readType<int32>("y");
+            creature.z = reader.readType<int32>("z");
+            creature.npc = reader.name() == "npc";
+            spawns.back().creatures.push_back(creature);
+        }
+    }
+}
+
+static void serializeSpawnsXml(const FileStreamPtr& fout, const std::vector<SpawnXmlData>& spawns)
+{
+    fout->addU32(spawns.size());
+    for(const SpawnXmlData& spawn : spawns) {
+        fout->addU16(spawn.centerPos.x);
+        fout->addU16(spawn.centerPos.y);
+        fout->addU8(spawn.centerPos.z);
+        fout->add32(spawn.radius);
+        fout->addU32(spawn.creatures.size());
+        for(const SpawnCreatureXmlData& creature : spawn.creatures) {
+            fout->addString(creature.name);
+            fout->add32(creature.spawnTime);
+            fout->add16(creature.direction);
+            fout->add32(creature.x);
+            fout->add32(creature.y);
+            fout->add32(creature.z);
+            fout->addU8(creature.npc);
+        }
+    }
+}
+
+static void unserializeSpawnsXml(const FileStreamPtr& fin, std::vector<SpawnXmlData>& spawns)
+{
+    spawns.resize(fin->getU32());
+    for(SpawnXmlData& spawn : spawns) {
+        spawn.centerPos.x = fin->getU16();
+        spawn.centerPos.y = fin->getU16();
+        spawn.centerPos.z = fin->getU8();
+        spawn.radius = fin->get32();
+        spawn.creatures.resize(fin->getU32());
+        for(SpawnCreatureXmlData& creature : spawn.creatures) {
+            creature.name = fin->getString();
+            creature.spawnTime = fin->get32();
+            creature.direction = fin->get16();
+            creature.x = fin->get32();
+            creature.y = fin->get32();
+            creature.z = fin->get32();
+            creature.npc = fin->getU8() != 0;
+        }
+    }
+}
+
 static bool isInZone(const Position& pos/* placePos*/,
                      const Position& centerPos,
                      int radius)
@@ -47,42 +221,29 @@ void CreatureManager::terminate()
     m_nullCreature = nullptr;
 }
 
-void Spawn::load(TiXmlElement* node)
+void Spawn::load(const SpawnXmlData& data)
 {
-    Position centerPos;
-    centerPos.x = node->readType<int>("centerx");
-    centerPos.y = node->readType<int>("centery");
-    centerPos.z = node->readType<int>("centerz");
-
+    const Position& centerPos = data.centerPos;
     setCenterPos(centerPos);
-    setRadius(node->readType<int32>("radius"));
-
-    CreatureTypePtr cType(nullptr);
-    for(TiXmlElement* cNode = node->FirstChildElement(); cNode; cNode = cNode->NextSiblingElement()) {
-        if(cNode->ValueStr() != "monster" && cNode->ValueStr() != "npc")
-            stdext::throw_exception(stdext::format("invalid spawn-subnode %s", cNode->ValueStr()));
-
-        std::string cName = cNode->Attribute("name");
-        stdext::tolower(cName);
-        stdext::trim(cName);
-        stdext::ucwords(cName);
+    setRadius(data.radius);
 
-        if (!(cType = g_creatures.getCreatureByName(cName)))
+    for(const SpawnCreatureXmlData& creature : data.creatures) {
+        CreatureTypePtr cType = g_creatures.getCreatureByName(creature.name);
+        if(!cType)
             continue;
 
-        cType->setSpawnTime(cNode->readType<int>("spawntime"));
+        cType->setSpawnTime(creature.spawnTime);
         Otc::Direction dir = Otc::North;
-        int16 dir_ = cNode->readType<int16>("direction");
-        if(dir_ >= Otc::East && dir_ <= Otc::West)
-            dir = (Otc::Direction)dir_;
+        if(creature.direction >= Otc::East && creature.direction <= Otc::West)
+            dir = (Otc::Direction)creature.direction;
         cType->setDirection(dir);
 
         Position placePos;
-        placePos.x = centerPos.x + cNode->readType<int>("x");
-        placePos.y = centerPos.y + cNode->readType<int>("y");
-        placePos.z = cNode->readType<int>("z");
+        placePos.x = centerPos.x + creature.x;
+        placePos.y = centerPos.y + creature.y;
+        placePos.z = creature.z;
 
-        cType->setRace(cNode->ValueStr() == "npc" ? CreatureRaceNpc : CreatureRaceMonster);
+        cType->setRace(creature.npc ? CreatureRaceNpc : CreatureRaceMonster);
         addCreature(placePos, cType);
     }
 }
@@ -181,24 +342,39 @@ void CreatureManager::clearSpawns()
 
 void CreatureManager::loadMonsters(const std::string& file)
 {
-    TiXmlDocument doc;
-    doc.Parse(g_resources.readFileContents(file).c_str());
-    if(doc.Error())
-        stdext::throw_exception(stdext::format("cannot open monsters file '%s': '%s'", file, doc.ErrorDesc()));
+    stdext::timer loadTimer;
 
-    TiXmlElement* root = doc.FirstChildElement();
-    if(!root || root->ValueStr() != "monsters")
+    XmlReader reader(g_resources.readFileContents(file));
+    if(!reader.next() || reader.token() != XmlReader::StartElement || reader.name() != "monsters")
         stdext::throw_exception("malformed monsters xml file");
 
-    for(TiXmlElement* monster = root->FirstChildElement(); monster; monster = monster->NextSiblingElement()) {
-        std::string fname = file.substr(0, file.find_last_of('/')) + '/' + monster->Attribute("file");
+    // the cache is only valid while none of the listed files changed
+    std::vector<std::string> files(1, file);
+    while(reader.next()) {
+        if(reader.token() != XmlReader::StartElement || reader.depth() != 1)
+            continue;
+
+        std::string fname = file.substr(0, file.find_last_of('/')) + '/' + reader.attribute("file");
         if(fname.substr(fname.length() - 4) != ".xml")
             fname += ".xml";
+        files.push_back(fname);
+    }
 
-        loadSingleCreature(fname);
+    bool cached = loadCreaturesCache("/xmlcache/monsters.otxc", files);
+    if(!cached) {
+        std::vector<CreatureXmlData> creatures;
+        for(uint i = 1; i < files.size(); ++i) {
+            CreatureXmlData data;
+            if(readCreatureXml(g_resources.readFileContents(files[i]), data))
+                creatures.push_back(data);
+        }
+        saveCreaturesCache("/xmlcache/monsters.otxc", files, creatures);
+
+        for(const CreatureXmlData& data : creatures)
+            internalLoadCreatureBuffer(data);
     }
 
-    doc.Clear();
+    g_logger.debug(stdext::format("Loaded monsters '%s' in %d ms (%s)", file, (int)loadTimer.elapsed_millis(), cached ? "cached" : "parsed"));
     m_loaded = true;
 }
 
@@ -216,9 +392,65 @@ void CreatureManager::loadNpcs(const std::string& folder)
     if(!g_resources.directoryExists(tmp))
         stdext::throw_exception(stdext::format("NPCs folder '%s' was not found.", folder));
 
-    const auto& fileList = g_resources.listDirectoryFiles(tmp);
-    for(const std::string& file : fileList)
-        loadCreatureBuffer(g_resources.readFileContents(tmp + file));
+    stdext::timer loadTimer;
+
+    std::vector<std::string> files;
+    for(const std::string& file : g_resources.listDirectoryFiles(tmp))
+        files.push_back(tmp + file);
+
+    bool cached = loadCreaturesCache("/xmlcache/npcs.otxc", files);
+    if(!cached) {
+        std::vector<CreatureXmlData> creatures;
+        for(const std::string& file : files) {
+            CreatureXmlData data;
+            if(readCreatureXml(g_resources.readFileContents(file), data))
+                creatures.push_back(data);
+        }
+        saveCreaturesCache("/xmlcache/npcs.otxc", files, creatures);
+
+        for(const CreatureXmlData& data : creatures)
+            internalLoadCreatureBuffer(data);
+    }
+
+    g_logger.debug(stdext::format("Loaded npcs '%s' in %d ms (%s)", folder, (int)loadTimer.elapsed_millis(), cached ? "cached" : "parsed"));
+}
+
+bool CreatureManager::loadCreaturesCache(const std::string& cacheFile, const std::vector<std::string>& files)
+{
+    FileStreamPtr fin = XmlCache::open(cacheFile, files, CREATURES_CACHE_VERSION);
+    if(!fin)
+        return false;
+
+    std::vector<CreatureXmlData> creatures;
+    try {
+        creatures.resize(fin->getU32());
+        for(CreatureXmlData& data : creatures)
+            unserializeCreatureXml(fin, data);
+    } catch(stdext::exception& e) {
+        g_logger.debug(stdext::format("Discarding creatures cache '%s': %s", cacheFile, e.what()));
+        return false;
+    }
+
+    for(const CreatureXmlData& data : creatures)
+        internalLoadCreatureBuffer(data);
+    return true;
+}
+
+void CreatureManager::saveCreaturesCache(const std::string& cacheFile, const std::vector<std::string>& files, const std::vector<CreatureXmlData>& creatures)
+{
+    FileStreamPtr fout = XmlCache::create(cacheFile, files, CREATURES_CACHE_VERSION);
+    if(!fout)
+        return;
+
+    try {
+        fout->addU32(creatures.size());
+        for(const CreatureXmlData& data : creatures)
+            serializeCreatureXml(fout, data);
+        fout->flush();
+        fout->close();
+    } catch(stdext::exception& e) {
+        g_logger.debug(stdext::format("Unable to save creatures cache '%s': %s", cacheFile, e.what()));
+    }
 }
 
 void CreatureManager::loadSpawns(const std::string& fileName)
@@ -234,24 +466,37 @@ void CreatureManager::loadSpawns(const std::string& fileName)
     }
 
     try {
-        TiXmlDocument doc;
-        doc.Parse(g_resources.readFileContents(fileName).c_str());
-        if(doc.Error())
-            stdext::throw_exception(stdext::format("cannot load spawns xml file '%s: '%s'", fileName, doc.ErrorDesc()));
-
-        TiXmlElement* root = doc.FirstChildElement();
-        if(!root || root->ValueStr() != "spawns")
-            stdext::throw_exception("malformed spawns file");
+        stdext::timer loadTimer;
+
+        std::vector<std::string> files(1, fileName);
+        std::vector<SpawnXmlData> spawns;
+        bool cached = false;
+        if(FileStreamPtr fin = XmlCache::open("/xmlcache/spawns.otxc", files, SPAWNS_CACHE_VERSION)) {
+            try {
+                unserializeSpawnsXml(fin, spawns);
+                cached = true;
+            } catch(stdext::exception& e) {
+                g_logger.debug(stdext::format("Discarding spawns cache: %s", e.what()));
+                spawns.clear();
+            }
+        }
 
-        for(TiXmlElement* node = root->FirstChildElement(); node; node = node->NextSiblingElement()) {
-            if(node->ValueTStr() != "spawn")
-                stdext::throw_exception("invalid spawn node");
+        if(!cached) {
+            readSpawnsXml(g_resources.readFileContents(fileName), spawns);
+            if(FileStreamPtr fout = XmlCache::create("/xmlcache/spawns.otxc", files, SPAWNS_CACHE_VERSION)) {
+                serializeSpawnsXml(fout, spawns);
+                fout->flush();
+                fout->close();
+            }
+        }
 
+        for(const SpawnXmlData& data : spawns) {
             SpawnPtr spawn(new Spawn);
-            spawn->load(node);
+            spawn->load(data);
             m_spawns.insert(std::make_pair(spawn->getCenterPos(), spawn));
         }
-        doc.Clear();
+
+        g_logger.debug(stdext::format("Loaded spawns '%s' in %d ms (%s)", fileName, (int)loadTimer.elapsed_millis(), cached ? "cached" : "parsed"));
         m_spawnLoaded = true;
     } catch(std::exception& e) {
         g_logger.error(stdext::format("Failed to load '%s': %s", fileName, e.what()));
@@ -285,70 +530,42 @@ void CreatureManager::saveSpawns(const std::string& fileName)
 
 void CreatureManager::loadCreatureBuffer(const std::string& buffer)
 {
-    TiXmlDocument doc;
-    doc.Parse(buffer.c_str());
-    if(doc.Error())
-        stdext::throw_exception(stdext::format("cannot load creature buffer: %s", doc.ErrorDesc()));
-
-    TiXmlElement* root = doc.FirstChildElement();
-    if(!root || (root->ValueStr() != "monster" && root->ValueStr() != "npc"))
-        stdext::throw_exception("invalid root tag name");
-
-    std::string cName = root->Attribute("name");
-    stdext::tolower(cName);
-    stdext::trim(cName);
-    stdext::ucwords(cName);
-
-    CreatureTypePtr newType(new CreatureType(cName));
-    for(TiXmlElement* attrib = root->FirstChildElement(); attrib; attrib = attrib->NextSiblingElement()) {
-        if(attrib->ValueStr() != "look")
-            continue;
-
-        internalLoadCreatureBuffer(attrib, newType);
-        break;
-    }
-
-    doc.Clear();
+    CreatureXmlData data;
+    if(readCreatureXml(buffer, data))
+        internalLoadCreatureBuffer(data);
 }
 
-void CreatureManager::internalLoadCreatureBuffer(TiXmlElement* attrib, const CreatureTypePtr& m)
+void CreatureManager::internalLoadCreatureBuffer(const CreatureXmlData& data)
 {
-    if(std::find(m_creatures.begin(), m_creatures.end(), m) != m_creatures.end())
-        return;
+    CreatureTypePtr m(new CreatureType(data.name));
 
     Outfit out;
-
-    int32 type = attrib->readType<int32>("type");
-    if(type > 0) {
+    if(data.type > 0) {
         out.setCategory(ThingCategoryCreature);
-        out.setId(type);
+        out.setId(data.type);
     } else {
         out.setCategory(ThingCategoryItem);
-        out.setAuxId(attrib->readType<int32>("typeex"));
+        out.setAuxId(data.typeEx);
     }
 
-    {
-        out.setHead(attrib->readType<int>(("head")));
-        out.setBody(attrib->readType<int>(("body")));
-        out.setLegs(attrib->readType<int>(("legs")));
-        out.setFeet(attrib->readType<int>(("feet")));
-        out.setAddons(attrib->readType<int>(("addons")));
-        out.setMount(attrib->readType<int>(("mount")));
-    }
+    out.setHead(data.head);
+    out.setBody(data.body);
+    out.setLegs(data.legs);
+    out.setFeet(data.feet);
+    out.setAddons(data.addons);
+    out.setMount(data.mount);
 
     m->setOutfit(out);
     m_creatures.push_back(m);
+    m_creaturesByName.insert(std::make_pair(data.name, m));
 }
 
 const CreatureTypePtr& CreatureManager::getCreatureByName(std::string name)
 {
-    stdext::tolower(name);
-    stdext::trim(name);
-    stdext::ucwords(name);
-    auto it = std::find_if(m_creatures.begin(), m_creatures.end(),
-                           [=] (const CreatureTypePtr& m) -> bool { return m->getName() == name; });
-    if(it != m_creatures.end())
-        return *it;
+    name = normalizeCreatureName(name);
+    auto it = m_creaturesByName.find(name);
+    if(it != m_creaturesByName.end())
+        return it->second;
     g_logger.warning(stdext::format("could not find creature with name: %s", name));
     return m_nullCreature;
 }
@@ -49,6 +49,9 @@ enum SpawnAttr : uint8
     SpawnAttrCenter  = 1,
 };
 
+struct SpawnXmlData;
+struct CreatureXmlData;
+
 class Spawn : public LuaObject
 {
 public:
@@ -67,7 +70,7 @@ public:
     void clear() { m_creatures.clear(); }
 
 protected:
-    void load(TiXmlElement* node);
+    void load(const SpawnXmlData& data);
     void save(TiXmlElement* node);
 
 private:
@@ -107,7 +110,7 @@ class CreatureManager
 {
 public:
     CreatureManager();
-    void clear() { m_creatures.clear(); }
+    void clear() { m_creatures.clear(); m_creaturesByName.clear(); }
     void clearSpawns();
     void terminate();
 
@@ -133,10 +136,14 @@ public:
     const std::vector<CreatureTypePtr>& getCreatures() { return m_creatures; }
 
 protected:
-    void internalLoadCreatureBuffer(TiXmlElement* elem, const CreatureTypePtr& m);
+    void internalLoadCreatureBuffer(const CreatureXmlData& data);
 
 private:
+    bool loadCreaturesCache(const std::string& cacheFile, const std::vector<std::string>& files);
+    void saveCreaturesCache(const std::string& cacheFile, const std::vector<std::string>& files, const std::vector<CreatureXmlData>& creatures);
+
     std::vector<CreatureTypePtr> m_creatures;
+    std::unordered_map<std::string, CreatureTypePtr> m_creaturesByName;
     std::unordered_map<Position, SpawnPtr, PositionHasher> m_spawns;
     stdext::boolean<false> m_loaded, m_spawnLoaded;
     CreatureTypePtr m_nullCreature;
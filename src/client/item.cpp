@@ -102,7 +102,8 @@ void Item::setOtbId(uint16 id)
 {
     if(!g_things.isValidOtbId(id))
         id = 0;
-    auto itemType = g_things.getItemType(id);
+    // raw access because the map loader creates items on worker threads
+    ItemType *itemType = g_things.rawGetItemType(id);
     m_serverId = id;
 
     id = itemType->getClientId();
@@ -116,69 +117,65 @@ bool Item::isValid()
     return g_things.isValidDatId(m_clientId, ThingCategoryItem);
 }
 
-void Item::unserializeItem(const BinaryTreePtr &in)
+void Item::unserializeItem(BinaryTreeReader& in)
 {
-    try {
-        while(in->canRead()) {
-            int attrib = in->getU8();
-            if(attrib == 0)
+    while(in.canRead()) {
+        int attrib = in.getU8();
+        if(attrib == 0)
+            break;
+
+        switch(attrib) {
+            case ATTR_COUNT:
+            case ATTR_RUNE_CHARGES:
+                setCount(in.getU8());
+                break;
+            case ATTR_CHARGES:
+                setCount(in.getU16());
+                break;
+            case ATTR_HOUSEDOORID:
+            case ATTR_SCRIPTPROTECTED:
+            case ATTR_DUALWIELD:
+            case ATTR_DECAYING_STATE:
+                m_attribs.set(attrib, in.getU8());
+                break;
+            case ATTR_ACTION_ID:
+            case ATTR_UNIQUE_ID:
+            case ATTR_DEPOT_ID:
+                m_attribs.set(attrib, in.getU16());
+                break;
+            case ATTR_CONTAINER_ITEMS:
+            case ATTR_ATTACK:
+            case ATTR_EXTRAATTACK:
+            case ATTR_DEFENSE:
+            case ATTR_EXTRADEFENSE:
+            case ATTR_ARMOR:
+            case ATTR_ATTACKSPEED:
+            case ATTR_HITCHANCE:
+            case ATTR_DURATION:
+            case ATTR_WRITTENDATE:
+            case ATTR_SLEEPERGUID:
+            case ATTR_SLEEPSTART:
+            case ATTR_ATTRIBUTE_MAP:
+                m_attribs.set(attrib, in.getU32());
+                break;
+            case ATTR_TELE_DEST: {
+                Position pos;
+                pos.x = in.getU16();
+                pos.y = in.getU16();
+                pos.z = in.getU8();
+                m_attribs.set(attrib, pos);
                 break;
-
-            switch(attrib) {
-                case ATTR_COUNT:
-                case ATTR_RUNE_CHARGES:
-                    setCount(in->getU8());
-                    break;
-                case ATTR_CHARGES:
-                    setCount(in->getU16());
-                    break;
-                case ATTR_HOUSEDOORID:
-                case ATTR_SCRIPTPROTECTED:
-                case ATTR_DUALWIELD:
-                case ATTR_DECAYING_STATE:
-                    m_attribs.set(attrib, in->getU8());
-                    break;
-                case ATTR_ACTION_ID:
-                case ATTR_UNIQUE_ID:
-                case ATTR_DEPOT_ID:
-                    m_attribs.set(attrib, in->getU16());
-                    break;
-                case ATTR_CONTAINER_ITEMS:
-                case ATTR_ATTACK:
-                case ATTR_EXTRAATTACK:
-                case ATTR_DEFENSE:
-                case ATTR_EXTRADEFENSE:
-                case ATTR_ARMOR:
-                case ATTR_ATTACKSPEED:
-                case ATTR_HITCHANCE:
-                case ATTR_DURATION:
-                case ATTR_WRITTENDATE:
-                case ATTR_SLEEPERGUID:
-                case ATTR_SLEEPSTART:
-                case ATTR_ATTRIBUTE_MAP:
-                    m_attribs.set(attrib, in->getU32());
-                    break;
-                case ATTR_TELE_DEST: {
-                    Position pos;
-                    pos.x = in->getU16();
-                    pos.y = in->getU16();
-                    pos.z = in->getU8();
-                    m_attribs.set(attrib, pos);
-                    break;
-                }
-                case ATTR_NAME:
-                case ATTR_TEXT:
-                case ATTR_DESC:
-                case ATTR_ARTICLE:
-                case ATTR_WRITTENBY:
-                    m_attribs.set(attrib, in->getString());
-                    break;
-                default:
-                    stdext::throw_exception(stdext::format("invalid item attribute %d", attrib));
             }
+            case ATTR_NAME:
+            case ATTR_TEXT:
+            case ATTR_DESC:
+            case ATTR_ARTICLE:
+            case ATTR_WRITTENBY:
+                m_attribs.set(attrib, in.getString());
+                break;
+            default:
+                stdext::throw_exception(stdext::format("invalid item attribute %d", attrib));
         }
-    } catch(stdext::exception& e) {
-        g_logger.error(stdext::format("Failed to unserialize OTBM item: %s", e.what()));
     }
 }
 
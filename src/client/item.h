@@ -100,7 +100,8 @@ public:
     std::string getName();
     bool isValid();
 
-    void unserializeItem(const BinaryTreePtr& in);
+    /// Reads OTBM item attributes, throws on invalid data
+    void unserializeItem(BinaryTreeReader& in);
     void serializeItem(const OutputBinaryTreePtr& out);
 
     void setDepotId(uint16 depotId) { m_attribs.set(ATTR_DEPOT_ID, depotId); }
@@ -33,24 +33,24 @@ ItemType::ItemType()
     m_category = ItemCategoryInvalid;
 }
 
-void ItemType::unserialize(const BinaryTreePtr& node)
+void ItemType::unserialize(BinaryTreeReader& node)
 {
     m_null = false;
 
-    m_category = (ItemCategory)node->getU8();
+    m_category = (ItemCategory)node.getU8();
 
-    node->getU32(); // flags
+    node.getU32(); // flags
 
     static uint16 lastId = 99;
-    while(node->canRead()) {
-        uint8 attr = node->getU8();
+    while(node.canRead()) {
+        uint8 attr = node.getU8();
         if(attr == 0 || attr == 0xFF)
             break;
 
-        uint16 len = node->getU16();
+        uint16 len = node.getU16();
         switch(attr) {
             case ItemTypeAttrServerId: {
-                uint16 serverId = node->getU16();
+                uint16 serverId = node.getU16();
                 if(g_game.getClientVersion() < 960) {
                     if(serverId > 20000 && serverId < 20100) {
                         serverId -= 20000;
@@ -77,16 +77,16 @@ void ItemType::unserialize(const BinaryTreePtr& node)
                 break;
             }
             case ItemTypeAttrClientId:
-                setClientId(node->getU16());
+                setClientId(node.getU16());
                 break;
             case ItemTypeAttrName:
-                setName(node->getString(len));
+                setName(node.getString(len));
                 break;
             case ItemTypeAttrWritable:
                 m_attribs.set(ItemTypeAttrWritable, true);
                 break;
             default:
-                node->skip(len); // skip attribute
+                node.skip(len); // skip attribute
                 break;
         }
     }
@@ -32,6 +32,7 @@
 
 #include <framework/core/eventdispatcher.h>
 #include <framework/core/application.h>
+#include <framework/core/filestream.h>
 
 Map g_map;
 TilePtr Map::m_nulltile;
@@ -40,6 +41,7 @@ void Map::init()
 {
     resetAwareRange();
     m_animationFlags |= Animation_Show;
+    m_otcmCenterBlock = 0xFFFFFFFF;
 }
 
 void Map::terminate()
@@ -73,8 +75,12 @@ void Map::clean()
 {
     cleanDynamicThings();
 
-    for(int i=0;i<=Otc::MAX_Z;++i)
+    for(int i=0;i<=Otc::MAX_Z;++i) {
         m_tileBlocks[i].clear();
+        m_otcmBlocks[i].clear();
+    }
+    m_otcmFile = nullptr;
+    m_otcmCenterBlock = 0xFFFFFFFF;
 
     m_waypoints.clear();
 
@@ -538,6 +544,10 @@ void Map::setCentralPosition(const Position& centralPosition)
 
     m_centralPosition = centralPosition;
 
+    // page in cached blocks around the camera whenever it crosses into another block
+    if(m_otcmFile && getBlockIndex(centralPosition) != m_otcmCenterBlock)
+        loadOtcmBlocks(centralPosition);
+
     removeUnawareThings();
 
     // this fixes local player position when the local player is removed from the map,
@@ -86,7 +86,9 @@ enum OTBM_NodeTypes_t
 
 enum {
     OTCM_SIGNATURE = 0x4D43544F,
-    OTCM_VERSION = 1
+    OTCM_VERSION = 2,
+    OTCM_FLAG_ZLIB = 1,
+    OTCM_LOAD_RADIUS = 8 // blocks around the central position paged in from a v2 cache
 };
 
 enum {
@@ -135,6 +137,14 @@ struct AwareRange
     int vertical() { return top + bottom + 1; }
 };
 
+struct OtbmArea;
+
+struct OtcmBlock {
+    uint32 offset;
+    uint32 size;
+    uint32 rawSize;
+};
+
 //@bindsingleton g_map
 class Map
 {
@@ -245,9 +255,17 @@ public:
 
 private:
     void removeUnawareThings();
+    void mergeOtbmArea(OtbmArea& area);
+    void readOtcmTiles(const FileStreamPtr& fin, bool replace);
+    void loadOtcmBlock(const OtcmBlock& block);
+    void loadOtcmBlocks(const Position& center);
+    void loadAllOtcmBlocks();
     uint getBlockIndex(const Position& pos) { return ((pos.y / BLOCK_SIZE) * (65536 / BLOCK_SIZE)) + (pos.x / BLOCK_SIZE); }
 
     std::unordered_map<uint, TileBlock> m_tileBlocks[Otc::MAX_Z+1];
+    std::unordered_map<uint, OtcmBlock> m_otcmBlocks[Otc::MAX_Z+1];
+    FileStreamPtr m_otcmFile;
+    uint m_otcmCenterBlock;
     std::unordered_map<uint32, CreaturePtr> m_knownCreatures;
     std::array<std::vector<MissilePtr>, Otc::MAX_Z+1> m_floorMissiles;
     std::vector<AnimatedTextPtr> m_animatedTexts;
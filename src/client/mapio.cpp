@@ -29,9 +29,167 @@
 #include <framework/core/resourcemanager.h>
 #include <framework/core/filestream.h>
 #include <framework/core/binarytree.h>
+#include <framework/core/asyncdispatcher.h>
+#include <framework/luaengine/luainterface.h>
 #include <framework/xml/tinyxml.h>
 #include <framework/ui/uiwidget.h>
 
+#include <zlib.h>
+
+struct OtbmItem {
+    ItemPtr item;
+    bool inHouseCheck;
+};
+
+struct OtbmTile {
+    Position pos;
+    uint32 flags;
+    uint32 houseId;
+    bool isHouse;
+    std::vector<OtbmItem> items;
+};
+
+/// Tiles of one OTBM_TILE_AREA decoded by a worker, errors are reported when merging
+struct OtbmArea {
+    std::vector<OtbmTile> tiles;
+    std::vector<std::string> warnings;
+    std::string error;
+};
+
+enum {
+    OTBM_AREAS_PER_TASK = 16
+};
+
+// runs on worker threads, so it must not log nor touch anything but the area
+static void loadOtbmArea(const uint8 *data, uint size, uint pos, OtbmArea& area)
+{
+    try {
+        BinaryTreeReader in(data, size, pos);
+        in.getU8(); // OTBM_TILE_AREA
+
+        Position basePos;
+        basePos.x = in.getU16();
+        basePos.y = in.getU16();
+        basePos.z = in.getU8();
+
+        while(in.enterChild()) {
+            uint8 type = in.getU8();
+            if(unlikely(type != OTBM_TILE && type != OTBM_HOUSETILE))
+                stdext::throw_exception(stdext::format("invalid node tile type %d", (int)type));
+
+            area.tiles.push_back(OtbmTile());
+            OtbmTile& tile = area.tiles.back();
+            tile.flags = TILESTATE_NONE;
+            tile.pos = basePos + in.getPoint();
+            tile.isHouse = type == OTBM_HOUSETILE;
+            tile.houseId = tile.isHouse ? in.getU32() : 0;
+
+            while(in.canRead()) {
+                uint8 tileAttr = in.getU8();
+                switch(tileAttr) {
+                    case OTBM_ATTR_TILE_FLAGS: {
+                        uint32 _flags = in.getU32();
+                        if((_flags & TILESTATE_PROTECTIONZONE) == TILESTATE_PROTECTIONZONE)
+                            tile.flags |= TILESTATE_PROTECTIONZONE;
+                        else if((_flags & TILESTATE_OPTIONALZONE) == TILESTATE_OPTIONALZONE)
+                            tile.flags |= TILESTATE_OPTIONALZONE;
+                        else if((_flags & TILESTATE_HARDCOREZONE) == TILESTATE_HARDCOREZONE)
+                            tile.flags |= TILESTATE_HARDCOREZONE;
+
+                        if((_flags & TILESTATE_NOLOGOUT) == TILESTATE_NOLOGOUT)
+                            tile.flags |= TILESTATE_NOLOGOUT;
+
+                        if((_flags & TILESTATE_REFRESH) == TILESTATE_REFRESH)
+                            tile.flags |= TILESTATE_REFRESH;
+                        break;
+                    }
+                    case OTBM_ATTR_ITEM: {
+                        OtbmItem item = { Item::createFromOtb(in.getU16()), false };
+                        tile.items.push_back(item);
+                        break;
+                    }
+                    default: {
+                        stdext::throw_exception(stdext::format("invalid tile attribute %d at pos %s",
+                                                           (int)tileAttr, stdext::to_string(tile.pos)));
+                    }
+                }
+            }
+
+            while(in.enterChild()) {
+                if(unlikely(in.getU8() != OTBM_ITEM))
+                    stdext::throw_exception("invalid item node");
+
+                ItemPtr item = Item::createFromOtb(in.getU16());
+                try {
+                    item->unserializeItem(in);
+                } catch(stdext::exception& e) {
+                    area.warnings.push_back(stdext::format("Failed to unserialize OTBM item: %s", e.what()));
+                }
+
+                if(item->isContainer()) {
+                    while(in.enterChild()) {
+                        if(in.getU8() != OTBM_ITEM)
+                            stdext::throw_exception("invalid container item node");
+
+                        ItemPtr cItem = Item::createFromOtb(in.getU16());
+                        try {
+                            cItem->unserializeItem(in);
+                        } catch(stdext::exception& e) {
+                            area.warnings.push_back(stdext::format("Failed to unserialize OTBM item: %s", e.what()));
+                        }
+                        item->addContainerItem(cItem);
+                        in.leaveNode();
+                    }
+                }
+                in.leaveNode();
+
+                OtbmItem tileItem = { item, true };
+                tile.items.push_back(tileItem);
+            }
+            in.leaveNode();
+        }
+    } catch(std::exception& e) {
+        area.error = e.what();
+    }
+}
+
+void Map::mergeOtbmArea(OtbmArea& area)
+{
+    for(const std::string& warning : area.warnings)
+        g_logger.error(warning);
+
+    for(OtbmTile& otbmTile : area.tiles) {
+        HousePtr house = nullptr;
+        if(otbmTile.isHouse) {
+            TilePtr tile = getOrCreateTile(otbmTile.pos);
+            if(!(house = g_houses.getHouse(otbmTile.houseId))) {
+                house = HousePtr(new House(otbmTile.houseId));
+                g_houses.addHouse(house);
+            }
+            house->setTile(tile);
+        }
+
+        for(OtbmItem& otbmItem : otbmTile.items) {
+            ItemPtr item = otbmItem.item;
+            if(otbmItem.inHouseCheck && house && item->isMoveable()) {
+                g_logger.warning(stdext::format("Moveable item found in house: %d at pos %s - escaping...", item->getId(), stdext::to_string(otbmTile.pos)));
+                item.reset();
+            }
+            addThing(item, otbmTile.pos);
+        }
+
+        if(const TilePtr& tile = getTile(otbmTile.pos)) {
+            if(house)
+                tile->setFlag(TILESTATE_HOUSE);
+            tile->setFlag(otbmTile.flags);
+        }
+    }
+
+    // tiles decoded before an error were loaded like a serial load would
+    if(!area.error.empty())
+        stdext::throw_exception(area.error);
+}
+
 void Map::loadOtbm(const std::string& fileName)
 {
     try {
@@ -50,37 +208,36 @@ void Map::loadOtbm(const std::string& fileName)
         if(memcmp(identifier, "OTBM", 4) != 0 && memcmp(identifier, "\0\0\0\0", 4) != 0)
             stdext::throw_exception(stdext::format("Invalid file identifier detected: %s", identifier));
 
-        BinaryTreePtr root = fin->getBinaryTree();
-        if(root->getU8())
+        BinaryTreeReader in(fin);
+        if(in.getU8())
             stdext::throw_exception("could not read root property!");
 
-        uint32 headerVersion = root->getU32();
+        uint32 headerVersion = in.getU32();
         if(headerVersion > 3)
             stdext::throw_exception(stdext::format("Unknown OTBM version detected: %u.", headerVersion));
 
-        setWidth(root->getU16());
-        setHeight(root->getU16());
+        setWidth(in.getU16());
+        setHeight(in.getU16());
 
-        uint32 headerMajorItems = root->getU8();
+        uint32 headerMajorItems = in.getU8();
         if(headerMajorItems > g_things.getOtbMajorVersion()) {
             stdext::throw_exception(stdext::format("This map was saved with different OTB version. read %d what it's supposed to be: %d",
                                                headerMajorItems, g_things.getOtbMajorVersion()));
         }
 
-        root->skip(3);
-        uint32 headerMinorItems =  root->getU32();
+        in.skip(3);
+        uint32 headerMinorItems =  in.getU32();
         if(headerMinorItems > g_things.getOtbMinorVersion()) {
             g_logger.warning(stdext::format("This map needs an updated OTB. read %d what it's supposed to be: %d or less",
                                         headerMinorItems, g_things.getOtbMinorVersion()));
         }
 
-        BinaryTreePtr node = root->getChildren()[0];
-        if(node->getU8() != OTBM_MAP_DATA)
+        if(!in.enterChild() || in.getU8() != OTBM_MAP_DATA)
             stdext::throw_exception("Could not read root data node");
 
-        while(node->canRead()) {
-            uint8 attribute = node->getU8();
-            std::string tmp = node->getString();
+        while(in.canRead()) {
+            uint8 attribute = in.getU8();
+            std::string tmp = in.getString();
             switch (attribute) {
             case OTBM_ATTR_DESCRIPTION:
                 setDescription(tmp);
@@ -96,132 +253,107 @@ void Map::loadOtbm(const std::string& fileName)
             }
         }
 
-        for(const BinaryTreePtr& nodeMapData : node->getChildren()) {
-            uint8 mapDataType = nodeMapData->getU8();
+        // tile areas are independent, they are decoded on worker threads while the
+        // other nodes are read here, then merged in file order like a serial load
+        std::vector<uint> areaOffsets;
+        std::string scanError;
+        while(in.enterChild()) {
+            uint nodePos = in.tell() - 1;
+            uint8 mapDataType = in.getU8();
             if(mapDataType == OTBM_TILE_AREA) {
-                Position basePos;
-                basePos.x = nodeMapData->getU16();
-                basePos.y = nodeMapData->getU16();
-                basePos.z = nodeMapData->getU8();
-
-                for(const BinaryTreePtr &nodeTile : nodeMapData->getChildren()) {
-                    uint8 type = nodeTile->getU8();
-                    if(unlikely(type != OTBM_TILE && type != OTBM_HOUSETILE))
-                        stdext::throw_exception(stdext::format("invalid node tile type %d", (int)type));
-
-                    HousePtr house = nullptr;
-                    uint32 flags = TILESTATE_NONE;
-                    Position pos = basePos + nodeTile->getPoint();
-
-                    if(type == OTBM_HOUSETILE) {
-                        uint32 hId = nodeTile->getU32();
-                        TilePtr tile = getOrCreateTile(pos);
-                        if(!(house = g_houses.getHouse(hId))) {
-                            house = HousePtr(new House(hId));
-                            g_houses.addHouse(house);
-                        }
-                        house->setTile(tile);
-                    }
-
-                    while(nodeTile->canRead()) {
-                        uint8 tileAttr = nodeTile->getU8();
-                        switch(tileAttr) {
-                            case OTBM_ATTR_TILE_FLAGS: {
-                                uint32 _flags = nodeTile->getU32();
-                                if((_flags & TILESTATE_PROTECTIONZONE) == TILESTATE_PROTECTIONZONE)
-                                    flags |= TILESTATE_PROTECTIONZONE;
-                                else if((_flags & TILESTATE_OPTIONALZONE) == TILESTATE_OPTIONALZONE)
-                                    flags |= TILESTATE_OPTIONALZONE;
-                                else if((_flags & TILESTATE_HARDCOREZONE) == TILESTATE_HARDCOREZONE)
-                                    flags |= TILESTATE_HARDCOREZONE;
-
-                                if((_flags & TILESTATE_NOLOGOUT) == TILESTATE_NOLOGOUT)
-                                    flags |= TILESTATE_NOLOGOUT;
-
-                                if((_flags & TILESTATE_REFRESH) == TILESTATE_REFRESH)
-                                    flags |= TILESTATE_REFRESH;
-                                break;
-                            }
-                            case OTBM_ATTR_ITEM: {
-                                addThing(Item::createFromOtb(nodeTile->getU16()), pos);
-                                break;
-                            }
-                            default: {
-                                stdext::throw_exception(stdext::format("invalid tile attribute %d at pos %s",
-                                                                   (int)tileAttr, stdext::to_string(pos)));
-                            }
-                        }
-                    }
-
-                    for(const BinaryTreePtr& nodeItem : nodeTile->getChildren()) {
-                        if(unlikely(nodeItem->getU8() != OTBM_ITEM))
-                            stdext::throw_exception("invalid item node");
-
-                        ItemPtr item = Item::createFromOtb(nodeItem->getU16());
-                        item->unserializeItem(nodeItem);
-
-                        if(item->isContainer()) {
-                            for(const BinaryTreePtr& containerItem : nodeItem->getChildren()) {
-                                if(containerItem->getU8() != OTBM_ITEM)
-                                    stdext::throw_exception("invalid container item node");
-
-                                ItemPtr cItem = Item::createFromOtb(containerItem->getU16());
-                                cItem->unserializeItem(containerItem);
-                                item->addContainerItem(cItem);
-                            }
-                        }
-
-                        if(house && item->isMoveable()) {
-                            g_logger.warning(stdext::format("Moveable item found in house: %d at pos %s - escaping...", item->getId(), stdext::to_string(pos)));
-                            item.reset();
-                        }
-
-                        addThing(item, pos);
-                    }
-
-                    if(const TilePtr& tile = getTile(pos)) {
-                        if(house)
-                            tile->setFlag(TILESTATE_HOUSE);
-                        tile->setFlag(flags);
-                    }
-                }
+                areaOffsets.push_back(nodePos);
             } else if(mapDataType == OTBM_TOWNS) {
                 TownPtr town = nullptr;
-                for(const BinaryTreePtr &nodeTown : nodeMapData->getChildren()) {
-                    if(nodeTown->getU8() != OTBM_TOWN)
+                while(in.enterChild()) {
+                    if(in.getU8() != OTBM_TOWN)
                         stdext::throw_exception("invalid town node.");
 
-                    uint32 townId = nodeTown->getU32();
-                    std::string townName = nodeTown->getString();
+                    uint32 townId = in.getU32();
+                    std::string townName = in.getString();
 
                     Position townCoords;
-                    townCoords.x = nodeTown->getU16();
-                    townCoords.y = nodeTown->getU16();
-                    townCoords.z = nodeTown->getU8();
+                    townCoords.x = in.getU16();
+                    townCoords.y = in.getU16();
+                    townCoords.z = in.getU8();
 
                     if(!(town = g_towns.getTown(townId)))
                         g_towns.addTown(TownPtr(new Town(townId, townName, townCoords)));
+                    in.leaveNode();
                 }
                 g_towns.sort();
             } else if(mapDataType == OTBM_WAYPOINTS && headerVersion > 1) {
-                for(const BinaryTreePtr &nodeWaypoint : nodeMapData->getChildren()) {
-                    if(nodeWaypoint->getU8() != OTBM_WAYPOINT)
+                while(in.enterChild()) {
+                    if(in.getU8() != OTBM_WAYPOINT)
                         stdext::throw_exception("invalid waypoint node.");
 
-                    std::string name = nodeWaypoint->getString();
+                    std::string name = in.getString();
 
                     Position waypointPos;
-                    waypointPos.x = nodeWaypoint->getU16();
-                    waypointPos.y = nodeWaypoint->getU16();
-                    waypointPos.z = nodeWaypoint->getU8();
+                    waypointPos.x = in.getU16();
+                    waypointPos.y = in.getU16();
+                    waypointPos.z = in.getU8();
 
                     if(waypointPos.isValid() && !name.empty() && m_waypoints.find(waypointPos) == m_waypoints.end())
                         m_waypoints.insert(std::make_pair(waypointPos, name));
+                    in.leaveNode();
+                }
+            } else {
+                // areas read before the unknown node are still loaded, as a serial load would
+                scanError = stdext::format("Unknown map data node %d", (int)mapDataType);
+                break;
+            }
+            in.leaveNode();
+        }
+
+        std::vector<OtbmArea> areas(areaOffsets.size());
+        std::vector<boost::shared_future<bool>> tasks;
+        const uint8 *data = fin->data();
+        uint size = fin->size();
+        for(uint first = 0; first < areas.size(); first += OTBM_AREAS_PER_TASK) {
+            uint last = std::min<uint>(first + OTBM_AREAS_PER_TASK, areas.size());
+            OtbmArea *taskAreas = &areas[0];
+            const uint *offsets = &areaOffsets[0];
+            tasks.push_back(g_asyncDispatcher.schedule([=]() -> bool {
+                for(uint i = first; i < last; ++i)
+                    loadOtbmArea(data, size, offsets[i], taskAreas[i]);
+                return true;
+            }));
+        }
+
+        // every task must finish before leaving, they write into the areas above
+        std::string mergeError;
+        int lastPercent = -1;
+        for(uint task = 0; task < tasks.size(); ++task) {
+            tasks[task].wait();
+            if(!mergeError.empty())
+                continue;
+
+            uint first = task * OTBM_AREAS_PER_TASK;
+            uint last = std::min<uint>(first + OTBM_AREAS_PER_TASK, areas.size());
+            for(uint i = first; i < last && mergeError.empty(); ++i) {
+                try {
+                    mergeOtbmArea(areas[i]);
+                } catch(stdext::exception& e) {
+                    mergeError = e.what();
+                }
+                areas[i] = OtbmArea();
+
+                int percent = (i + 1) * 100 / areas.size();
+                if(percent != lastPercent) {
+                    lastPercent = percent;
+                    g_lua.callGlobalField("g_map", "onLoadProgress", percent);
                 }
-            } else
-                stdext::throw_exception(stdext::format("Unknown map data node %d", (int)mapDataType));
+            }
         }
 
+        if(!mergeError.empty())
+            stdext::throw_exception(mergeError);
+        if(!scanError.empty())
+            stdext::throw_exception(scanError);
+
+        in.leaveNode();
+        in.leaveNode();
+
         fin->close();
     } catch(std::exception& e) {
         g_logger.error(stdext::format("Failed to load '%s': %s", fileName, e.what()));
@@ -235,7 +367,7 @@ void Map::saveOtbm(const std::string& fileName)
         if(!fin)
             stdext::throw_exception(stdext::format("failed to open file '%s' for write", fileName));
 
-        fin->cache();
+        fin->stream();
         std::string dir;
         if(fileName.find_last_of('/') == std::string::npos)
             dir = g_resources.getWorkDir();
@@ -396,6 +528,12 @@ void Map::saveOtbm(const std::string& fileName)
 
 bool Map::loadOtcm(const std::string& fileName)
 {
+    // the index of a previously loaded otcm must not page blocks in from this file
+    for(int z = 0; z <= Otc::MAX_Z; ++z)
+        m_otcmBlocks[z].clear();
+    m_otcmFile = nullptr;
+    m_otcmCenterBlock = 0xFFFFFFFF;
+
     try {
         FileStreamPtr fin = g_resources.openFile(fileName);
         if(!fin)
@@ -409,10 +547,11 @@ bool Map::loadOtcm(const std::string& fileName)
 
         uint16 start = fin->getU16();
         uint16 version = fin->getU16();
-        fin->getU32(); // flags
+        uint32 flags = fin->getU32();
 
         switch(version) {
-            case 1: {
+            case 1:
+            case 2: {
                 fin->getString(); // description
                 uint32 datSignature = fin->getU32();
                 fin->getU16(); // protocol version
@@ -429,46 +568,148 @@ bool Map::loadOtcm(const std::string& fileName)
 
         fin->seek(start);
 
-        while(true) {
-            Position pos;
+        if(version == 1) {
+            readOtcmTiles(fin, true);
+            fin->close();
+            return true;
+        }
 
+        if(!(flags & OTCM_FLAG_ZLIB))
+            stdext::throw_exception("otcm compression not supported");
+
+        // version 2 stores an index of compressed blocks, only the ones around
+        // the camera are decompressed now, the rest are paged in as it moves
+        uint32 blockCount = fin->getU32();
+        for(uint32 i = 0; i < blockCount; ++i) {
+            Position pos;
             pos.x = fin->getU16();
             pos.y = fin->getU16();
             pos.z = fin->getU8();
 
-            // end of file
-            if(!pos.isValid())
+            OtcmBlock block;
+            block.offset = fin->getU32();
+            block.size = fin->getU32();
+            block.rawSize = fin->getU32();
+
+            if(!pos.isValid() || block.offset + block.size > fin->size())
+                stdext::throw_exception("invalid otcm block index");
+
+            m_otcmBlocks[pos.z][getBlockIndex(pos)] = block;
+        }
+
+        m_otcmFile = fin;
+        m_otcmCenterBlock = 0xFFFFFFFF;
+        if(m_centralPosition.isValid())
+            loadOtcmBlocks(m_centralPosition);
+
+        return true;
+    } catch(stdext::exception& e) {
+        g_logger.error(stdext::format("failed to load OTCM map: %s", e.what()));
+        return false;
+    }
+}
+
+void Map::readOtcmTiles(const FileStreamPtr& fin, bool replace)
+{
+    while(true) {
+        Position pos;
+
+        pos.x = fin->getU16();
+        pos.y = fin->getU16();
+        pos.z = fin->getU8();
+
+        // end of data
+        if(!pos.isValid())
+            break;
+
+        // tiles already received from the server are newer than the cached ones
+        TilePtr tile;
+        if(replace || !getTile(pos))
+            tile = createTile(pos);
+
+        int stackPos = 0;
+        while(true) {
+            int id = fin->getU16();
+
+            // end of tile
+            if(id == 0xFFFF)
                 break;
 
-            const TilePtr& tile = g_map.createTile(pos);
+            int countOrSubType = fin->getU8();
+            if(!tile)
+                continue;
 
-            int stackPos = 0;
-            while(true) {
-                int id = fin->getU16();
+            ItemPtr item = Item::create(id);
+            item->setCountOrSubType(countOrSubType);
 
-                // end of tile
-                if(id == 0xFFFF)
-                    break;
+            if(item->isValid())
+                tile->addThing(item, stackPos++);
+        }
 
-                int countOrSubType = fin->getU8();
+        if(tile)
+            notificateTileUpdate(pos);
+    }
+}
 
-                ItemPtr item = Item::create(id);
-                item->setCountOrSubType(countOrSubType);
+void Map::loadOtcmBlock(const OtcmBlock& block)
+{
+    std::string buffer(block.rawSize, '\0');
+    ulong destLen = block.rawSize;
+    int ret = uncompress((uchar*)&buffer[0], &destLen, m_otcmFile->data() + block.offset, block.size);
+    if(ret != Z_OK || destLen != block.rawSize)
+        stdext::throw_exception("corrupt otcm block");
 
-                if(item->isValid())
-                    tile->addThing(item, stackPos++);
-            }
+    readOtcmTiles(FileStreamPtr(new FileStream(m_otcmFile->name(), buffer)), false);
+}
 
-            g_map.notificateTileUpdate(pos);
+void Map::loadOtcmBlocks(const Position& center)
+{
+    const int blocksPerRow = 65536 / BLOCK_SIZE;
+    int centerX = center.x / BLOCK_SIZE;
+    int centerY = center.y / BLOCK_SIZE;
+    m_otcmCenterBlock = getBlockIndex(center);
+
+    bool pending = false;
+    try {
+        for(int z = 0; z <= Otc::MAX_Z; ++z) {
+            auto& blocks = m_otcmBlocks[z];
+            for(int y = std::max<int>(centerY - OTCM_LOAD_RADIUS, 0); y <= std::min<int>(centerY + OTCM_LOAD_RADIUS, blocksPerRow - 1) && !blocks.empty(); ++y) {
+                for(int x = std::max<int>(centerX - OTCM_LOAD_RADIUS, 0); x <= std::min<int>(centerX + OTCM_LOAD_RADIUS, blocksPerRow - 1); ++x) {
+                    auto it = blocks.find(y * blocksPerRow + x);
+                    if(it == blocks.end())
+                        continue;
+                    OtcmBlock block = it->second;
+                    blocks.erase(it);
+                    loadOtcmBlock(block);
+                }
+            }
+            pending |= !blocks.empty();
         }
+    } catch(stdext::exception& e) {
+        g_logger.error(stdext::format("failed to load OTCM block: %s", e.what()));
+    }
 
-        fin->close();
+    // everything was paged in, release the file buffer
+    if(!pending)
+        m_otcmFile = nullptr;
+}
 
-        return true;
+void Map::loadAllOtcmBlocks()
+{
+    if(!m_otcmFile)
+        return;
+
+    try {
+        for(int z = 0; z <= Otc::MAX_Z; ++z) {
+            for(const auto& it : m_otcmBlocks[z])
+                loadOtcmBlock(it.second);
+            m_otcmBlocks[z].clear();
+        }
     } catch(stdext::exception& e) {
-        g_logger.error(stdext::format("failed to load OTCM map: %s", e.what()));
-        return false;
+        g_logger.error(stdext::format("failed to load OTCM block: %s", e.what()));
     }
+
+    m_otcmFile = nullptr;
 }
 
 void Map::saveOtcm(const std::string& fileName)
@@ -476,11 +717,13 @@ void Map::saveOtcm(const std::string& fileName)
     try {
         stdext::timer saveTimer;
 
+        // blocks that were never paged in would be lost otherwise
+        loadAllOtcmBlocks();
+
         FileStreamPtr fin = g_resources.createFile(fileName);
-        fin->cache();
+        fin->stream();
 
-        //TODO: compression flag with zlib
-        uint32 flags = 0;
+        uint32 flags = OTCM_FLAG_ZLIB;
 
         // header
         fin->addU32(OTCM_SIGNATURE);
@@ -488,49 +731,92 @@ void Map::saveOtcm(const std::string& fileName)
         fin->addU16(OTCM_VERSION);
         fin->addU32(flags);
 
-        // version 1 header
-        fin->addString("OTCM 1.0"); // map description
+        // version 2 header
+        fin->addString("OTCM 2.0"); // map description
         fin->addU32(g_things.getDatSignature());
         fin->addU16(g_game.getClientVersion());
         fin->addString(g_game.getWorldName());
 
         // go back and rewrite where the map data starts
         uint32 start = fin->tell();
-        fin->seek(4);
-        fin->addU16(start);
-        fin->seek(start);
+        fin->patchU16(4, start);
 
+        std::vector<std::pair<Position, const TileBlock*>> blocks;
         for(uint8_t z = 0; z <= Otc::MAX_Z; ++z) {
             for(const auto& it : m_tileBlocks[z]) {
                 const TileBlock& block = it.second;
                 for(const TilePtr& tile : block.getTiles()) {
-                    if(!tile || tile->isEmpty())
-                        continue;
-
-                    Position pos = tile->getPosition();
-                    fin->addU16(pos.x);
-                    fin->addU16(pos.y);
-                    fin->addU8(pos.z);
-
-                    for(const ThingPtr& thing : tile->getThings()) {
-                        if(thing->isItem()) {
-                            ItemPtr item = thing->static_self_cast<Item>();
-                            fin->addU16(item->getId());
-                            fin->addU8(item->getCountOrSubType());
-                        }
+                    if(tile && !tile->isEmpty()) {
+                        Position pos = tile->getPosition();
+                        blocks.push_back(std::make_pair(Position(pos.x - pos.x % BLOCK_SIZE, pos.y - pos.y % BLOCK_SIZE, z), &block));
+                        break;
                     }
+                }
+            }
+        }
 
-                    // end of tile
-                    fin->addU16(0xFFFF);
+        // block index, offsets and sizes are filled in later
+        const uint32 indexEntrySize = 17;
+        uint32 indexStart = fin->tell();
+        fin->addU32(blocks.size());
+        for(uint32 i = 0; i < blocks.size() * indexEntrySize; ++i)
+            fin->addU8(0);
+
+        const int COMPRESS_LEVEL = 3;
+        std::vector<OtcmBlock> index(blocks.size());
+        std::vector<uchar> compressBuffer;
+        for(uint32 i = 0; i < blocks.size(); ++i) {
+            FileStreamPtr raw(new FileStream(fileName, std::string()));
+            for(const TilePtr& tile : blocks[i].second->getTiles()) {
+                if(!tile || tile->isEmpty())
+                    continue;
+
+                Position pos = tile->getPosition();
+                raw->addU16(pos.x);
+                raw->addU16(pos.y);
+                raw->addU8(pos.z);
+
+                for(const ThingPtr& thing : tile->getThings()) {
+                    if(thing->isItem()) {
+                        ItemPtr item = thing->static_self_cast<Item>();
+                        raw->addU16(item->getId());
+                        raw->addU8(item->getCountOrSubType());
+                    }
                 }
+
+                // end of tile
+                raw->addU16(0xFFFF);
             }
+
+            // end of block
+            Position invalidPos;
+            raw->addU16(invalidPos.x);
+            raw->addU16(invalidPos.y);
+            raw->addU8(invalidPos.z);
+
+            ulong len = compressBound(raw->size());
+            compressBuffer.resize(len);
+            int ret = compress2(compressBuffer.data(), &len, raw->data(), raw->size(), COMPRESS_LEVEL);
+            if(ret != Z_OK)
+                stdext::throw_exception("failed to compress otcm block");
+
+            index[i].offset = fin->tell();
+            index[i].size = len;
+            index[i].rawSize = raw->size();
+            fin->write(compressBuffer.data(), len);
         }
 
-        // end of file
-        Position invalidPos;
-        fin->addU16(invalidPos.x);
-        fin->addU16(invalidPos.y);
-        fin->addU8(invalidPos.z);
+        FileStreamPtr table(new FileStream(fileName, std::string()));
+        for(uint32 i = 0; i < blocks.size(); ++i) {
+            const Position& pos = blocks[i].first;
+            table->addU16(pos.x);
+            table->addU16(pos.y);
+            table->addU8(pos.z);
+            table->addU32(index[i].offset);
+            table->addU32(index[i].size);
+            table->addU32(index[i].rawSize);
+        }
+        fin->patch(indexStart + 4, table->data(), table->size());
 
         fin->flush();
 
@@ -31,60 +31,162 @@
 #include <framework/graphics/framebuffermanager.h>
 #include <framework/core/resourcemanager.h>
 #include <framework/core/filestream.h>
+#include <framework/core/asyncdispatcher.h>
+#include <framework/core/eventdispatcher.h>
 #include <zlib.h>
 
 Minimap g_minimap;
 
+struct OtmmCompaction {
+    std::string fileName;
+    std::vector<Position> positions;
+    std::vector<MinimapTile> tiles;
+    std::vector<std::string> records;
+    std::vector<std::string> journal; // blocks appended to the old file while compacting
+    boost::shared_future<bool> task;
+};
+
+static const uint OTMM_BLOCK_TILES = MMBLOCK_SIZE * MMBLOCK_SIZE;
+
+// builds a complete block record (position, compressed size and data), an empty record means failure
+static void compressBlock(const Position& pos, const MinimapTile *tiles, std::string& record)
+{
+    const int COMPRESS_LEVEL = 3;
+    const uint blockSize = OTMM_BLOCK_TILES * sizeof(MinimapTile);
+
+    ulong len = compressBound(blockSize);
+    record.resize(7 + len);
+    uchar *data = (uchar*)&record[0];
+    stdext::writeULE16(data, pos.x);
+    stdext::writeULE16(data + 2, pos.y);
+    data[4] = pos.z;
+    if(compress2(data + 7, &len, (const uchar*)tiles, blockSize, COMPRESS_LEVEL) != Z_OK) {
+        record.clear();
+        return;
+    }
+    stdext::writeULE16(data + 5, len);
+    record.resize(7 + len);
+}
+
+// runs f(i) for every i in [0, count) on the async dispatcher and waits for all of them
+template<typename F>
+static void parallelFor(uint count, const F& f)
+{
+    std::vector<boost::shared_future<bool>> tasks;
+    for(uint begin = 0; begin < count; begin += OTMM_BLOCKS_PER_TASK) {
+        uint end = std::min<uint>(begin + OTMM_BLOCKS_PER_TASK, count);
+        tasks.push_back(g_asyncDispatcher.schedule([&f, begin, end]() -> bool {
+            try {
+                for(uint i = begin; i < end; ++i)
+                    f(i);
+                return true;
+            } catch(...) {
+                return false;
+            }
+        }));
+    }
+    for(const auto& task : tasks)
+        task.wait();
+}
+
+// writes the file straight to disk instead of building it in memory first, into a
+// temporary file that replaces the old one only once complete so a crash keeps the old minimap
+static void writeOtmm(const std::string& fileName, const std::vector<std::string>& records)
+{
+    std::string tmpFileName = fileName + ".tmp";
+    FileStreamPtr fin = g_resources.createFile(tmpFileName);
+    fin->stream();
+
+    std::string description = "OTMM 2.0";
+    uint16 start = 4 + 2 + 2 + 4 + 2 + description.length();
+
+    // header
+    fin->addU32(OTMM_SIGNATURE);
+    fin->addU16(start);
+    fin->addU16(OTMM_VERSION);
+    fin->addU32(0); // flags
+    fin->addString(description);
+
+    for(const std::string& record : records) {
+        if(!record.empty())
+            fin->write(record.data(), record.size());
+    }
+
+    // end of segment
+    Position invalidPos;
+    fin->addU16(invalidPos.x);
+    fin->addU16(invalidPos.y);
+    fin->addU8(invalidPos.z);
+
+    fin->flush();
+    fin->close();
+
+    if(!g_resources.renameFile(tmpFileName, fileName))
+        stdext::throw_exception("unable to replace the minimap file");
+}
+
+// 8 bit minimap colors to rgba, 255 is the transparent color
+static const std::array<uint32, 256>& getPalette()
+{
+    static std::array<uint32, 256> palette = [] {
+        std::array<uint32, 256> colors;
+        for(int c = 0; c < 256; ++c)
+            colors[c] = c != 255 ? Color::from8bit(c).rgba() : Color::alpha.rgba();
+        return colors;
+    }();
+    return palette;
+}
+
 void MinimapBlock::clean()
 {
     m_tiles.fill(MinimapTile());
-    m_texture.reset();
-    m_mustUpdate = false;
+    mustUpdate();
 }
 
-void MinimapBlock::update()
+void MinimapBlock::update(const TexturePtr& pageTexture, const Point& offset)
 {
-    if(!m_mustUpdate)
+    if(!m_dirtyRect.isValid())
         return;
 
-    ImagePtr image(new Image(Size(MMBLOCK_SIZE, MMBLOCK_SIZE)));
-
-    bool shouldDraw = false;
-    for(int x=0;x<MMBLOCK_SIZE;++x) {
-        for(int y=0;y<MMBLOCK_SIZE;++y) {
-            uint8 c = getTile(x, y).color;
-            uint32 col;
-            if(c != 255) {
-                col = Color::from8bit(c).rgba();
-                shouldDraw = true;
-            } else
-                col = Color::alpha.rgba();
-            image->setPixel(x, y, col);
-        }
-    }
+    // only the changed rect is converted and uploaded
+    static std::vector<uint32> pixels(MMBLOCK_SIZE * MMBLOCK_SIZE);
+    const std::array<uint32, 256>& palette = getPalette();
 
-    if(shouldDraw) {
-        if(!m_texture) {
-            m_texture = TexturePtr(new Texture(image, true));
-        } else {
-            m_texture->uploadPixels(image, true);
-        }
-    } else
-        m_texture.reset();
+    int i = 0;
+    for(int y = m_dirtyRect.top(); y <= m_dirtyRect.bottom(); ++y) {
+        for(int x = m_dirtyRect.left(); x <= m_dirtyRect.right(); ++x)
+            pixels[i++] = palette[m_tiles[getTileIndex(x, y)].color];
+    }
 
-    m_mustUpdate = false;
+    pageTexture->updatePixels(m_dirtyRect.translated(offset), (uchar*)pixels.data());
+    m_dirtyRect = Rect();
 }
 
 void MinimapBlock::updateTile(int x, int y, const MinimapTile& tile)
 {
-    if(m_tiles[getTileIndex(x,y)].color != tile.color)
-        m_mustUpdate = true;
+    uint index = getTileIndex(x,y);
+    if(m_tiles[index].color != tile.color) {
+        if(!m_dirtyRect.isValid())
+            m_dirtyRect = Rect(x, y, 1, 1);
+        else {
+            m_dirtyRect.setLeft(std::min<int>(m_dirtyRect.left(), x));
+            m_dirtyRect.setTop(std::min<int>(m_dirtyRect.top(), y));
+            m_dirtyRect.setRight(std::max<int>(m_dirtyRect.right(), x));
+            m_dirtyRect.setBottom(std::max<int>(m_dirtyRect.bottom(), y));
+        }
+    }
+    if(m_tiles[index] != tile)
+        m_mustSave = true;
 
-    m_tiles[getTileIndex(x,y)] = tile;
+    m_tiles[index] = tile;
 }
 
 void Minimap::init()
 {
+    m_otmmFileBlocks = 0;
+    m_otmmJournalBlocks = 0;
+    m_lastLoadDuration = 0;
+    m_lastSaveDuration = 0;
 }
 
 void Minimap::terminate()
@@ -94,8 +196,15 @@ void Minimap::terminate()
 
 void Minimap::clean()
 {
-    for(int i=0;i<=Otc::MAX_Z;++i)
+    finishCompaction();
+
+    for(int i=0;i<=Otc::MAX_Z;++i) {
         m_tileBlocks[i].clear();
+        m_pages[i].clear();
+    }
+
+    // the next save must rewrite the whole file
+    m_otmmFile.clear();
 }
 
 void Minimap::draw(const Rect& screenRect, const Position& mapCenter, float scale, const Color& color)
@@ -115,40 +224,71 @@ void Minimap::draw(const Rect& screenRect, const Position& mapCenter, float scal
         return;
     }
 
-    Point blockOff = getBlockOffset(mapRect.topLeft());
+    Point pageOff = Point(mapRect.left() - mapRect.left() % MMPAGE_SIZE, mapRect.top() - mapRect.top() % MMPAGE_SIZE);
     Point off = Point((mapRect.size() * scale).toPoint() - screenRect.size().toPoint())/2;
-    Point start = screenRect.topLeft() -(mapRect.topLeft() - blockOff)*scale - off;
+    Point start = screenRect.topLeft() -(mapRect.topLeft() - pageOff)*scale - off;
 
-    for(int y = blockOff.y, ys = start.y;ys<screenRect.bottom();y += MMBLOCK_SIZE, ys += MMBLOCK_SIZE*scale) {
+    auto& pages = m_pages[mapCenter.z];
+    for(int y = pageOff.y, ys = start.y;ys<screenRect.bottom();y += MMPAGE_SIZE, ys += MMPAGE_SIZE*scale) {
         if(y < 0 || y >= 65536)
             continue;
 
-        for(int x = blockOff.x, xs = start.x;xs<screenRect.right();x += MMBLOCK_SIZE, xs += MMBLOCK_SIZE*scale) {
+        for(int x = pageOff.x, xs = start.x;xs<screenRect.right();x += MMPAGE_SIZE, xs += MMPAGE_SIZE*scale) {
             if(x < 0 || x >= 65536)
                 continue;
 
-            Position blockPos(x, y, mapCenter.z);
-            if(!hasBlock(blockPos))
+            auto it = pages.find(((y / MMPAGE_SIZE) * (65536 / MMPAGE_SIZE)) + (x / MMPAGE_SIZE));
+            if(it == pages.end())
                 continue;
 
-            MinimapBlock& block = getBlock(Position(x, y, mapCenter.z));
-            block.update();
+            MinimapPage& page = it->second;
+            if(page.mustUpdate)
+                updatePage(page, Point(x, y), mapCenter.z);
 
-            const TexturePtr& tex = block.getTexture();
+            const TexturePtr& tex = page.texture;
             if(tex) {
-                Rect src(0, 0, MMBLOCK_SIZE, MMBLOCK_SIZE);
+                if(scale < 1.0f && page.mipmapsDirty) {
+                    tex->buildHardwareMipmaps();
+                    page.mipmapsDirty = false;
+                }
+
+                Rect src(0, 0, MMPAGE_SIZE, MMPAGE_SIZE);
                 Rect dest(Point(xs,ys), src.size() * scale);
 
                 tex->setSmooth(scale < 1.0f);
                 g_painter->drawTexturedRect(dest, tex, src);
             }
-            //g_painter->drawBoundingRect(Rect(xs,ys, MMBLOCK_SIZE * scale, MMBLOCK_SIZE * scale));
         }
     }
 
     g_painter->restoreSavedState();
 }
 
+void Minimap::updatePage(MinimapPage& page, const Point& pageOffset, int z)
+{
+    if(!page.texture) {
+        ImagePtr image(new Image(Size(MMPAGE_SIZE, MMPAGE_SIZE)));
+        page.texture = TexturePtr(new Texture(image));
+    }
+
+    for(int y = 0; y < MMPAGE_SIZE; y += MMBLOCK_SIZE) {
+        for(int x = 0; x < MMPAGE_SIZE; x += MMBLOCK_SIZE) {
+            Position blockPos(pageOffset.x + x, pageOffset.y + y, z);
+            if(!hasBlock(blockPos))
+                continue;
+
+            MinimapBlock& block = getBlock(blockPos);
+            if(!block.needsUpdate())
+                continue;
+
+            block.update(page.texture, Point(x, y));
+            page.mipmapsDirty = true;
+        }
+    }
+
+    page.mustUpdate = false;
+}
+
 Point Minimap::getTilePoint(const Position& pos, const Rect& screenRect, const Position& mapCenter, float scale)
 {
     if(screenRect.isEmpty() || pos.z != mapCenter.z)
@@ -208,6 +348,8 @@ void Minimap::updateTile(const Position& pos, const TilePtr& tile)
         Point offsetPos = getBlockOffset(Point(pos.x, pos.y));
         block.updateTile(pos.x - offsetPos.x, pos.y - offsetPos.y, minimapTile);
         block.justSaw();
+        if(block.needsUpdate())
+            getPage(pos).mustUpdate = true;
     }
 }
 
@@ -288,6 +430,8 @@ bool Minimap::loadImage(const std::string& fileName, const Position& topLeft, fl
                     tile.color = c;
                     tile.flags = flags;
                     block.mustUpdate();
+                    block.mustSave();
+                    getPage(pos).mustUpdate = true;
                 }
             }
         }
@@ -306,6 +450,8 @@ void Minimap::saveImage(const std::string& fileName, const Rect& mapRect)
 bool Minimap::loadOtmm(const std::string& fileName)
 {
     try {
+        stdext::timer loadTimer;
+
         FileStreamPtr fin = g_resources.openFile(fileName);
         if(!fin)
             stdext::throw_exception("unable to open file");
@@ -321,7 +467,8 @@ bool Minimap::loadOtmm(const std::string& fileName)
         fin->getU32(); // flags
 
         switch(version) {
-            case 1: {
+            case 1:
+            case 2: {
                 fin->getString(); // description
                 break;
             }
@@ -331,34 +478,82 @@ bool Minimap::loadOtmm(const std::string& fileName)
 
         fin->seek(start);
 
-        uint blockSize = MMBLOCK_SIZE * MMBLOCK_SIZE * sizeof(MinimapTile);
-        std::vector<uchar> compressBuffer(compressBound(blockSize));
-        std::vector<uchar> decompressBuffer(blockSize);
-
-        while(true) {
+        bool hadBlocks = false;
+        for(int z = 0; z <= Otc::MAX_Z; ++z)
+            hadBlocks |= !m_tileBlocks[z].empty();
+
+        // index the records first, version 2 files may contain journal segments
+        // appended after the first one and a later record of a block replaces the earlier
+        std::vector<MinimapBlock*> blocks;
+        std::vector<Position> positions;
+        std::vector<uint> offsets;
+        std::vector<uint16> sizes;
+        std::unordered_map<MinimapBlock*, uint> recordIndex;
+        uint records = 0;
+        while(fin->tell() + 7 <= fin->size()) {
             Position pos;
             pos.x = fin->getU16();
             pos.y = fin->getU16();
             pos.z = fin->getU8();
 
-            // end of file or file is corrupted
-            if(!pos.isValid() || pos.z >= Otc::MAX_Z+1)
+            // end of segment
+            if(!pos.isValid())
+                continue;
+
+            // file is corrupted
+            if(pos.z >= Otc::MAX_Z+1)
                 break;
 
-            MinimapBlock& block = getBlock(pos);
-            ulong len = fin->getU16();
-            ulong destLen = blockSize;
-            fin->read(compressBuffer.data(), len);
-            int ret = uncompress(decompressBuffer.data(), &destLen, compressBuffer.data(), len);
-            if(ret != Z_OK || destLen != blockSize)
+            uint16 len = fin->getU16();
+            if(fin->tell() + len > fin->size())
                 break;
 
-            memcpy((uchar*)&block.getTiles(), decompressBuffer.data(), blockSize);
-            block.mustUpdate();
-            block.justSaw();
+            MinimapBlock *block = &getBlock(pos);
+            auto it = recordIndex.find(block);
+            if(it == recordIndex.end()) {
+                recordIndex[block] = blocks.size();
+                blocks.push_back(block);
+                positions.push_back(pos);
+                offsets.push_back(fin->tell());
+                sizes.push_back(len);
+            } else {
+                offsets[it->second] = fin->tell();
+                sizes[it->second] = len;
+            }
+
+            fin->skip(len);
+            records++;
+        }
+
+        const uint blockSize = OTMM_BLOCK_TILES * sizeof(MinimapTile);
+        const uint8 *data = fin->data();
+        std::vector<uint8> results(blocks.size(), 0);
+        parallelFor(blocks.size(), [&](uint i) {
+            ulong destLen = blockSize;
+            int ret = uncompress((uchar*)&blocks[i]->getTiles(), &destLen, data + offsets[i], sizes[i]);
+            results[i] = (ret == Z_OK && destLen == blockSize);
+        });
+
+        for(uint i = 0; i < blocks.size(); ++i) {
+            MinimapBlock *block = blocks[i];
+            getPage(positions[i]).mustUpdate = true;
+            if(!results[i]) {
+                block->clean();
+                continue;
+            }
+            block->mustUpdate();
+            block->justSaw();
+            block->justSaved();
         }
 
         fin->close();
+
+        // appending to this file is only valid when it holds everything that is in memory,
+        // older versions have no journal segments and are rewritten in full
+        m_otmmFile = hadBlocks || version != OTMM_VERSION ? std::string() : fileName;
+        m_otmmFileBlocks = blocks.size();
+        m_otmmJournalBlocks = records - blocks.size();
+        m_lastLoadDuration = loadTimer.elapsed_millis();
         return true;
     } catch(stdext::exception& e) {
         g_logger.error(stdext::format("failed to load OTMM minimap: %s", e.what()));
@@ -371,61 +566,161 @@ void Minimap::saveOtmm(const std::string& fileName)
     try {
         stdext::timer saveTimer;
 
-        FileStreamPtr fin = g_resources.createFile(fileName);
-        fin->cache();
-
-        //TODO: compression flag with zlib
-        uint32 flags = 0;
-
-        // header
-        fin->addU32(OTMM_SIGNATURE);
-        fin->addU16(0); // data start, will be overwritten later
-        fin->addU16(OTMM_VERSION);
-        fin->addU32(flags);
+        if(m_compaction && (m_compaction->fileName != fileName || m_compaction->task.is_ready()))
+            finishCompaction();
 
-        // version 1 header
-        fin->addString("OTMM 1.0"); // description
-
-        // go back and rewrite where the map data starts
-        uint32 start = fin->tell();
-        fin->seek(4);
-        fin->addU16(start);
-        fin->seek(start);
-
-        uint blockSize = MMBLOCK_SIZE * MMBLOCK_SIZE * sizeof(MinimapTile);
-        std::vector<uchar> compressBuffer(compressBound(blockSize));
-        const int COMPRESS_LEVEL = 3;
+        // only blocks changed since the last save are appended to the file
+        bool incremental = !m_otmmFile.empty() && m_otmmFile == fileName && g_resources.fileExists(fileName);
 
+        std::vector<Position> positions;
+        std::vector<MinimapBlock*> blocks;
         for(uint8_t z = 0; z <= Otc::MAX_Z; ++z) {
             for(auto& it : m_tileBlocks[z]) {
-                int index = it.first;
                 MinimapBlock& block = it.second;
-                if(!block.wasSeen())
+                if(!block.wasSeen() || (incremental && !block.needsSave()))
                     continue;
 
-                Position pos = getIndexPosition(index, z);
-                fin->addU16(pos.x);
-                fin->addU16(pos.y);
-                fin->addU8(pos.z);
-
-                ulong len = blockSize;
-                int ret = compress2(compressBuffer.data(), &len, (uchar*)&block.getTiles(), blockSize, COMPRESS_LEVEL);
-                assert(ret == Z_OK);
-                fin->addU16(len);
-                fin->write(compressBuffer.data(), len);
+                positions.push_back(getIndexPosition(it.first, z));
+                blocks.push_back(&block);
             }
         }
 
-        // end of file
-        Position invalidPos;
-        fin->addU16(invalidPos.x);
-        fin->addU16(invalidPos.y);
-        fin->addU8(invalidPos.z);
+        std::vector<std::string> records(blocks.size());
+        parallelFor(blocks.size(), [&](uint i) {
+            compressBlock(positions[i], blocks[i]->getTiles().data(), records[i]);
+        });
 
-        fin->flush();
+        // blocks that failed to compress are left to be saved again
+        uint written = 0;
+        for(uint i = 0; i < blocks.size(); ++i) {
+            if(records[i].empty())
+                continue;
+            blocks[i]->justSaved();
+            written++;
+        }
 
-        fin->close();
+        if(incremental) {
+            if(written > 0) {
+                FileStreamPtr fin = g_resources.appendFile(fileName);
+                for(const std::string& record : records) {
+                    if(!record.empty())
+                        fin->write(record.data(), record.size());
+                }
+
+                // end of segment
+                Position invalidPos;
+                fin->addU16(invalidPos.x);
+                fin->addU16(invalidPos.y);
+                fin->addU8(invalidPos.z);
+
+                fin->flush();
+                fin->close();
+
+                m_otmmJournalBlocks += written;
+                if(m_compaction) {
+                    for(std::string& record : records) {
+                        if(!record.empty())
+                            m_compaction->journal.push_back(std::move(record));
+                    }
+                } else if(m_otmmJournalBlocks > std::max<uint>(m_otmmFileBlocks, OTMM_JOURNAL_MIN_BLOCKS))
+                    compactOtmm(fileName);
+            }
+        } else {
+            // a pending compaction of this file is outdated by the full rewrite
+            if(m_compaction) {
+                m_compaction->task.wait();
+                m_compaction.reset();
+            }
+
+            writeOtmm(fileName, records);
+
+            m_otmmFile = fileName;
+            m_otmmFileBlocks = written;
+            m_otmmJournalBlocks = 0;
+        }
+
+        m_lastSaveDuration = saveTimer.elapsed_millis();
     } catch(stdext::exception& e) {
         g_logger.error(stdext::format("failed to save OTMM minimap: %s", e.what()));
     }
 }
+
+void Minimap::compactOtmm(const std::string& fileName)
+{
+    // take a snapshot of every seen block, the compression runs in background
+    std::shared_ptr<OtmmCompaction> compaction = std::make_shared<OtmmCompaction>();
+    compaction->fileName = fileName;
+    for(uint8_t z = 0; z <= Otc::MAX_Z; ++z) {
+        for(auto& it : m_tileBlocks[z]) {
+            MinimapBlock& block = it.second;
+            if(!block.wasSeen())
+                continue;
+
+            compaction->positions.push_back(getIndexPosition(it.first, z));
+            compaction->tiles.insert(compaction->tiles.end(), block.getTiles().begin(), block.getTiles().end());
+        }
+    }
+
+    compaction->task = g_asyncDispatcher.schedule([compaction]() -> bool {
+        try {
+            compaction->records.resize(compaction->positions.size());
+            for(uint i = 0; i < compaction->positions.size(); ++i) {
+                // a missing block would drop it from the file, keep the old file instead
+                compressBlock(compaction->positions[i], &compaction->tiles[i * OTMM_BLOCK_TILES], compaction->records[i]);
+                if(compaction->records[i].empty())
+                    return false;
+            }
+            std::vector<MinimapTile>().swap(compaction->tiles);
+            return true;
+        } catch(...) {
+            return false;
+        }
+    });
+
+    m_compaction = compaction;
+    pollCompaction();
+}
+
+void Minimap::pollCompaction()
+{
+    if(!m_compaction)
+        return;
+
+    if(m_compaction->task.is_ready())
+        finishCompaction();
+    else
+        g_dispatcher.scheduleEvent(std::bind(&Minimap::pollCompaction, this), 100);
+}
+
+void Minimap::finishCompaction()
+{
+    if(!m_compaction)
+        return;
+
+    std::shared_ptr<OtmmCompaction> compaction = m_compaction;
+    m_compaction.reset();
+
+    // the old file and its journal stay valid when the compaction is dropped
+    try {
+        if(!compaction->task.get()) {
+            g_logger.error("failed to compact OTMM minimap");
+            return;
+        }
+    } catch(std::exception&) {
+        // the async dispatcher was terminated before running it, at shutdown
+        return;
+    }
+
+    try {
+        uint journalBlocks = compaction->journal.size();
+        for(std::string& record : compaction->journal)
+            compaction->records.push_back(std::move(record));
+
+        writeOtmm(compaction->fileName, compaction->records);
+
+        m_otmmFileBlocks = compaction->records.size() - journalBlocks;
+        m_otmmJournalBlocks = journalBlocks;
+    } catch(stdext::exception& e) {
+        g_logger.error(stdext::format("failed to compact OTMM minimap: %s", e.what()));
+    }
+}
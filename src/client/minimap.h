@@ -29,8 +29,11 @@
 
 enum {
     MMBLOCK_SIZE = 64,
+    MMPAGE_SIZE = 256,
     OTMM_SIGNATURE = 0x4D4d544F,
-    OTMM_VERSION = 1
+    OTMM_VERSION = 2,
+    OTMM_BLOCKS_PER_TASK = 32,
+    OTMM_JOURNAL_MIN_BLOCKS = 256
 };
 
 enum MinimapTileFlags {
@@ -56,25 +59,38 @@ class MinimapBlock
 {
 public:
     void clean();
-    void update();
+    void update(const TexturePtr& pageTexture, const Point& offset);
     void updateTile(int x, int y, const MinimapTile& tile);
     MinimapTile& getTile(int x, int y) { return m_tiles[getTileIndex(x,y)]; }
     void resetTile(int x, int y) { m_tiles[getTileIndex(x,y)] = MinimapTile(); }
     uint getTileIndex(int x, int y) { return ((y % MMBLOCK_SIZE) * MMBLOCK_SIZE) + (x % MMBLOCK_SIZE); }
-    const TexturePtr& getTexture() { return m_texture; }
     std::array<MinimapTile, MMBLOCK_SIZE *MMBLOCK_SIZE>& getTiles() { return m_tiles; }
-    void mustUpdate() { m_mustUpdate = true; }
+    void mustUpdate() { m_dirtyRect = Rect(0, 0, MMBLOCK_SIZE, MMBLOCK_SIZE); }
+    bool needsUpdate() { return m_dirtyRect.isValid(); }
     void justSaw() { m_wasSeen = true; }
     bool wasSeen() { return m_wasSeen; }
+    void mustSave() { m_mustSave = true; }
+    void justSaved() { m_mustSave = false; }
+    bool needsSave() { return m_mustSave; }
 private:
-    TexturePtr m_texture;
     std::array<MinimapTile, MMBLOCK_SIZE *MMBLOCK_SIZE> m_tiles;
-    stdext::boolean<true> m_mustUpdate;
+    Rect m_dirtyRect; // tiles whose color changed since the last upload
     stdext::boolean<false> m_wasSeen;
+    stdext::boolean<false> m_mustSave;
 };
 
 #pragma pack(pop)
 
+// blocks are drawn from pages of MMPAGE_SIZE tiles wide textures, one draw per page
+struct MinimapPage
+{
+    TexturePtr texture;
+    stdext::boolean<false> mustUpdate;
+    stdext::boolean<false> mipmapsDirty;
+};
+
+struct OtmmCompaction;
+
 class Minimap
 {
 
@@ -97,7 +113,14 @@ public:
     bool loadOtmm(const std::string& fileName);
     void saveOtmm(const std::string& fileName);
 
+    int getLastLoadDuration() { return m_lastLoadDuration; }
+    int getLastSaveDuration() { return m_lastSaveDuration; }
+
 private:
+    void compactOtmm(const std::string& fileName);
+    void pollCompaction();
+    void finishCompaction();
+
     Rect calcMapRect(const Rect& screenRect, const Position& mapCenter, float scale);
     bool hasBlock(const Position& pos) { return m_tileBlocks[pos.z].find(getBlockIndex(pos)) != m_tileBlocks[pos.z].end(); }
     MinimapBlock& getBlock(const Position& pos) { return m_tileBlocks[pos.z][getBlockIndex(pos)]; }
@@ -106,7 +129,16 @@ private:
     Position getIndexPosition(int index, int z) { return Position((index % (65536 / MMBLOCK_SIZE))*MMBLOCK_SIZE,
                                                                   (index / (65536 / MMBLOCK_SIZE))*MMBLOCK_SIZE, z); }
     uint getBlockIndex(const Position& pos) { return ((pos.y / MMBLOCK_SIZE) * (65536 / MMBLOCK_SIZE)) + (pos.x / MMBLOCK_SIZE); }
+    MinimapPage& getPage(const Position& pos) { return m_pages[pos.z][((pos.y / MMPAGE_SIZE) * (65536 / MMPAGE_SIZE)) + (pos.x / MMPAGE_SIZE)]; }
+    void updatePage(MinimapPage& page, const Point& pageOffset, int z);
     std::unordered_map<uint, MinimapBlock> m_tileBlocks[Otc::MAX_Z+1];
+    std::unordered_map<uint, MinimapPage> m_pages[Otc::MAX_Z+1];
+    std::shared_ptr<OtmmCompaction> m_compaction;
+    std::string m_otmmFile;
+    uint m_otmmFileBlocks;
+    uint m_otmmJournalBlocks;
+    int m_lastLoadDuration;
+    int m_lastSaveDuration;
 };
 
 extern Minimap g_minimap;
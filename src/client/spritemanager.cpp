@@ -73,7 +73,9 @@ void SpriteManager::saveSpr(std::string fileName)
         if(!fin)
             stdext::throw_exception(stdext::format("failed to open file '%s' for write", fileName));
 
-        fin->cache();
+        // the output is written sequentially through a fixed size buffer, so the
+        // sprite addresses are computed before writing the address table
+        fin->stream(FILESTREAM_CHUNK_SIZE, true);
 
         fin->addU32(m_signature);
         if(g_game.getFeature(Otc::GameSpritesU32))
@@ -81,32 +83,36 @@ void SpriteManager::saveSpr(std::string fileName)
         else
             fin->addU16(m_spritesCount);
 
-        uint32 offset = fin->tell();
-        uint32 spriteAddress = offset + 4 * m_spritesCount;
-        for(int i = 1; i <= m_spritesCount; i++)
-            fin->addU32(0);
-
+        std::vector<uint32> fromAddresses(m_spritesCount);
+        uint32 spriteAddress = fin->tell() + 4 * m_spritesCount;
         for(int i = 1; i <= m_spritesCount; i++) {
             m_spritesFile->seek((i - 1) * 4 + m_spritesOffset);
             uint32 fromAdress = m_spritesFile->getU32();
+            fromAddresses[i - 1] = fromAdress;
             if(fromAdress != 0) {
-                fin->seek(offset + (i - 1) * 4);
                 fin->addU32(spriteAddress);
-                fin->seek(spriteAddress);
 
-                m_spritesFile->seek(fromAdress);
-                fin->addU8(m_spritesFile->getU8());
-                fin->addU8(m_spritesFile->getU8());
-                fin->addU8(m_spritesFile->getU8());
+                // color key and data size
+                m_spritesFile->seek(fromAdress + 3);
+                spriteAddress += 5 + m_spritesFile->getU16();
+            } else
+                fin->addU32(0);
+        }
+
+        char spriteData[SPRITE_DATA_SIZE];
+        for(uint32 fromAdress : fromAddresses) {
+            if(fromAdress == 0)
+                continue;
 
-                uint16 dataSize = m_spritesFile->getU16();
-                fin->addU16(dataSize);
-                char spriteData[SPRITE_DATA_SIZE];
-                m_spritesFile->read(spriteData, dataSize);
-                fin->write(spriteData, dataSize);
+            m_spritesFile->seek(fromAdress);
+            fin->addU8(m_spritesFile->getU8());
+            fin->addU8(m_spritesFile->getU8());
+            fin->addU8(m_spritesFile->getU8());
 
-                spriteAddress = fin->tell();
-            }
+            uint16 dataSize = m_spritesFile->getU16();
+            fin->addU16(dataSize);
+            m_spritesFile->read(spriteData, dataSize);
+            fin->write(spriteData, dataSize);
             //TODO: Check for overwritten sprites.
         }
 
@@ -37,6 +37,7 @@ ThingType::ThingType()
     m_category = ThingInvalidCategory;
     m_id = 0;
     m_null = true;
+    m_flags = 0;
     m_exactSize = 0;
     m_realSize = 0;
     m_animator = nullptr;
@@ -44,6 +45,8 @@ ThingType::ThingType()
     m_animationPhases = 0;
     m_layers = 0;
     m_elevation = 0;
+    m_groundSpeed = 0;
+    m_minimapColor = 0;
     m_opacity = 1.0f;
 }
 
@@ -167,7 +170,7 @@ void ThingType::unserialize(uint16 clientId, ThingCategory category, const FileS
              * "Item Charges" flag.
              */
             if(attr == 8) {
-                m_attribs.set(ThingAttrChargeable, true);
+                setAttr(ThingAttrChargeable, true);
                 continue;
             } else if(attr > 8)
                 attr -= 1;
@@ -223,14 +226,14 @@ void ThingType::unserialize(uint16 clientId, ThingCategory category, const FileS
                     m_displacement.x = 8;
                     m_displacement.y = 8;
                 }
-                m_attribs.set(attr, true);
+                setAttr(attr, true);
                 break;
             }
             case ThingAttrLight: {
                 Light light;
                 light.intensity = fin->getU16();
                 light.color = fin->getU16();
-                m_attribs.set(attr, light);
+                setAttr(attr, light);
                 break;
             }
             case ThingAttrMarket: {
@@ -241,12 +244,12 @@ void ThingType::unserialize(uint16 clientId, ThingCategory category, const FileS
                 market.name = fin->getString();
                 market.restrictVocation = fin->getU16();
                 market.requiredLevel = fin->getU16();
-                m_attribs.set(attr, market);
+                setAttr(attr, market);
                 break;
             }
             case ThingAttrElevation: {
                 m_elevation = fin->getU16();
-                m_attribs.set(attr, m_elevation);
+                setAttr(attr, m_elevation);
                 break;
             }
             case ThingAttrUsable:
@@ -256,10 +259,10 @@ void ThingType::unserialize(uint16 clientId, ThingCategory category, const FileS
             case ThingAttrMinimapColor:
             case ThingAttrCloth:
             case ThingAttrLensHelp:
-                m_attribs.set(attr, fin->getU16());
+                setAttr(attr, fin->getU16());
                 break;
             default:
-                m_attribs.set(attr, true);
+                setAttr(attr, true);
                 break;
         };
     }
@@ -268,6 +271,8 @@ void ThingType::unserialize(uint16 clientId, ThingCategory category, const FileS
         stdext::throw_exception(stdext::format("corrupt data (id: %d, category: %d, count: %d, lastAttr: %d)",
             m_id, m_category, count, attr));
 
+    updateHotAttrs();
+
     bool hasFrameGroups = (category == ThingCategoryCreature && g_game.getFeature(Otc::GameIdleAnimations));
     uint8 groupCount = hasFrameGroups ? fin->getU8() : 1;
 
@@ -323,6 +328,155 @@ void ThingType::unserialize(uint16 clientId, ThingCategory category, const FileS
     m_texturesFramesOffsets.resize(m_animationPhases);
 }
 
+void ThingType::serializeCache(const FileStreamPtr& fout)
+{
+    for(int attr = 0; attr < ThingLastAttr; ++attr) {
+        if(!hasAttr((ThingAttr)attr))
+            continue;
+
+        fout->addU8(attr);
+        switch(attr) {
+            case ThingAttrLight: {
+                Light light = m_attribs.get<Light>(attr);
+                fout->addU8(light.intensity);
+                fout->addU8(light.color);
+                break;
+            }
+            case ThingAttrMarket: {
+                MarketData market = m_attribs.get<MarketData>(attr);
+                fout->addU16(market.category);
+                fout->addU16(market.tradeAs);
+                fout->addU16(market.showAs);
+                fout->addString(market.name);
+                fout->addU16(market.restrictVocation);
+                fout->addU16(market.requiredLevel);
+                break;
+            }
+            case ThingAttrElevation:
+                fout->addU16(m_elevation);
+                break;
+            case ThingAttrUsable:
+            case ThingAttrGround:
+            case ThingAttrWritable:
+            case ThingAttrWritableOnce:
+            case ThingAttrMinimapColor:
+            case ThingAttrCloth:
+            case ThingAttrLensHelp:
+                fout->addU16(m_attribs.get<uint16>(attr));
+                break;
+            default:
+                break;
+        }
+    }
+    fout->addU8(ThingLastAttr);
+
+    fout->add16(m_displacement.x);
+    fout->add16(m_displacement.y);
+    fout->addU8(m_size.width());
+    fout->addU8(m_size.height());
+    fout->addU16(m_exactSize);
+    fout->addU16(m_realSize);
+    fout->addU8(m_layers);
+    fout->addU8(m_numPatternX);
+    fout->addU8(m_numPatternY);
+    fout->addU8(m_numPatternZ);
+    fout->addU16(m_animationPhases);
+
+    if(m_animator) {
+        fout->addU8(m_animator->getAnimationPhases());
+        m_animator->serialize(fout);
+    } else
+        fout->addU8(0);
+
+    fout->addU16(m_spritesIndex.size());
+    for(int spriteId : m_spritesIndex)
+        fout->addU32(spriteId);
+}
+
+void ThingType::unserializeCache(uint16 clientId, ThingCategory category, const FileStreamPtr& fin)
+{
+    m_null = false;
+    m_id = clientId;
+    m_category = category;
+
+    int attr;
+    while((attr = fin->getU8()) != ThingLastAttr) {
+        switch(attr) {
+            case ThingAttrLight: {
+                Light light;
+                light.intensity = fin->getU8();
+                light.color = fin->getU8();
+                setAttr(attr, light);
+                break;
+            }
+            case ThingAttrMarket: {
+                MarketData market;
+                market.category = fin->getU16();
+                market.tradeAs = fin->getU16();
+                market.showAs = fin->getU16();
+                market.name = fin->getString();
+                market.restrictVocation = fin->getU16();
+                market.requiredLevel = fin->getU16();
+                setAttr(attr, market);
+                break;
+            }
+            case ThingAttrElevation:
+                m_elevation = fin->getU16();
+                setAttr(attr, m_elevation);
+                break;
+            case ThingAttrUsable:
+            case ThingAttrGround:
+            case ThingAttrWritable:
+            case ThingAttrWritableOnce:
+            case ThingAttrMinimapColor:
+            case ThingAttrCloth:
+            case ThingAttrLensHelp:
+                setAttr(attr, fin->getU16());
+                break;
+            default:
+                setAttr(attr, true);
+                break;
+        }
+    }
+
+    updateHotAttrs();
+
+    m_displacement.x = fin->get16();
+    m_displacement.y = fin->get16();
+    uint8 width = fin->getU8();
+    uint8 height = fin->getU8();
+    m_size = Size(width, height);
+    m_exactSize = fin->getU16();
+    m_realSize = fin->getU16();
+    m_layers = fin->getU8();
+    m_numPatternX = fin->getU8();
+    m_numPatternY = fin->getU8();
+    m_numPatternZ = fin->getU8();
+    m_animationPhases = fin->getU16();
+
+    int animatorPhases = fin->getU8();
+    if(animatorPhases > 0) {
+        m_animator = AnimatorPtr(new Animator);
+        m_animator->unserialize(animatorPhases, fin);
+    }
+
+    m_spritesIndex.resize(fin->getU16());
+    for(int& spriteId : m_spritesIndex)
+        spriteId = fin->getU32();
+
+    m_textures.resize(m_animationPhases);
+    m_texturesFramesRects.resize(m_animationPhases);
+    m_texturesFramesOriginRects.resize(m_animationPhases);
+    m_texturesFramesOffsets.resize(m_animationPhases);
+}
+
+void ThingType::updateHotAttrs()
+{
+    m_groundSpeed = m_attribs.get<uint16>(ThingAttrGround);
+    m_minimapColor = m_attribs.get<uint16>(ThingAttrMinimapColor);
+    m_light = m_attribs.get<Light>(ThingAttrLight);
+}
+
 void ThingType::exportImage(std::string fileName)
 {
     if(m_null)
@@ -359,14 +513,14 @@ void ThingType::unserializeOtml(const OTMLNodePtr& node)
         if(node2->tag() == "opacity")
             m_opacity = node2->value<float>();
         else if(node2->tag() == "notprewalkable")
-            m_attribs.set(ThingAttrNotPreWalkable, node2->value<bool>());
+            setAttr(ThingAttrNotPreWalkable, node2->value<bool>());
         else if(node2->tag() == "image")
             m_customImage = node2->value();
         else if(node2->tag() == "full-ground") {
             if(node2->value<bool>())
-                m_attribs.set(ThingAttrFullGround, true);
+                setAttr(ThingAttrFullGround, true);
             else
-                m_attribs.remove(ThingAttrFullGround);
+                removeAttr(ThingAttrFullGround);
         }
     }
 }
@@ -568,7 +722,7 @@ int ThingType::getExactSize(int layer, int xPattern, int yPattern, int zPattern,
 void ThingType::setPathable(bool var)
 {
     if(var == true)
-        m_attribs.remove(ThingAttrNotPathable);
+        removeAttr(ThingAttrNotPathable);
     else
-        m_attribs.set(ThingAttrNotPathable, true);
+        setAttr(ThingAttrNotPathable, true);
 }
\ No newline at end of file
@@ -129,6 +129,9 @@ public:
     void unserializeOtml(const OTMLNodePtr& node);
 
     void serialize(const FileStreamPtr& fin);
+    /// Parsed form used by the thing type cache, independent of the client version
+    void serializeCache(const FileStreamPtr& fout);
+    void unserializeCache(uint16 clientId, ThingCategory category, const FileStreamPtr& fin);
     void exportImage(std::string fileName);
 
     void draw(const Point& dest, float scaleFactor, int layer, int xPattern, int yPattern, int zPattern, int animationPhase, LightView *lightView = nullptr);
@@ -136,7 +139,7 @@ public:
     uint16 getId() { return m_id; }
     ThingCategory getCategory() { return m_category; }
     bool isNull() { return m_null; }
-    bool hasAttr(ThingAttr attr) { return m_attribs.has(attr); }
+    bool hasAttr(ThingAttr attr) { return attrFlag(attr) ? hasFlag(attr) : m_attribs.has(attr); }
 
     Size getSize() { return m_size; }
     int getWidth() { return m_size.width(); }
@@ -154,61 +157,75 @@ public:
     int getDisplacementY() { return getDisplacement().y; }
     int getElevation() { return m_elevation; }
 
-    int getGroundSpeed() { return m_attribs.get<uint16>(ThingAttrGround); }
-    int getMaxTextLength() { return m_attribs.has(ThingAttrWritableOnce) ? m_attribs.get<uint16>(ThingAttrWritableOnce) : m_attribs.get<uint16>(ThingAttrWritable); }
-    Light getLight() { return m_attribs.get<Light>(ThingAttrLight); }
-    int getMinimapColor() { return m_attribs.get<uint16>(ThingAttrMinimapColor); }
+    int getGroundSpeed() { return m_groundSpeed; }
+    int getMaxTextLength() { return hasFlag(ThingAttrWritableOnce) ? m_attribs.get<uint16>(ThingAttrWritableOnce) : m_attribs.get<uint16>(ThingAttrWritable); }
+    Light getLight() { return m_light; }
+    int getMinimapColor() { return m_minimapColor; }
     int getLensHelp() { return m_attribs.get<uint16>(ThingAttrLensHelp); }
     int getClothSlot() { return m_attribs.get<uint16>(ThingAttrCloth); }
     MarketData getMarketData() { return m_attribs.get<MarketData>(ThingAttrMarket); }
-    bool isGround() { return m_attribs.has(ThingAttrGround); }
-    bool isGroundBorder() { return m_attribs.has(ThingAttrGroundBorder); }
-    bool isOnBottom() { return m_attribs.has(ThingAttrOnBottom); }
-    bool isOnTop() { return m_attribs.has(ThingAttrOnTop); }
-    bool isContainer() { return m_attribs.has(ThingAttrContainer); }
-    bool isStackable() { return m_attribs.has(ThingAttrStackable); }
-    bool isForceUse() { return m_attribs.has(ThingAttrForceUse); }
-    bool isMultiUse() { return m_attribs.has(ThingAttrMultiUse); }
-    bool isWritable() { return m_attribs.has(ThingAttrWritable); }
-    bool isChargeable() { return m_attribs.has(ThingAttrChargeable); }
-    bool isWritableOnce() { return m_attribs.has(ThingAttrWritableOnce); }
-    bool isFluidContainer() { return m_attribs.has(ThingAttrFluidContainer); }
-    bool isSplash() { return m_attribs.has(ThingAttrSplash); }
-    bool isNotWalkable() { return m_attribs.has(ThingAttrNotWalkable); }
-    bool isNotMoveable() { return m_attribs.has(ThingAttrNotMoveable); }
-    bool blockProjectile() { return m_attribs.has(ThingAttrBlockProjectile); }
-    bool isNotPathable() { return m_attribs.has(ThingAttrNotPathable); }
-    bool isPickupable() { return m_attribs.has(ThingAttrPickupable); }
-    bool isHangable() { return m_attribs.has(ThingAttrHangable); }
-    bool isHookSouth() { return m_attribs.has(ThingAttrHookSouth); }
-    bool isHookEast() { return m_attribs.has(ThingAttrHookEast); }
-    bool isRotateable() { return m_attribs.has(ThingAttrRotateable); }
-    bool hasLight() { return m_attribs.has(ThingAttrLight); }
-    bool isDontHide() { return m_attribs.has(ThingAttrDontHide); }
-    bool isTranslucent() { return m_attribs.has(ThingAttrTranslucent); }
-    bool hasDisplacement() { return m_attribs.has(ThingAttrDisplacement); }
-    bool hasElevation() { return m_attribs.has(ThingAttrElevation); }
-    bool isLyingCorpse() { return m_attribs.has(ThingAttrLyingCorpse); }
-    bool isAnimateAlways() { return m_attribs.has(ThingAttrAnimateAlways); }
-    bool hasMiniMapColor() { return m_attribs.has(ThingAttrMinimapColor); }
-    bool hasLensHelp() { return m_attribs.has(ThingAttrLensHelp); }
-    bool isFullGround() { return m_attribs.has(ThingAttrFullGround); }
-    bool isIgnoreLook() { return m_attribs.has(ThingAttrLook); }
-    bool isCloth() { return m_attribs.has(ThingAttrCloth); }
-    bool isMarketable() { return m_attribs.has(ThingAttrMarket); }
-    bool isUsable() { return m_attribs.has(ThingAttrUsable); }
-    bool isWrapable() { return m_attribs.has(ThingAttrWrapable); }
-    bool isUnwrapable() { return m_attribs.has(ThingAttrUnwrapable); }
-    bool isTopEffect() { return m_attribs.has(ThingAttrTopEffect); }
+    bool isGround() { return hasFlag(ThingAttrGround); }
+    bool isGroundBorder() { return hasFlag(ThingAttrGroundBorder); }
+    bool isOnBottom() { return hasFlag(ThingAttrOnBottom); }
+    bool isOnTop() { return hasFlag(ThingAttrOnTop); }
+    bool isContainer() { return hasFlag(ThingAttrContainer); }
+    bool isStackable() { return hasFlag(ThingAttrStackable); }
+    bool isForceUse() { return hasFlag(ThingAttrForceUse); }
+    bool isMultiUse() { return hasFlag(ThingAttrMultiUse); }
+    bool isWritable() { return hasFlag(ThingAttrWritable); }
+    bool isChargeable() { return hasFlag(ThingAttrChargeable); }
+    bool isWritableOnce() { return hasFlag(ThingAttrWritableOnce); }
+    bool isFluidContainer() { return hasFlag(ThingAttrFluidContainer); }
+    bool isSplash() { return hasFlag(ThingAttrSplash); }
+    bool isNotWalkable() { return hasFlag(ThingAttrNotWalkable); }
+    bool isNotMoveable() { return hasFlag(ThingAttrNotMoveable); }
+    bool blockProjectile() { return hasFlag(ThingAttrBlockProjectile); }
+    bool isNotPathable() { return hasFlag(ThingAttrNotPathable); }
+    bool isPickupable() { return hasFlag(ThingAttrPickupable); }
+    bool isHangable() { return hasFlag(ThingAttrHangable); }
+    bool isHookSouth() { return hasFlag(ThingAttrHookSouth); }
+    bool isHookEast() { return hasFlag(ThingAttrHookEast); }
+    bool isRotateable() { return hasFlag(ThingAttrRotateable); }
+    bool hasLight() { return hasFlag(ThingAttrLight); }
+    bool isDontHide() { return hasFlag(ThingAttrDontHide); }
+    bool isTranslucent() { return hasFlag(ThingAttrTranslucent); }
+    bool hasDisplacement() { return hasFlag(ThingAttrDisplacement); }
+    bool hasElevation() { return hasFlag(ThingAttrElevation); }
+    bool isLyingCorpse() { return hasFlag(ThingAttrLyingCorpse); }
+    bool isAnimateAlways() { return hasFlag(ThingAttrAnimateAlways); }
+    bool hasMiniMapColor() { return hasFlag(ThingAttrMinimapColor); }
+    bool hasLensHelp() { return hasFlag(ThingAttrLensHelp); }
+    bool isFullGround() { return hasFlag(ThingAttrFullGround); }
+    bool isIgnoreLook() { return hasFlag(ThingAttrLook); }
+    bool isCloth() { return hasFlag(ThingAttrCloth); }
+    bool isMarketable() { return hasFlag(ThingAttrMarket); }
+    bool isUsable() { return hasFlag(ThingAttrUsable); }
+    bool isWrapable() { return hasFlag(ThingAttrWrapable); }
+    bool isUnwrapable() { return hasFlag(ThingAttrUnwrapable); }
+    bool isTopEffect() { return hasFlag(ThingAttrTopEffect); }
 
     std::vector<int> getSprites() { return m_spritesIndex; }
 
     // additional
     float getOpacity() { return m_opacity; }
-    bool isNotPreWalkable() { return m_attribs.has(ThingAttrNotPreWalkable); }
+    bool isNotPreWalkable() { return hasFlag(ThingAttrNotPreWalkable); }
     void setPathable(bool var);
 
 private:
+    // flag word bit of an attribute, the attributes past ThingAttrTopEffect are packed after it
+    static constexpr uint64 attrFlag(int attr) {
+        return attr <= ThingAttrTopEffect ? (uint64)1 << attr :
+               attr == ThingAttrOpacity ? (uint64)1 << 38 :
+               attr == ThingAttrNotPreWalkable ? (uint64)1 << 39 :
+               attr == ThingAttrFloorChange ? (uint64)1 << 40 :
+               attr == ThingAttrNoMoveAnimation ? (uint64)1 << 41 :
+               attr == ThingAttrChargeable ? (uint64)1 << 42 : 0;
+    }
+    bool hasFlag(ThingAttr attr) { return (m_flags & attrFlag(attr)) != 0; }
+    template<typename T> void setAttr(int attr, const T& value) { m_attribs.set(attr, value); m_flags |= attrFlag(attr); }
+    void removeAttr(int attr) { m_attribs.remove(attr); m_flags &= ~attrFlag(attr); }
+    void updateHotAttrs();
+
     const TexturePtr& getTexture(int animationPhase);
     Size getBestTextureDimension(int w, int h, int count);
     uint getSpriteIndex(int w, int h, int l, int x, int y, int z, int a);
@@ -217,6 +234,7 @@ private:
     ThingCategory m_category;
     uint16 m_id;
     bool m_null;
+    uint64 m_flags;
     stdext::dynamic_storage<uint8> m_attribs;
 
     Size m_size;
@@ -228,6 +246,9 @@ private:
     int m_numPatternX, m_numPatternY, m_numPatternZ;
     int m_layers;
     int m_elevation;
+    uint16 m_groundSpeed;
+    uint16 m_minimapColor;
+    Light m_light;
     float m_opacity;
     std::string m_customImage;
 
@@ -32,11 +32,130 @@
 #include <framework/core/resourcemanager.h>
 #include <framework/core/filestream.h>
 #include <framework/core/binarytree.h>
-#include <framework/xml/tinyxml.h>
+#include <framework/xml/xmlreader.h>
+#include <framework/xml/xmlcache.h>
 #include <framework/otml/otml.h>
 
 ThingTypeManager g_things;
 
+enum {
+    DAT_CACHE_SIGNATURE = 0x4344544F, // OTDC
+    DAT_CACHE_VERSION = 1,
+    ITEMS_XML_CACHE_VERSION = 1
+};
+
+static void readItemsXml(const std::string& buffer, std::vector<ItemXmlData>& items)
+{
+    XmlReader reader(buffer);
+    if(!reader.next() || reader.token() != XmlReader::StartElement || reader.name() != "items")
+        stdext::throw_exception("invalid root tag name");
+
+    ItemXmlData *item = nullptr;
+    while(reader.next()) {
+        if(reader.token() != XmlReader::StartElement)
+            continue;
+
+        if(reader.depth() == 1) {
+            item = nullptr;
+            if(unlikely(reader.name() != "item"))
+                continue;
+
+            ItemXmlData data;
+            if(reader.readType<uint16>("id") != 0) {
+                for(const std::string& s : stdext::split(reader.attribute("id"), ";")) {
+                    std::vector<int32> ids = stdext::split<int32>(s, "-");
+                    if(ids.size() > 1)
+                        data.ids.push_back(std::make_pair(ids[0], ids[1]));
+                    else {
+                        int32 id = atoi(s.c_str());
+                        data.ids.push_back(std::make_pair(id, id));
+                    }
+                }
+            } else {
+                std::vector<int32> begin = stdext::split<int32>(reader.attribute("fromid"), ";");
+                std::vector<int32> end   = stdext::split<int32>(reader.attribute("toid"), ";");
+                if(!begin.empty() && begin[0] && begin.size() == end.size()) {
+                    for(size_t i = 0; i < begin.size(); ++i)
+                        data.ids.push_back(std::make_pair(begin[i], end[i]));
+                }
+            }
+
+            if(data.ids.empty())
+                continue;
+
+            data.name = reader.attribute("name");
+            data.hasDescription = false;
+            data.category = ItemCategoryInvalid;
+            items.push_back(data);
+            item = &items.back();
+        } else if(reader.depth() == 2 && item) {
+            std::string key = reader.attribute("key");
+            if(key.empty())
+                continue;
+
+            stdext::tolower(key);
+            if(key == "description") {
+                item->description = reader.attribute("value");
+                item->hasDescription = true;
+            } else if(key == "weapontype")
+                item->category = ItemCategoryWeapon;
+            else if(key == "ammotype")
+                item->category = ItemCategoryAmmunition;
+            else if(key == "armor")
+                item->category = ItemCategoryArmor;
+            else if(key == "charges")
+                item->category = ItemCategoryCharges;
+            else if(key == "type") {
+                std::string value = reader.attribute("value");
+                stdext::tolower(value);
+
+                if(value == "key")
+                    item->category = ItemCategoryKey;
+                else if(value == "magicfield")
+                    item->category = ItemCategoryMagicField;
+                else if(value == "teleport")
+                    item->category = ItemCategoryTeleport;
+                else if(value == "door")
+                    item->category = ItemCategoryDoor;
+            }
+        }
+    }
+}
+
+static void serializeItemsXml(const FileStreamPtr& fout, const std::vector<ItemXmlData>& items)
+{
+    fout->addU32(items.size());
+    for(const ItemXmlData& item : items) {
+        fout->addU32(item.ids.size());
+        for(const auto& range : item.ids) {
+            fout->add32(range.first);
+            fout->add32(range.second);
+        }
+        fout->addString(item.name);
+        fout->addU8(item.hasDescription);
+        if(item.hasDescription)
+            fout->addString(item.description);
+        fout->addU8(item.category);
+    }
+}
+
+static void unserializeItemsXml(const FileStreamPtr& fin, std::vector<ItemXmlData>& items)
+{
+    items.resize(fin->getU32());
+    for(ItemXmlData& item : items) {
+        item.ids.resize(fin->getU32());
+        for(auto& range : item.ids) {
+            range.first = fin->get32();
+            range.second = fin->get32();
+        }
+        item.name = fin->getString();
+        item.hasDescription = fin->getU8() != 0;
+        if(item.hasDescription)
+            item.description = fin->getString();
+        item.category = (ItemCategory)fin->getU8();
+    }
+}
+
 void ThingTypeManager::init()
 {
     m_nullThingType = ThingTypePtr(new ThingType);
@@ -48,6 +167,8 @@ void ThingTypeManager::init()
     m_datLoaded = false;
     m_xmlLoaded = false;
     m_otbLoaded = false;
+    m_datCachePending = 0;
+    m_itemNameIndexDirty = true;
     for(int i = 0; i < ThingLastCategory; ++i)
         m_thingTypes[i].resize(1, m_nullThingType);
     m_itemTypes.resize(1, m_nullItemType);
@@ -55,10 +176,14 @@ void ThingTypeManager::init()
 
 void ThingTypeManager::terminate()
 {
+    m_datCache = nullptr;
     for(int i = 0; i < ThingLastCategory; ++i)
         m_thingTypes[i].clear();
     m_itemTypes.clear();
     m_reverseItemTypes.clear();
+    m_itemNames.clear();
+    m_itemNameIds.clear();
+    m_itemNameIndexDirty = true;
     m_nullThingType = nullptr;
     m_nullItemType = nullptr;
 }
@@ -73,12 +198,14 @@ void ThingTypeManager::saveDat(std::string fileName)
         if(!fin)
             stdext::throw_exception(stdext::format("failed to open file '%s' for write", fileName));
 
-        fin->cache();
+        fin->stream();
 
         fin->addU32(m_datSignature);
 
-        for(int category = 0; category < ThingLastCategory; ++category)
+        for(int category = 0; category < ThingLastCategory; ++category) {
+            loadCachedThingTypes((ThingCategory)category);
             fin->addU16(m_thingTypes[category].size() - 1);
+        }
 
         for(int category = 0; category < ThingLastCategory; ++category) {
             uint16 firstId = 1;
@@ -102,7 +229,12 @@ bool ThingTypeManager::loadDat(std::string file)
     m_datLoaded = false;
     m_datSignature = 0;
     m_contentRevision = 0;
+    m_datCache = nullptr;
+    m_datCachePending = 0;
+    for(int category = 0; category < ThingLastCategory; ++category)
+        m_attrIndexBuilt[category].reset();
     try {
+        stdext::timer loadTimer;
         file = g_resources.guessFilePath(file, "dat");
 
         FileStreamPtr fin = g_resources.openFile(file);
@@ -110,23 +242,30 @@ bool ThingTypeManager::loadDat(std::string file)
         m_datSignature = fin->getU32();
         m_contentRevision = static_cast<uint16_t>(m_datSignature);
 
-        for(int category = 0; category < ThingLastCategory; ++category) {
-            int count = fin->getU16() + 1;
-            m_thingTypes[category].clear();
-            m_thingTypes[category].resize(count, m_nullThingType);
-        }
+        bool cached = loadDatCache(file);
+        if(!cached) {
+            for(int category = 0; category < ThingLastCategory; ++category) {
+                int count = fin->getU16() + 1;
+                m_thingTypes[category].clear();
+                m_thingTypes[category].resize(count, m_nullThingType);
+            }
 
-        for(int category = 0; category < ThingLastCategory; ++category) {
-            uint16 firstId = 1;
-            if(category == ThingCategoryItem)
-                firstId = 100;
-            for(uint16 id = firstId; id < m_thingTypes[category].size(); ++id) {
-                ThingTypePtr type(new ThingType);
-                type->unserialize(id, (ThingCategory)category, fin);
-                m_thingTypes[category][id] = type;
+            for(int category = 0; category < ThingLastCategory; ++category) {
+                uint16 firstId = 1;
+                if(category == ThingCategoryItem)
+                    firstId = 100;
+                for(uint16 id = firstId; id < m_thingTypes[category].size(); ++id) {
+                    ThingTypePtr type(new ThingType);
+                    type->unserialize(id, (ThingCategory)category, fin);
+                    m_thingTypes[category][id] = type;
+                }
             }
+
+            saveDatCache(file);
         }
 
+        g_logger.debug(stdext::format("Loaded dat '%s' in %d ms (%s)", file, (int)loadTimer.elapsed_millis(), cached ? "cached" : "parsed"));
+
         m_datLoaded = true;
         g_lua.callGlobalField("g_things", "onLoadDat", file);
         return true;
@@ -136,8 +275,170 @@ bool ThingTypeManager::loadDat(std::string file)
     }
 }
 
+bool ThingTypeManager::loadDatCache(const std::string& file)
+{
+    std::string cacheFile = getDatCacheFile();
+    ticks_t modTime;
+    uint size;
+    if(!g_resources.getFileInfo(file, modTime, size) || !g_resources.fileExists(cacheFile))
+        return false;
+
+    try {
+        FileStreamPtr fin = g_resources.openFile(cacheFile);
+        fin->cache();
+
+        if(fin->getU32() != DAT_CACHE_SIGNATURE || fin->getU16() != DAT_CACHE_VERSION ||
+           fin->getString() != file || fin->getU64() != (uint64)modTime || fin->getU32() != size ||
+           fin->getU32() != m_datSignature || fin->getU16() != g_game.getClientVersion() ||
+           fin->getU32() != getDatCacheFeatures())
+            return false;
+
+        std::vector<uint32> offsets[ThingLastCategory];
+        for(int category = 0; category < ThingLastCategory; ++category) {
+            offsets[category].resize(fin->getU32(), 0);
+            int firstId = category == ThingCategoryItem ? 100 : 1;
+            for(int id = firstId; id < (int)offsets[category].size(); ++id) {
+                offsets[category][id] = fin->getU32();
+                if(offsets[category][id] >= fin->size())
+                    stdext::throw_exception("invalid thing type offset");
+            }
+        }
+
+        m_datCachePending = 0;
+        for(int category = 0; category < ThingLastCategory; ++category) {
+            int firstId = category == ThingCategoryItem ? 100 : 1;
+            m_thingTypes[category].clear();
+            m_thingTypes[category].resize(offsets[category].size(), m_nullThingType);
+            for(int id = firstId; id < (int)offsets[category].size(); ++id) {
+                m_thingTypes[category][id] = nullptr;
+                m_datCachePending++;
+            }
+            m_datCacheOffsets[category].swap(offsets[category]);
+        }
+
+        m_datCache = fin;
+        return true;
+    } catch(stdext::exception& e) {
+        g_logger.debug(stdext::format("Discarding thing type cache '%s': %s", cacheFile, e.what()));
+    }
+    return false;
+}
+
+void ThingTypeManager::saveDatCache(const std::string& file)
+{
+    ticks_t modTime;
+    uint size;
+    if(g_resources.getWriteDir().empty() || !g_resources.getFileInfo(file, modTime, size))
+        return;
+
+    std::string cacheFile = getDatCacheFile();
+    try {
+        g_resources.makeDir("thingcache");
+        FileStreamPtr fout = g_resources.createFile(cacheFile);
+        fout->stream();
+
+        fout->addU32(DAT_CACHE_SIGNATURE);
+        fout->addU16(DAT_CACHE_VERSION);
+        fout->addString(file);
+        fout->addU64(modTime);
+        fout->addU32(size);
+        fout->addU32(m_datSignature);
+        fout->addU16(g_game.getClientVersion());
+        fout->addU32(getDatCacheFeatures());
+
+        // offsets are filled once the thing types were written
+        uint offsetsPos = fout->tell();
+        for(int category = 0; category < ThingLastCategory; ++category) {
+            int firstId = category == ThingCategoryItem ? 100 : 1;
+            fout->addU32(m_thingTypes[category].size());
+            for(int id = firstId; id < (int)m_thingTypes[category].size(); ++id)
+                fout->addU32(0);
+        }
+
+        std::vector<uint32> offsets;
+        for(int category = 0; category < ThingLastCategory; ++category) {
+            int firstId = category == ThingCategoryItem ? 100 : 1;
+            for(int id = firstId; id < (int)m_thingTypes[category].size(); ++id) {
+                offsets.push_back(fout->tell());
+                m_thingTypes[category][id]->serializeCache(fout);
+            }
+        }
+
+        FileStreamPtr table(new FileStream(cacheFile, std::string()));
+        auto it = offsets.begin();
+        for(int category = 0; category < ThingLastCategory; ++category) {
+            int firstId = category == ThingCategoryItem ? 100 : 1;
+            table->addU32(m_thingTypes[category].size());
+            for(int id = firstId; id < (int)m_thingTypes[category].size(); ++id)
+                table->addU32(*it++);
+        }
+        fout->patch(offsetsPos, table->data(), table->size());
+
+        fout->flush();
+        fout->close();
+    } catch(stdext::exception& e) {
+        g_logger.debug(stdext::format("Unable to save thing type cache '%s': %s", cacheFile, e.what()));
+    }
+}
+
+std::string ThingTypeManager::getDatCacheFile()
+{
+    return stdext::format("/thingcache/%08x-%d-%d.otdc", m_datSignature, g_game.getClientVersion(), getDatCacheFeatures());
+}
+
+uint32 ThingTypeManager::getDatCacheFeatures()
+{
+    // features changing how the dat is parsed
+    uint32 features = 0;
+    if(g_game.getFeature(Otc::GameEnhancedAnimations))
+        features |= 1;
+    if(g_game.getFeature(Otc::GameIdleAnimations))
+        features |= 2;
+    if(g_game.getFeature(Otc::GameSpritesU32))
+        features |= 4;
+    return features;
+}
+
+const ThingTypePtr& ThingTypeManager::loadCachedThingType(uint16 id, ThingCategory category)
+{
+    std::lock_guard<std::mutex> lock(m_datCacheMutex);
+
+    // another thread may have read it while this one waited
+    ThingTypePtr& type = m_thingTypes[category][id];
+    if(type)
+        return type;
+
+    try {
+        ThingTypePtr cachedType(new ThingType);
+        m_datCache->seek(m_datCacheOffsets[category][id]);
+        cachedType->unserializeCache(id, category, m_datCache);
+        type = cachedType;
+    } catch(stdext::exception& e) {
+        g_logger.error(stdext::format("Unable to read cached thing type %d in category %d: %s", id, category, e.what()));
+        type = m_nullThingType;
+    }
+
+    // everything was read, the cache data is no longer needed
+    if(--m_datCachePending == 0) {
+        m_datCache = nullptr;
+        for(int i = 0; i < ThingLastCategory; ++i)
+            std::vector<uint32>().swap(m_datCacheOffsets[i]);
+    }
+    return type;
+}
+
+void ThingTypeManager::loadCachedThingTypes(ThingCategory category)
+{
+    for(int id = 0; m_datCache && id < (int)m_thingTypes[category].size(); ++id) {
+        if(!m_thingTypes[category][id])
+            loadCachedThingType(id, category);
+    }
+}
+
 bool ThingTypeManager::loadOtml(std::string file)
 {
+    for(int category = 0; category < ThingLastCategory; ++category)
+        m_attrIndexBuilt[category].reset();
     try {
         file = g_resources.guessFilePath(file, "otml");
 
@@ -180,39 +481,41 @@ void ThingTypeManager::loadOtb(const std::string& file)
         if(signature != 0)
             stdext::throw_exception("invalid otb file");
 
-        BinaryTreePtr root = fin->getBinaryTree();
-        root->skip(1); // otb first byte is always 0
+        BinaryTreeReader root(fin);
+        root.skip(1); // otb first byte is always 0
 
-        signature = root->getU32();
+        signature = root.getU32();
         if(signature != 0)
             stdext::throw_exception("invalid otb file");
 
-        uint8 rootAttr = root->getU8();
+        uint8 rootAttr = root.getU8();
         if(rootAttr == 0x01) { // OTB_ROOT_ATTR_VERSION
-            uint16 size = root->getU16();
+            uint16 size = root.getU16();
             if(size != 4 + 4 + 4 + 128)
                 stdext::throw_exception("invalid otb root attr version size");
 
-            m_otbMajorVersion = root->getU32();
-            m_otbMinorVersion = root->getU32();
-            root->skip(4); // buildNumber
-            root->skip(128); // description
+            m_otbMajorVersion = root.getU32();
+            m_otbMinorVersion = root.getU32();
+            root.skip(4); // buildNumber
+            root.skip(128); // description
         }
 
         m_reverseItemTypes.clear();
-        m_itemTypes.resize(root->getChildren().size() + 1, m_nullItemType);
-        m_reverseItemTypes.resize(root->getChildren().size() + 1, m_nullItemType);
+        m_reverseItemTypes.resize(1, m_nullItemType);
 
-        for(const BinaryTreePtr& node : root->getChildren()) {
+        // item types are read in a single pass, the lists grow as ids show up
+        while(root.enterChild()) {
             ItemTypePtr itemType(new ItemType);
-            itemType->unserialize(node);
+            itemType->unserialize(root);
             addItemType(itemType);
+            root.leaveNode();
 
             uint16 clientId = itemType->getClientId();
             if(unlikely(clientId >= m_reverseItemTypes.size()))
-                m_reverseItemTypes.resize(clientId + 1);
+                m_reverseItemTypes.resize(clientId + 1, m_nullItemType);
             m_reverseItemTypes[clientId] = itemType;
         }
+        root.leaveNode();
 
         m_otbLoaded = true;
         g_lua.callGlobalField("g_things", "onLoadOtb", file);
@@ -227,52 +530,47 @@ void ThingTypeManager::loadXml(const std::string& file)
         if(!isOtbLoaded())
             stdext::throw_exception("OTB must be loaded before XML");
 
-        TiXmlDocument doc;
-        doc.Parse(g_resources.readFileContents(file).c_str());
-        if(doc.Error())
-            stdext::throw_exception(stdext::format("failed to parse '%s': '%s'", file, doc.ErrorDesc()));
-
-        TiXmlElement* root = doc.FirstChildElement();
-        if(!root || root->ValueTStr() != "items")
-            stdext::throw_exception("invalid root tag name");
+        stdext::timer loadTimer;
+
+        // items.xml is only read again when it changed since the cache was written
+        std::vector<std::string> files(1, file);
+        std::vector<ItemXmlData> items;
+        bool cached = false;
+        if(FileStreamPtr fin = XmlCache::open("/xmlcache/items.otxc", files, ITEMS_XML_CACHE_VERSION)) {
+            try {
+                unserializeItemsXml(fin, items);
+                cached = true;
+            } catch(stdext::exception& e) {
+                g_logger.debug(stdext::format("Discarding items.xml cache: %s", e.what()));
+                items.clear();
+            }
+        }
 
-        for(TiXmlElement *element = root->FirstChildElement(); element; element = element->NextSiblingElement()) {
-            if(unlikely(element->ValueTStr() != "item"))
-                continue;
+        if(!cached) {
+            readItemsXml(g_resources.readFileContents(file), items);
+            if(FileStreamPtr fout = XmlCache::create("/xmlcache/items.otxc", files, ITEMS_XML_CACHE_VERSION)) {
+                serializeItemsXml(fout, items);
+                fout->flush();
+                fout->close();
+            }
+        }
 
-            uint16 id = element->readType<uint16>("id");
-            if(id != 0) {
-                std::vector<std::string> s_ids = stdext::split(element->Attribute("id"), ";");
-                for(const std::string& s : s_ids) {
-                    std::vector<int32> ids = stdext::split<int32>(s, "-");
-                    if(ids.size() > 1) {
-                        int32 i = ids[0];
-                        while(i <= ids[1])
-                            parseItemType(i++, element);
-                    } else
-                        parseItemType(atoi(s.c_str()), element);
-                }
-            } else {
-                std::vector<int32> begin = stdext::split<int32>(element->Attribute("fromid"), ";");
-                std::vector<int32> end   = stdext::split<int32>(element->Attribute("toid"), ";");
-                if(begin[0] && begin.size() == end.size()) {
-                    size_t size = begin.size();
-                    for(size_t i = 0; i < size; ++i)
-                        while(begin[i] <= end[i])
-                            parseItemType(begin[i]++, element);
-                }
+        for(const ItemXmlData& item : items) {
+            for(const auto& range : item.ids) {
+                for(int32 id = range.first; id <= range.second; ++id)
+                    parseItemType(id, item);
             }
         }
 
-        doc.Clear();
+        buildItemNameIndex();
         m_xmlLoaded = true;
-        g_logger.debug("items.xml read successfully.");
+        g_logger.debug(stdext::format("items.xml read successfully in %d ms (%s).", (int)loadTimer.elapsed_millis(), cached ? "cached" : "parsed"));
     } catch(std::exception& e) {
         g_logger.error(stdext::format("Failed to load '%s' (XML file): %s", file, e.what()));
     }
 }
 
-void ThingTypeManager::parseItemType(uint16 serverId, TiXmlElement* elem)
+void ThingTypeManager::parseItemType(uint16 serverId, const ItemXmlData& data)
 {
     ItemTypePtr itemType = nullptr;
 
@@ -295,37 +593,11 @@ void ThingTypeManager::parseItemType(uint16 serverId, TiXmlElement* elem)
     } else
         itemType = getItemType(serverId);
 
-    itemType->setName(elem->Attribute("name"));
-    for(TiXmlElement* attrib = elem->FirstChildElement(); attrib; attrib = attrib->NextSiblingElement()) {
-        std::string key = attrib->Attribute("key");
-        if(key.empty())
-            continue;
-
-        stdext::tolower(key);
-        if(key == "description")
-            itemType->setDesc(attrib->Attribute("value"));
-        else if(key == "weapontype")
-            itemType->setCategory(ItemCategoryWeapon);
-        else if(key == "ammotype")
-            itemType->setCategory(ItemCategoryAmmunition);
-        else if(key == "armor")
-            itemType->setCategory(ItemCategoryArmor);
-        else if(key == "charges")
-            itemType->setCategory(ItemCategoryCharges);
-        else if(key == "type") {
-            std::string value = attrib->Attribute("value");
-            stdext::tolower(value);
-
-            if(value == "key")
-                itemType->setCategory(ItemCategoryKey);
-            else if(value == "magicfield")
-                itemType->setCategory(ItemCategoryMagicField);
-            else if(value == "teleport")
-                itemType->setCategory(ItemCategoryTeleport);
-            else if(value == "door")
-                itemType->setCategory(ItemCategoryDoor);
-        }
-    }
+    itemType->setName(data.name);
+    if(data.hasDescription)
+        itemType->setDesc(data.description);
+    if(data.category != ItemCategoryInvalid)
+        itemType->setCategory(data.category);
 }
 
 void ThingTypeManager::addItemType(const ItemTypePtr& itemType)
@@ -334,6 +606,79 @@ void ThingTypeManager::addItemType(const ItemTypePtr& itemType)
     if(unlikely(id >= m_itemTypes.size()))
         m_itemTypes.resize(id + 1, m_nullItemType);
     m_itemTypes[id] = itemType;
+    m_itemNameIndexDirty = true;
+}
+
+void ThingTypeManager::buildItemNameIndex()
+{
+    std::map<std::string, std::vector<uint16>> names;
+    for(const ItemTypePtr& type : m_itemTypes) {
+        if(type == m_nullItemType)
+            continue;
+        std::string name = type->getName();
+        if(name.empty())
+            continue;
+        stdext::tolower(name);
+        names[name].push_back(type->getServerId());
+    }
+
+    m_itemNames.clear();
+    m_itemNameIds.clear();
+    m_itemNameText.clear();
+    m_itemNameSuffixes.clear();
+    m_itemNameSuffixOwners.clear();
+    std::vector<uint32> starts;
+    for(auto& it : names) {
+        starts.push_back(m_itemNameText.size());
+        m_itemNameText += it.first;
+        m_itemNameText += '\0'; // names never match across this separator
+        m_itemNames.push_back(it.first);
+        m_itemNameIds.push_back(std::move(it.second));
+    }
+
+    for(uint i = 0; i < m_itemNames.size(); ++i) {
+        for(uint j = 0; j < m_itemNames[i].size(); ++j)
+            m_itemNameSuffixes.push_back(starts[i] + j);
+    }
+
+    const char *text = m_itemNameText.c_str();
+    std::sort(m_itemNameSuffixes.begin(), m_itemNameSuffixes.end(), [text](uint32 a, uint32 b) {
+        return strcmp(text + a, text + b) < 0;
+    });
+
+    m_itemNameSuffixOwners.resize(m_itemNameSuffixes.size());
+    for(uint i = 0; i < m_itemNameSuffixes.size(); ++i)
+        m_itemNameSuffixOwners[i] = std::upper_bound(starts.begin(), starts.end(), m_itemNameSuffixes[i]) - starts.begin() - 1;
+
+    m_itemNameIndexDirty = false;
+}
+
+std::vector<uint16> ThingTypeManager::findItemIdsByName(const std::string& name)
+{
+    if(m_itemNameIndexDirty)
+        buildItemNameIndex();
+
+    auto it = std::lower_bound(m_itemNames.begin(), m_itemNames.end(), name);
+    if(it == m_itemNames.end() || *it != name)
+        return std::vector<uint16>();
+    return m_itemNameIds[it - m_itemNames.begin()];
+}
+
+const std::vector<uint64>& ThingTypeManager::getAttrIndex(ThingAttr attr, ThingCategory category)
+{
+    std::vector<uint64>& index = m_attrIndex[category][attr];
+    if(!m_attrIndexBuilt[category].test(attr)) {
+        loadCachedThingTypes(category);
+
+        const ThingTypeList& types = m_thingTypes[category];
+        index.assign((types.size() + 63) / 64, 0);
+        for(uint id = 0; id < types.size(); ++id) {
+            if(types[id]->hasAttr(attr))
+                index[id / 64] |= (uint64)1 << (id % 64);
+        }
+        m_attrIndexBuilt[category].set(attr);
+    }
+    return index;
 }
 
 const ItemTypePtr& ThingTypeManager::findItemTypeByClientId(uint16 id)
@@ -349,27 +694,57 @@ const ItemTypePtr& ThingTypeManager::findItemTypeByClientId(uint16 id)
 
 const ItemTypePtr& ThingTypeManager::findItemTypeByName(std::string name)
 {
-    for(const ItemTypePtr& it : m_itemTypes)
-        if(it->getName() == name)
-            return it;
-    return m_nullItemType;
+    stdext::tolower(name);
+    std::vector<uint16> ids = findItemIdsByName(name);
+    if(ids.empty())
+        return m_nullItemType;
+    return m_itemTypes[ids.front()];
 }
 
 ItemTypeList ThingTypeManager::findItemTypesByName(std::string name)
 {
     ItemTypeList ret;
-    for(const ItemTypePtr& it : m_itemTypes)
-        if(it->getName() == name)
-            ret.push_back(it);
+    stdext::tolower(name);
+    for(uint16 id : findItemIdsByName(name))
+        ret.push_back(m_itemTypes[id]);
     return ret;
 }
 
-ItemTypeList ThingTypeManager::findItemTypesByString(std::string name)
+ItemTypeList ThingTypeManager::findItemTypesByString(std::string str)
 {
+    if(str.empty())
+        return m_itemTypes;
+
+    if(m_itemNameIndexDirty)
+        buildItemNameIndex();
+
+    // every suffix starting with the string belongs to a name containing it
+    stdext::tolower(str);
+    const char *text = m_itemNameText.c_str();
+    auto begin = std::lower_bound(m_itemNameSuffixes.begin(), m_itemNameSuffixes.end(), str, [text](uint32 suffix, const std::string& value) {
+        return strncmp(text + suffix, value.c_str(), value.size()) < 0;
+    });
+    auto end = std::upper_bound(begin, m_itemNameSuffixes.end(), str, [text](const std::string& value, uint32 suffix) {
+        return strncmp(value.c_str(), text + suffix, value.size()) < 0;
+    });
+
+    // a name may contain the string more than once
+    std::vector<bool> seen(m_itemNames.size(), false);
+    std::vector<bool> found(m_itemTypes.size(), false);
+    for(auto it = begin; it != end; ++it) {
+        uint name = m_itemNameSuffixOwners[it - m_itemNameSuffixes.begin()];
+        if(seen[name])
+            continue;
+        seen[name] = true;
+        for(uint16 id : m_itemNameIds[name])
+            found[id] = true;
+    }
+
     ItemTypeList ret;
-    for(const ItemTypePtr& it : m_itemTypes)
-        if(it->getName().find(name) != std::string::npos)
-            ret.push_back(it);
+    for(uint id = 0; id < found.size(); ++id) {
+        if(found[id])
+            ret.push_back(m_itemTypes[id]);
+    }
     return ret;
 }
 
@@ -379,7 +754,8 @@ const ThingTypePtr& ThingTypeManager::getThingType(uint16 id, ThingCategory cate
         g_logger.error(stdext::format("invalid thing type client id %d in category %d", id, category));
         return m_nullThingType;
     }
-    return m_thingTypes[category][id];
+    const ThingTypePtr& type = m_thingTypes[category][id];
+    return type ? type : loadCachedThingType(id, category);
 }
 
 const ItemTypePtr& ThingTypeManager::getItemType(uint16 id)
@@ -392,11 +768,38 @@ const ItemTypePtr& ThingTypeManager::getItemType(uint16 id)
 }
 
 ThingTypeList ThingTypeManager::findThingTypeByAttr(ThingAttr attr, ThingCategory category)
+{
+    return findThingTypesByAttrs(std::vector<ThingAttr>(1, attr), category);
+}
+
+ThingTypeList ThingTypeManager::findThingTypesByAttrs(const std::vector<ThingAttr>& attrs, ThingCategory category)
 {
     ThingTypeList ret;
-    for(const ThingTypePtr& type : m_thingTypes[category])
-        if(type->hasAttr(attr))
-            ret.push_back(type);
+    if(category >= ThingLastCategory || attrs.empty())
+        return ret;
+
+    // intersect the attribute bitsets, then collect the remaining ids
+    std::vector<uint64> matches;
+    for(ThingAttr attr : attrs) {
+        if(attr >= ThingLastAttr)
+            return ret;
+        const std::vector<uint64>& index = getAttrIndex(attr, category);
+        if(matches.empty())
+            matches = index;
+        else {
+            for(uint i = 0; i < matches.size(); ++i)
+                matches[i] &= index[i];
+        }
+    }
+
+    const ThingTypeList& types = m_thingTypes[category];
+    for(uint i = 0; i < matches.size(); ++i) {
+        uint64 word = matches[i];
+        for(uint bit = 0; word; ++bit, word >>= 1) {
+            if(word & 1)
+                ret.push_back(types[i * 64 + bit]);
+        }
+    }
     return ret;
 }
 
@@ -414,6 +817,7 @@ const ThingTypeList& ThingTypeManager::getThingTypes(ThingCategory category)
     ThingTypeList ret;
     if(category >= ThingLastCategory)
         stdext::throw_exception(stdext::format("invalid thing type category %d", category));
+    loadCachedThingTypes(category);
     return m_thingTypes[category];
 }
 
@@ -26,9 +26,19 @@
 #include <framework/global.h>
 #include <framework/core/declarations.h>
 
+#include <bitset>
+
 #include "thingtype.h"
 #include "itemtype.h"
 
+struct ItemXmlData {
+    std::vector<std::pair<int32, int32>> ids;
+    std::string name;
+    std::string description;
+    bool hasDescription;
+    ItemCategory category;
+};
+
 class ThingTypeManager
 {
 public:
@@ -39,7 +49,7 @@ public:
     bool loadOtml(std::string file);
     void loadOtb(const std::string& file);
     void loadXml(const std::string& file);
-    void parseItemType(uint16 id, TiXmlElement *elem);
+    void parseItemType(uint16 id, const ItemXmlData& data);
 
     void saveDat(std::string fileName);
 
@@ -54,10 +64,14 @@ public:
 
     const ThingTypePtr& getThingType(uint16 id, ThingCategory category);
     const ItemTypePtr& getItemType(uint16 id);
-    ThingType* rawGetThingType(uint16 id, ThingCategory category) { return m_thingTypes[category][id].get(); }
+    ThingType* rawGetThingType(uint16 id, ThingCategory category) {
+        const ThingTypePtr& type = m_thingTypes[category][id];
+        return type ? type.get() : loadCachedThingType(id, category).get();
+    }
     ItemType* rawGetItemType(uint16 id) { return m_itemTypes[id].get(); }
 
     ThingTypeList findThingTypeByAttr(ThingAttr attr, ThingCategory category);
+    ThingTypeList findThingTypesByAttrs(const std::vector<ThingAttr>& attrs, ThingCategory category);
     ItemTypeList findItemTypeByCategory(ItemCategory category);
 
     const ThingTypeList& getThingTypes(ThingCategory category);
@@ -76,6 +90,16 @@ public:
     bool isValidOtbId(uint16 id) { return id >= 1 && id < m_itemTypes.size(); }
 
 private:
+    bool loadDatCache(const std::string& file);
+    void saveDatCache(const std::string& file);
+    std::string getDatCacheFile();
+    uint32 getDatCacheFeatures();
+    const ThingTypePtr& loadCachedThingType(uint16 id, ThingCategory category);
+    void loadCachedThingTypes(ThingCategory category);
+    void buildItemNameIndex();
+    std::vector<uint16> findItemIdsByName(const std::string& name);
+    const std::vector<uint64>& getAttrIndex(ThingAttr attr, ThingCategory category);
+
     ThingTypeList m_thingTypes[ThingLastCategory];
     ItemTypeList m_reverseItemTypes;
     ItemTypeList m_itemTypes;
@@ -91,6 +115,25 @@ private:
     uint32 m_otbMajorVersion;
     uint32 m_datSignature;
     uint16 m_contentRevision;
+
+    // thing types are read from the cache on first access, which may happen on map loading workers
+    std::mutex m_datCacheMutex;
+    FileStreamPtr m_datCache;
+    std::vector<uint32> m_datCacheOffsets[ThingLastCategory];
+    int m_datCachePending;
+
+    // lowercase item names sorted with the server ids using them, plus a
+    // suffix array over all names for substring searches
+    std::vector<std::string> m_itemNames;
+    std::vector<std::vector<uint16>> m_itemNameIds;
+    std::string m_itemNameText;
+    std::vector<uint32> m_itemNameSuffixes;
+    std::vector<uint32> m_itemNameSuffixOwners;
+    bool m_itemNameIndexDirty;
+
+    // one bit per thing type id, built on the first query of each attribute
+    std::vector<uint64> m_attrIndex[ThingLastCategory][ThingLastAttr];
+    std::bitset<ThingLastAttr> m_attrIndexBuilt[ThingLastCategory];
 };
 
 extern ThingTypeManager g_things;
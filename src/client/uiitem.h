@@ -34,10 +34,10 @@ public:
     void drawSelf(Fw::DrawPane drawPane);
 
     void setItemId(int id);
-    void setItemCount(int count) { if(m_item) m_item->setCount(count); }
-    void setItemSubType(int subType) { if(m_item) m_item->setSubType(subType); }
-    void setItemVisible(bool visible) { m_itemVisible = visible; }
-    void setItem(const ItemPtr& item) { m_item = item; }
+    void setItemCount(int count) { if(m_item) m_item->setCount(count); repaint(); }
+    void setItemSubType(int subType) { if(m_item) m_item->setSubType(subType); repaint(); }
+    void setItemVisible(bool visible) { m_itemVisible = visible; repaint(); }
+    void setItem(const ItemPtr& item) { m_item = item; repaint(); }
     void setVirtual(bool virt) { m_virtual = virt; }
     void clearItem() { setItemId(0); }
 
@@ -64,14 +64,7 @@ void UIMapAnchorLayout::addPositionAnchor(const UIWidgetPtr& anchoredWidget, Fw:
     if(!anchoredWidget)
         return;
 
-    assert(anchoredWidget != getParentWidget());
-
-    UIPositionAnchorPtr anchor(new UIPositionAnchor(anchoredEdge, hookedPosition, hookedEdge));
-    UIAnchorGroupPtr& anchorGroup = m_anchorsGroups[anchoredWidget];
-    if(!anchorGroup)
-        anchorGroup = UIAnchorGroupPtr(new UIAnchorGroup);
-
-    anchorGroup->addAnchor(anchor);
+    insertAnchor(anchoredWidget, UIPositionAnchorPtr(new UIPositionAnchor(anchoredEdge, hookedPosition, hookedEdge)));
 
     // layout must be updated because a new anchor got in
     update();
@@ -79,14 +72,22 @@ void UIMapAnchorLayout::addPositionAnchor(const UIWidgetPtr& anchoredWidget, Fw:
 
 void UIMapAnchorLayout::centerInPosition(const UIWidgetPtr& anchoredWidget, const Position& hookedPosition)
 {
-    addPositionAnchor(anchoredWidget, Fw::AnchorHorizontalCenter, hookedPosition, Fw::AnchorHorizontalCenter);
-    addPositionAnchor(anchoredWidget, Fw::AnchorVerticalCenter, hookedPosition, Fw::AnchorVerticalCenter);
+    if(!anchoredWidget)
+        return;
+
+    insertAnchor(anchoredWidget, UIPositionAnchorPtr(new UIPositionAnchor(Fw::AnchorHorizontalCenter, hookedPosition, Fw::AnchorHorizontalCenter)));
+    insertAnchor(anchoredWidget, UIPositionAnchorPtr(new UIPositionAnchor(Fw::AnchorVerticalCenter, hookedPosition, Fw::AnchorVerticalCenter)));
+    update();
 }
 
 void UIMapAnchorLayout::fillPosition(const UIWidgetPtr& anchoredWidget, const Position& hookedPosition)
 {
-    addPositionAnchor(anchoredWidget, Fw::AnchorLeft, hookedPosition, Fw::AnchorLeft);
-    addPositionAnchor(anchoredWidget, Fw::AnchorRight, hookedPosition, Fw::AnchorRight);
-    addPositionAnchor(anchoredWidget, Fw::AnchorTop, hookedPosition, Fw::AnchorTop);
-    addPositionAnchor(anchoredWidget, Fw::AnchorBottom, hookedPosition, Fw::AnchorBottom);
+    if(!anchoredWidget)
+        return;
+
+    insertAnchor(anchoredWidget, UIPositionAnchorPtr(new UIPositionAnchor(Fw::AnchorLeft, hookedPosition, Fw::AnchorLeft)));
+    insertAnchor(anchoredWidget, UIPositionAnchorPtr(new UIPositionAnchor(Fw::AnchorRight, hookedPosition, Fw::AnchorRight)));
+    insertAnchor(anchoredWidget, UIPositionAnchorPtr(new UIPositionAnchor(Fw::AnchorTop, hookedPosition, Fw::AnchorTop)));
+    insertAnchor(anchoredWidget, UIPositionAnchorPtr(new UIPositionAnchor(Fw::AnchorBottom, hookedPosition, Fw::AnchorBottom)));
+    update();
 }
@@ -46,6 +46,9 @@ void UIMinimap::drawSelf(Fw::DrawPane drawPane)
         return;
 
     g_minimap.draw(getPaddingRect(), getCameraPosition(), m_scale, m_color);
+
+    // the minimap follows the map state, so enclosing layers draw this directly
+    bypassLayers();
 }
 
 bool UIMinimap::setZoom(int zoom)
@@ -85,6 +85,7 @@ void UIProgressRect::drawSelf(Fw::DrawPane drawPane)
 void UIProgressRect::setPercent(float percent)
 {
     m_percent = stdext::clamp<float>((double)percent, 0.0, 100.0);
+    repaint();
 }
 
 void UIProgressRect::onStyleApply(const std::string& styleName, const OTMLNodePtr& styleNode)
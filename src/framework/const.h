@@ -282,6 +282,104 @@ namespace Fw
         LastWidgetState = 8192
     };
 
+    // style properties handled by the widget style parsers
+    enum StyleProperty {
+        StyleUnknown = 0,
+        StyleColor,
+        StyleX,
+        StyleY,
+        StylePos,
+        StyleWidth,
+        StyleHeight,
+        StyleRect,
+        StyleBackground,
+        StyleBackgroundColor,
+        StyleBackgroundOffsetX,
+        StyleBackgroundOffsetY,
+        StyleBackgroundOffset,
+        StyleBackgroundWidth,
+        StyleBackgroundHeight,
+        StyleBackgroundSize,
+        StyleBackgroundRect,
+        StyleIcon,
+        StyleIconSource,
+        StyleIconColor,
+        StyleIconOffsetX,
+        StyleIconOffsetY,
+        StyleIconOffset,
+        StyleIconWidth,
+        StyleIconHeight,
+        StyleIconSize,
+        StyleIconRect,
+        StyleIconClip,
+        StyleIconAlign,
+        StyleOpacity,
+        StyleRotation,
+        StyleEnabled,
+        StyleVisible,
+        StyleChecked,
+        StyleDraggable,
+        StyleOn,
+        StyleFocusable,
+        StyleAutoFocus,
+        StylePhantom,
+        StyleSize,
+        StyleFixedSize,
+        StyleClipping,
+        StyleRenderLayer,
+        StyleBorder,
+        StyleBorderWidth,
+        StyleBorderWidthTop,
+        StyleBorderWidthRight,
+        StyleBorderWidthBottom,
+        StyleBorderWidthLeft,
+        StyleBorderColor,
+        StyleBorderColorTop,
+        StyleBorderColorRight,
+        StyleBorderColorBottom,
+        StyleBorderColorLeft,
+        StyleMarginTop,
+        StyleMarginRight,
+        StyleMarginBottom,
+        StyleMarginLeft,
+        StyleMargin,
+        StylePaddingTop,
+        StylePaddingRight,
+        StylePaddingBottom,
+        StylePaddingLeft,
+        StylePadding,
+        StyleLayout,
+        StyleImageSource,
+        StyleImageOffsetX,
+        StyleImageOffsetY,
+        StyleImageOffset,
+        StyleImageWidth,
+        StyleImageHeight,
+        StyleImageSize,
+        StyleImageRect,
+        StyleImageClip,
+        StyleImageFixedRatio,
+        StyleImageRepeated,
+        StyleImageSmooth,
+        StyleImageColor,
+        StyleImageBorderTop,
+        StyleImageBorderRight,
+        StyleImageBorderBottom,
+        StyleImageBorderLeft,
+        StyleImageBorder,
+        StyleImageAutoResize,
+        StyleText,
+        StyleTextAlign,
+        StyleTextOffset,
+        StyleTextWrap,
+        StyleTextAutoResize,
+        StyleTextHorizontalAutoResize,
+        StyleTextVerticalAutoResize,
+        StyleTextOnlyUpperCase,
+        StyleFont,
+        StyleAnchor
+    };
+
     enum DrawPane {
         ForegroundPane = 1,
         BackgroundPane = 2,
@@ -26,7 +26,10 @@ AsyncDispatcher g_asyncDispatcher;
 
 void AsyncDispatcher::init()
 {
-    spawn_thread();
+    // leave one core for the main thread, but never run more than a few workers
+    int threads = std::max<int>(1, std::min<int>(4, (int)std::thread::hardware_concurrency() - 1));
+    for(int i = 0; i < threads; ++i)
+        spawn_thread();
 }
 
 void AsyncDispatcher::terminate()
@@ -179,6 +179,146 @@ Point BinaryTree::getPoint()
     return ret;
 }
 
+BinaryTreeReader::BinaryTreeReader(const FileStreamPtr& fin) :
+    m_fin(fin), m_depth(0)
+{
+    m_fin->cache();
+    m_data = m_fin->data();
+    m_size = m_fin->size();
+    m_pos = m_fin->tell();
+
+    if(m_pos >= m_size || m_data[m_pos] != BINARYTREE_NODE_START)
+        stdext::throw_exception("BinaryTreeReader: failed to read root node start");
+    m_pos++;
+    m_depth = 1;
+}
+
+BinaryTreeReader::BinaryTreeReader(const uint8 *data, uint size, uint pos) :
+    m_data(data), m_size(size), m_pos(pos), m_depth(0)
+{
+    if(m_pos >= m_size || m_data[m_pos] != BINARYTREE_NODE_START)
+        stdext::throw_exception("BinaryTreeReader: failed to read node start");
+    m_pos++;
+    m_depth = 1;
+}
+
+bool BinaryTreeReader::enterChild()
+{
+    skipProperties();
+    if(m_data[m_pos] != BINARYTREE_NODE_START)
+        return false;
+    m_pos++;
+    m_depth++;
+    return true;
+}
+
+void BinaryTreeReader::leaveNode()
+{
+    if(m_depth == 0)
+        stdext::throw_exception("BinaryTreeReader: no node to leave");
+
+    uint depth = 1;
+    while(depth > 0) {
+        skipProperties();
+        if(m_data[m_pos++] == BINARYTREE_NODE_START)
+            depth++;
+        else
+            depth--;
+    }
+
+    // keep the file position in sync once the whole tree was read
+    if(--m_depth == 0 && m_fin)
+        m_fin->seek(m_pos);
+}
+
+void BinaryTreeReader::skip(uint len)
+{
+    for(uint i = 0; i < len; ++i) {
+        if(!canRead())
+            stdext::throw_exception("BinaryTreeReader: skip failed");
+        m_pos += m_data[m_pos] == BINARYTREE_ESCAPE_CHAR ? 2 : 1;
+    }
+}
+
+uint8 BinaryTreeReader::getU8()
+{
+    uint8 buffer[1];
+    return *fetch(buffer, 1);
+}
+
+uint16 BinaryTreeReader::getU16()
+{
+    uint8 buffer[2];
+    return stdext::readULE16(fetch(buffer, 2));
+}
+
+uint32 BinaryTreeReader::getU32()
+{
+    uint8 buffer[4];
+    return stdext::readULE32(fetch(buffer, 4));
+}
+
+uint64 BinaryTreeReader::getU64()
+{
+    uint8 buffer[8];
+    return stdext::readULE64(fetch(buffer, 8));
+}
+
+std::string BinaryTreeReader::getString(uint16 len)
+{
+    if(len == 0)
+        len = getU16();
+
+    std::string ret(len, 0);
+    const uint8 *data = fetch((uint8*)&ret[0], len);
+    if(data != (const uint8*)ret.data())
+        ret.assign((const char*)data, len);
+    return ret;
+}
+
+Point BinaryTreeReader::getPoint()
+{
+    Point ret;
+    ret.x = getU8();
+    ret.y = getU8();
+    return ret;
+}
+
+const uint8 *BinaryTreeReader::fetch(uint8 *buffer, uint len)
+{
+    // most values have no escaped bytes and can be read in place
+    if(m_pos + len <= m_size) {
+        const uint8 *begin = m_data + m_pos;
+        uint i = 0;
+        while(i < len && begin[i] < BINARYTREE_ESCAPE_CHAR)
+            ++i;
+        if(i == len) {
+            m_pos += len;
+            return begin;
+        }
+    }
+
+    for(uint i = 0; i < len; ++i) {
+        if(!canRead())
+            stdext::throw_exception("BinaryTreeReader: read past the end of node");
+        if(m_data[m_pos] == BINARYTREE_ESCAPE_CHAR && ++m_pos >= m_size)
+            stdext::throw_exception("BinaryTreeReader: unexpected end of file");
+        buffer[i] = m_data[m_pos++];
+    }
+    return buffer;
+}
+
+void BinaryTreeReader::skipProperties()
+{
+    while(m_pos < m_size) {
+        uint8 byte = m_data[m_pos];
+        if(byte == BINARYTREE_NODE_START || byte == BINARYTREE_NODE_END)
+            return;
+        m_pos += byte == BINARYTREE_ESCAPE_CHAR ? 2 : 1;
+    }
+    stdext::throw_exception("BinaryTreeReader: unexpected end of file");
+}
+
 OutputBinaryTree::OutputBinaryTree(const FileStreamPtr& fin)
     : m_fin(fin)
 {
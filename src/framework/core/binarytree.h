@@ -63,6 +63,44 @@ private:
     uint m_startPos;
 };
 
+/// Reads a node tree in a single pass straight from a cached file, without allocating
+/// anything per node. Nodes are visited in file order:
+///   while(reader.enterChild()) { ...read node properties...; reader.leaveNode(); }
+class BinaryTreeReader
+{
+public:
+    BinaryTreeReader(const FileStreamPtr& fin);
+    /// Reads the node starting at pos of a buffer that outlives the reader, usable from worker threads
+    BinaryTreeReader(const uint8 *data, uint size, uint pos);
+
+    /// Skips what is left of the current node properties and enters its next child
+    bool enterChild();
+    /// Skips the rest of the current node, including all its children
+    void leaveNode();
+    uint getDepth() { return m_depth; }
+    uint tell() { return m_pos; }
+
+    void skip(uint len);
+    bool canRead() { return m_pos < m_size && m_data[m_pos] != BINARYTREE_NODE_START && m_data[m_pos] != BINARYTREE_NODE_END; }
+
+    uint8 getU8();
+    uint16 getU16();
+    uint32 getU32();
+    uint64 getU64();
+    std::string getString(uint16 len = 0);
+    Point getPoint();
+
+private:
+    const uint8 *fetch(uint8 *buffer, uint len);
+    void skipProperties();
+
+    FileStreamPtr m_fin;
+    const uint8 *m_data;
+    uint m_size;
+    uint m_pos;
+    uint m_depth;
+};
+
 class OutputBinaryTree : public stdext::shared_object
 {
 public:
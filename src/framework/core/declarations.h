@@ -35,6 +35,7 @@ class ScheduledEvent;
 class FileStream;
 class BinaryTree;
 class OutputBinaryTree;
+class BinaryTreeReader;
 
 typedef stdext::shared_object_ptr<Module> ModulePtr;
 typedef stdext::shared_object_ptr<Config> ConfigPtr;
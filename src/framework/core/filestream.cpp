@@ -23,15 +23,26 @@
 #include "filestream.h"
 #include "binarytree.h"
 #include <framework/core/application.h>
+#include <framework/core/asyncdispatcher.h>
 
 #include <physfs.h>
 
+struct FileStreamWriteBehind {
+    DataBuffer<uint8_t> buffer;
+    boost::shared_future<bool> pending;
+    bool writing = false;
+};
+
 FileStream::FileStream(const std::string& name, PHYSFS_File *fileHandle, bool writeable) :
     m_name(name),
     m_fileHandle(fileHandle),
     m_pos(0),
     m_writeable(writeable),
-    m_caching(false)
+    m_caching(false),
+    m_streaming(false),
+    m_chunkSize(0),
+    m_chunkOffset(0),
+    m_streamSize(0)
 {
 }
 
@@ -40,7 +51,11 @@ FileStream::FileStream(const std::string& name, const std::string& buffer) :
     m_fileHandle(nullptr),
     m_pos(0),
     m_writeable(false),
-    m_caching(true)
+    m_caching(true),
+    m_streaming(false),
+    m_chunkSize(0),
+    m_chunkOffset(0),
+    m_streamSize(0)
 {
     m_data.resize(buffer.length());
     memcpy(&m_data[0], &buffer[0], buffer.length());
@@ -75,8 +90,33 @@ void FileStream::cache()
     }
 }
 
+void FileStream::stream(uint chunkSize, bool backgroundFlush)
+{
+    if(!m_writeable || !m_fileHandle)
+        throwError("only writeable files can be streamed");
+
+    m_caching = true;
+    m_streaming = true;
+    m_chunkSize = std::max<uint>(chunkSize, 64);
+    m_chunkOffset = m_streamSize = PHYSFS_tell(m_fileHandle);
+    m_pos = 0;
+    m_data.reset();
+    m_data.reserve(m_chunkSize);
+    if(backgroundFlush) {
+        m_writeBehind.reset(new FileStreamWriteBehind);
+        m_writeBehind->buffer.reserve(m_chunkSize);
+    }
+}
+
 void FileStream::close()
 {
+    // a failed background write is reported by flush, here we only must not close under it
+    if(m_writeBehind)
+        waitWriteBehind();
+    m_writeBehind.reset();
+    m_patches.clear();
+    m_streaming = false;
+
     if(m_fileHandle && PHYSFS_isInit()) {
         if(!PHYSFS_close(m_fileHandle))
             throwError("close failed", true);
@@ -93,7 +133,10 @@ void FileStream::flush()
         throwError("filestream is not writeable");
 
     if(m_fileHandle) {
-        if(m_caching) {
+        if(m_streaming) {
+            writeChunk();
+            writePatches();
+        } else if(m_caching) {
             if(!PHYSFS_seek(m_fileHandle, 0))
                 throwError("flush seek failed", true);
             uint len = m_data.size();
@@ -133,7 +176,7 @@ void FileStream::write(const void *buffer, uint32 count)
         if(PHYSFS_write(m_fileHandle, buffer, 1, count) != count)
             throwError("write failed", true);
     } else {
-        m_data.grow(m_pos + count);
+        reserve(count);
         memcpy(&m_data[m_pos], buffer, count);
         m_pos += count;
     }
@@ -144,6 +187,18 @@ void FileStream::seek(uint32 pos)
     if(!m_caching) {
         if(!PHYSFS_seek(m_fileHandle, pos))
             throwError("seek failed", true);
+    } else if(m_streaming) {
+        if(pos > size())
+            throwError("seek failed");
+
+        // moving out of the buffered chunk starts a new one there
+        // and writes the pending patches, so later writes still win over them
+        if(pos < m_chunkOffset || pos > m_chunkOffset + m_data.size()) {
+            writeChunk();
+            writePatches();
+            m_chunkOffset = pos;
+        } else
+            m_pos = pos - m_chunkOffset;
     } else {
         if(pos > m_data.size())
             throwError("seek failed");
@@ -161,7 +216,7 @@ uint FileStream::size()
     if(!m_caching)
         return PHYSFS_fileLength(m_fileHandle);
     else
-        return m_data.size();
+        return std::max<uint>(m_streamSize, m_chunkOffset + m_data.size());
 }
 
 uint FileStream::tell()
@@ -169,7 +224,7 @@ uint FileStream::tell()
     if(!m_caching)
         return PHYSFS_tell(m_fileHandle);
     else
-        return m_pos;
+        return m_chunkOffset + m_pos;
 }
 
 bool FileStream::eof()
@@ -177,7 +232,7 @@ bool FileStream::eof()
     if(!m_caching)
         return PHYSFS_eof(m_fileHandle);
     else
-        return m_pos >= m_data.size();
+        return tell() >= size();
 }
 
 uint8 FileStream::getU8()
@@ -357,8 +412,8 @@ void FileStream::addU8(uint8 v)
         if(PHYSFS_write(m_fileHandle, &v, 1, 1) != 1)
             throwError("write failed", true);
     } else {
-        m_data.add(v);
-        m_pos++;
+        reserve(1);
+        m_data[m_pos++] = v;
     }
 }
 
@@ -368,7 +423,7 @@ void FileStream::addU16(uint16 v)
         if(PHYSFS_writeULE16(m_fileHandle, v) == 0)
             throwError("write failed", true);
     } else {
-        m_data.grow(m_pos + 2);
+        reserve(2);
         stdext::writeULE16(&m_data[m_pos], v);
         m_pos += 2;
     }
@@ -380,7 +435,7 @@ void FileStream::addU32(uint32 v)
         if(PHYSFS_writeULE32(m_fileHandle, v) == 0)
             throwError("write failed", true);
     } else {
-        m_data.grow(m_pos + 4);
+        reserve(4);
         stdext::writeULE32(&m_data[m_pos], v);
         m_pos += 4;
     }
@@ -392,7 +447,7 @@ void FileStream::addU64(uint64 v)
         if(PHYSFS_writeULE64(m_fileHandle, v) == 0)
             throwError("write failed", true);
     } else {
-        m_data.grow(m_pos + 8);
+        reserve(8);
         stdext::writeULE64(&m_data[m_pos], v);
         m_pos += 8;
     }
@@ -404,8 +459,8 @@ void FileStream::add8(int8 v)
         if(PHYSFS_write(m_fileHandle, &v, 1, 1) != 1)
             throwError("write failed", true);
     } else {
-        m_data.add(v);
-        m_pos++;
+        reserve(1);
+        m_data[m_pos++] = v;
     }
 }
 
@@ -415,7 +470,7 @@ void FileStream::add16(int16 v)
         if(PHYSFS_writeSLE16(m_fileHandle, v) == 0)
             throwError("write failed", true);
     } else {
-        m_data.grow(m_pos + 2);
+        reserve(2);
         stdext::writeSLE16(&m_data[m_pos], v);
         m_pos += 2;
     }
@@ -427,7 +482,7 @@ void FileStream::add32(int32 v)
         if(PHYSFS_writeSLE32(m_fileHandle, v) == 0)
             throwError("write failed", true);
     } else {
-        m_data.grow(m_pos + 4);
+        reserve(4);
         stdext::writeSLE32(&m_data[m_pos], v);
         m_pos += 4;
     }
@@ -439,7 +494,7 @@ void FileStream::add64(int64 v)
         if(PHYSFS_writeSLE64(m_fileHandle, v) == 0)
             throwError("write failed", true);
     } else {
-        m_data.grow(m_pos + 8);
+        reserve(8);
         stdext::writeSLE64(&m_data[m_pos], v);
         m_pos += 8;
     }
@@ -451,6 +506,119 @@ void FileStream::addString(const std::string& v)
     write(v.c_str(), v.length());
 }
 
+void FileStream::patch(uint pos, const void *data, uint len)
+{
+    if(!m_writeable)
+        throwError("filestream is not writeable");
+
+    if(!m_caching) {
+        uint pos2 = tell();
+        seek(pos);
+        write(data, len);
+        seek(pos2);
+    } else if(pos >= m_chunkOffset && pos + len <= m_chunkOffset + m_data.size())
+        memcpy(&m_data[pos - m_chunkOffset], data, len);
+    else if(m_streaming && pos + len <= size())
+        m_patches.push_back(std::make_pair(pos, std::string((const char*)data, len)));
+    else
+        throwError("patch out of bounds");
+}
+
+void FileStream::patchU16(uint pos, uint16 v)
+{
+    uint8 data[2];
+    stdext::writeULE16(data, v);
+    patch(pos, data, 2);
+}
+
+void FileStream::patchU32(uint pos, uint32 v)
+{
+    uint8 data[4];
+    stdext::writeULE32(data, v);
+    patch(pos, data, 4);
+}
+
+void FileStream::reserve(uint count)
+{
+    if(m_streaming && m_pos > 0 && m_pos + count > m_chunkSize)
+        writeChunk();
+    m_data.grow(m_pos + count);
+}
+
+void FileStream::writeChunk()
+{
+    if(m_data.size() > 0) {
+        uint offset = m_chunkOffset;
+        uint len = m_data.size();
+        m_streamSize = std::max<uint>(m_streamSize, offset + len);
+
+        if(m_writeBehind) {
+            // only one chunk is written at a time, so chunks land on disk in order
+            if(!waitWriteBehind())
+                throwError("write failed", true);
+
+            m_writeBehind->buffer.swap(m_data);
+            PHYSFS_File *fileHandle = m_fileHandle;
+            const uint8 *data = m_writeBehind->buffer.data();
+            m_writeBehind->writing = true;
+            m_writeBehind->pending = g_asyncDispatcher.schedule([=]() -> bool {
+                return PHYSFS_seek(fileHandle, offset) && PHYSFS_write(fileHandle, data, 1, len) == len;
+            });
+        } else {
+            if(!PHYSFS_seek(m_fileHandle, offset) || PHYSFS_write(m_fileHandle, m_data.data(), 1, len) != len)
+                throwError("write failed", true);
+        }
+    }
+
+    m_chunkOffset += m_pos;
+    m_pos = 0;
+    m_data.reset();
+}
+
+void FileStream::writePatches()
+{
+    if(!waitWriteBehind())
+        throwError("write failed", true);
+
+    // patches are sorted so adjacent ones go out in a single write
+    std::stable_sort(m_patches.begin(), m_patches.end(),
+                     [](const std::pair<uint, std::string>& a, const std::pair<uint, std::string>& b) { return a.first < b.first; });
+    std::string run;
+    uint runPos = 0;
+    for(uint i = 0; i <= m_patches.size(); ++i) {
+        if(i < m_patches.size()) {
+            const auto& patch = m_patches[i];
+            if(!run.empty() && patch.first >= runPos && patch.first <= runPos + run.size()) {
+                uint at = patch.first - runPos;
+                if(at + patch.second.size() > run.size())
+                    run.resize(at + patch.second.size());
+                run.replace(at, patch.second.size(), patch.second);
+                continue;
+            }
+        }
+
+        if(!run.empty()) {
+            if(!PHYSFS_seek(m_fileHandle, runPos) || PHYSFS_write(m_fileHandle, run.data(), 1, run.size()) != (PHYSFS_sint64)run.size())
+                throwError("patch failed", true);
+        }
+
+        if(i < m_patches.size()) {
+            runPos = m_patches[i].first;
+            run = m_patches[i].second;
+        }
+    }
+    m_patches.clear();
+}
+
+bool FileStream::waitWriteBehind()
+{
+    if(!m_writeBehind || !m_writeBehind->writing)
+        return true;
+
+    m_writeBehind->writing = false;
+    return m_writeBehind->pending.get();
+}
+
 void FileStream::throwError(const std::string& message, bool physfsError)
 {
     std::string completeMessage = stdext::format("in file '%s': %s", m_name, message);
@@ -29,6 +29,11 @@
 #include <framework/util/point.h>
 
 struct PHYSFS_File;
+struct FileStreamWriteBehind;
+
+enum {
+    FILESTREAM_CHUNK_SIZE = 1024 * 1024
+};
 
 // @bindclass
 class FileStream : public LuaObject
@@ -39,6 +44,8 @@ public:
     ~FileStream();
 
     void cache();
+    /// Writes go through a fixed size buffer instead of caching the whole file, optionally flushed by a worker thread
+    void stream(uint chunkSize = FILESTREAM_CHUNK_SIZE, bool backgroundFlush = false);
     void close();
     void flush();
     void write(const void *buffer, uint count);
@@ -49,6 +56,7 @@ public:
     uint tell();
     bool eof();
     std::string name() { return m_name; }
+    const uint8 *data() { return m_data.data(); }
 
     uint8 getU8();
     uint16 getU16();
@@ -75,9 +83,18 @@ public:
     void addPos(uint16 x, uint16 y, uint8 z) { addU16(x); addU16(y); addU8(z); }
     void addPoint(const Point& p) { addU8(p.x); addU8(p.y); }
 
+    /// Overwrites already written data, streamed files defer it until flush or a seek when it already left the buffer
+    void patch(uint pos, const void *data, uint len);
+    void patchU16(uint pos, uint16 v);
+    void patchU32(uint pos, uint32 v);
+
     FileStreamPtr asFileStream() { return static_self_cast<FileStream>(); }
 
 private:
+    void reserve(uint count);
+    void writeChunk();
+    void writePatches();
+    bool waitWriteBehind();
     void checkWrite();
     void throwError(const std::string& message, bool physfsError = false);
 
@@ -86,8 +103,14 @@ private:
     uint m_pos;
     bool m_writeable;
     bool m_caching;
+    bool m_streaming;
+    uint m_chunkSize;
+    uint m_chunkOffset;
+    uint m_streamSize;
 
     DataBuffer<uint8_t> m_data;
+    std::vector<std::pair<uint, std::string>> m_patches;
+    std::unique_ptr<FileStreamWriteBehind> m_writeBehind;
 };
 
 #endif
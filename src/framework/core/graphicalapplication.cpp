@@ -38,6 +38,19 @@
 
 GraphicalApplication g_app;
 
+GraphicalApplication::GraphicalApplication()
+{
+    m_garbageCollectMicrosSum = 0;
+    m_garbageCollectMicros = 0;
+    m_foregroundFrameMicrosSum = 0;
+    m_foregroundFrameMicros = 0;
+    m_foregroundFrames = 0;
+    m_drawCallsSum = 0;
+    m_drawCallsPerFrame = 0;
+    m_texturesSum = 0;
+    m_texturesPerFrame = 0;
+}
+
 void GraphicalApplication::init(std::vector<std::string>& args)
 {
     Application::init(args);
@@ -152,9 +165,12 @@ void GraphicalApplication::run()
                         m_foregroundFrameCounter.processNextFrame();
 
                         // draw foreground
+                        ticks_t foregroundStart = stdext::micros();
                         g_painter->setAlphaWriting(true);
                         g_painter->clear(Color::alpha);
                         g_ui.render(Fw::ForegroundPane);
+                        m_foregroundFrameMicrosSum += stdext::micros() - foregroundStart;
+                        m_foregroundFrames++;
 
                         // copy the foreground to a texture
                         m_foreground->copyFromScreen(viewportRect);
@@ -178,17 +194,39 @@ void GraphicalApplication::run()
                 }
 
                 // update screen pixels
+                g_painter->flush();
+                m_drawCallsSum += g_painter->getDrawCalls();
+                m_texturesSum += g_painter->getBoundTextureCount();
+                g_painter->resetFrameStats();
                 g_window.swapBuffers();
             }
 
             // only update the current time once per frame to gain performance
             g_clock.update();
 
-            if(m_backgroundFrameCounter.update())
+            if(m_backgroundFrameCounter.update()) {
+                int frames = std::max<int>(m_backgroundFrameCounter.getLastFps(), 1);
+                m_garbageCollectMicros = m_garbageCollectMicrosSum / frames;
+                m_garbageCollectMicrosSum = 0;
+                m_drawCallsPerFrame = m_drawCallsSum / frames;
+                m_drawCallsSum = 0;
+                m_texturesPerFrame = m_texturesSum / frames;
+                m_texturesSum = 0;
                 g_lua.callGlobalField("g_app", "onFps", m_backgroundFrameCounter.getLastFps());
-            m_foregroundFrameCounter.update();
+            }
+            if(m_foregroundFrameCounter.update()) {
+                m_foregroundFrameMicros = m_foregroundFrameMicrosSum / std::max<int>(m_foregroundFrames, 1);
+                m_foregroundFrameMicrosSum = 0;
+                m_foregroundFrames = 0;
+            }
 
             int sleepMicros = m_backgroundFrameCounter.getMaximumSleepMicros();
+            if(redraw && sleepMicros > 0) {
+                // use part of the time left until the next frame to collect lua garbage,
+                // frames without idle time (uncapped or over budget) skip it entirely
+                int gcMicros = std::max<int>(sleepMicros / 2, std::min<int>(sleepMicros, MIN_GARBAGE_MICROS));
+                sleepMicros -= collectGarbage(std::min<int>(gcMicros, MAX_GARBAGE_MICROS));
+            }
             if(sleepMicros >= AdaptativeFrameCounter::MINIMUM_MICROS_SLEEP)
                 stdext::microsleep(sleepMicros);
 
@@ -244,3 +282,15 @@ void GraphicalApplication::inputEvent(const InputEvent& event)
     g_ui.inputEvent(event);
     m_onInputEvent = false;
 }
+
+int GraphicalApplication::collectGarbage(int budgetMicros)
+{
+    int spent = g_lua.stepGarbage(budgetMicros);
+    m_garbageCollectMicrosSum += spent;
+    return spent;
+}
+
+int GraphicalApplication::getLuaUsedMemory()
+{
+    return g_lua.getUsedMemory();
+}
@@ -31,10 +31,15 @@
 class GraphicalApplication : public Application
 {
     enum {
-        POLL_CYCLE_DELAY = 10
+        POLL_CYCLE_DELAY = 10,
+        // lua garbage collection budget taken from each frame idle time
+        MIN_GARBAGE_MICROS = 200,
+        MAX_GARBAGE_MICROS = 2000
     };
 
 public:
+    GraphicalApplication();
+
     void init(std::vector<std::string>& args);
     void deinit();
     void terminate();
@@ -52,12 +57,18 @@ public:
     int getBackgroundPaneFps() { return m_backgroundFrameCounter.getLastFps(); }
     int getForegroundPaneMaxFps() { return m_foregroundFrameCounter.getMaxFps(); }
     int getBackgroundPaneMaxFps() { return m_backgroundFrameCounter.getMaxFps(); }
+    int getGarbageCollectMicros() { return m_garbageCollectMicros; }
+    int getForegroundFrameMicros() { return m_foregroundFrameMicros; }
+    int getDrawCallsPerFrame() { return m_drawCallsPerFrame; }
+    int getTexturesPerFrame() { return m_texturesPerFrame; }
+    int getLuaUsedMemory();
 
     bool isOnInputEvent() { return m_onInputEvent; }
 
 protected:
     void resize(const Size& size);
     void inputEvent(const InputEvent& event);
+    int collectGarbage(int budgetMicros);
 
 private:
     stdext::boolean<false> m_onInputEvent;
@@ -65,6 +76,15 @@ private:
     AdaptativeFrameCounter m_backgroundFrameCounter;
     AdaptativeFrameCounter m_foregroundFrameCounter;
     TexturePtr m_foreground;
+    ticks_t m_garbageCollectMicrosSum;
+    int m_garbageCollectMicros;
+    ticks_t m_foregroundFrameMicrosSum;
+    int m_foregroundFrameMicros;
+    int m_foregroundFrames;
+    int m_drawCallsSum;
+    int m_drawCallsPerFrame;
+    int m_texturesSum;
+    int m_texturesPerFrame;
 };
 
 extern GraphicalApplication g_app;
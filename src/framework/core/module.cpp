@@ -23,6 +23,7 @@
 #include "module.h"
 #include "modulemanager.h"
 #include "resourcemanager.h"
+#include "tracer.h"
 
 #include <framework/otml/otml.h>
 #include <framework/luaengine/luainterface.h>
@@ -38,6 +39,9 @@ bool Module::load()
     if(m_loaded)
         return true;
 
+    TraceScope scope("module", m_name);
+    g_tracer.pushModule(m_name);
+
     try {
         // add to package.loaded
         g_lua.getGlobalField("package", "loaded");
@@ -64,7 +68,15 @@ bool Module::load()
             g_lua.setGlobalEnvironment(m_sandboxEnv);
 
         for(const std::string& script : m_scripts) {
-            g_lua.loadScript(script);
+            std::string filePath = g_resources.guessFilePath(script, "lua");
+            std::string buffer;
+            if(g_modules.takePrefetchedScript(filePath, buffer)) {
+                TraceScope compileScope("lua-compile", filePath);
+                g_lua.loadBuffer(buffer, "@" + filePath);
+            } else
+                g_lua.loadScript(script);
+
+            TraceScope execScope("lua-exec", filePath);
             g_lua.safeCall(0, 0);
         }
 
@@ -94,9 +106,11 @@ bool Module::load()
         if(m_sandboxed)
             g_lua.resetGlobalEnvironment();
         g_logger.error(stdext::format("Unable to load module '%s': %s", m_name, e.what()));
+        g_tracer.popModule();
         return false;
     }
 
+    g_tracer.popModule();
     g_modules.updateModuleLoadOrder(asModule());
 
     for(const std::string& modName : m_loadLaterModules) {
@@ -151,6 +165,9 @@ void Module::unload()
 
 bool Module::reload()
 {
+    // scripts may have been edited since they were cached
+    g_resources.clearCache();
+
     unload();
     return load();
 }
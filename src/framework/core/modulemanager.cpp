@@ -22,6 +22,8 @@
 
 #include "modulemanager.h"
 #include "resourcemanager.h"
+#include "asyncdispatcher.h"
+#include "tracer.h"
 
 #include <framework/otml/otml.h>
 #include <framework/core/application.h>
@@ -32,6 +34,7 @@ void ModuleManager::clear()
 {
     m_modules.clear();
     m_autoLoadModules.clear();
+    clearPrefetched();
 }
 
 void ModuleManager::discoverModules()
@@ -39,14 +42,26 @@ void ModuleManager::discoverModules()
     // remove modules that are not loaded
     m_autoLoadModules.clear();
 
-    auto moduleDirs = g_resources.listDirectoryFiles("/");
-    for(const std::string& moduleDir : moduleDirs) {
-        auto moduleFiles = g_resources.listDirectoryFiles("/" + moduleDir);
-        for(const std::string& moduleFile : moduleFiles) {
+    std::vector<std::pair<std::string, std::list<std::string>>> moduleDirs;
+    for(const std::string& moduleDir : g_resources.listDirectoryFiles("/"))
+        moduleDirs.push_back(std::make_pair(moduleDir, g_resources.listDirectoryFiles("/" + moduleDir)));
+
+    // read all module files and their caches on worker threads first, discoverModule builds them in order
+    for(const auto& pair : moduleDirs) {
+        for(const std::string& moduleFile : pair.second) {
+            if(g_resources.isFileType(moduleFile, "otmod"))
+                g_otmlcache.preload("/" + pair.first + "/" + moduleFile);
+        }
+    }
+
+    for(const auto& pair : moduleDirs) {
+        for(const std::string& moduleFile : pair.second) {
             if(g_resources.isFileType(moduleFile, "otmod")) {
-                ModulePtr module = discoverModule("/" + moduleDir + "/" + moduleFile);
-                if(module && module->isAutoLoad())
+                ModulePtr module = discoverModule("/" + pair.first + "/" + moduleFile);
+                if(module && module->isAutoLoad()) {
                     m_autoLoadModules.insert(std::make_pair(module->getAutoLoadPriority(), module));
+                    prefetchModule(module, pair.first, pair.second);
+                }
             }
         }
     }
@@ -61,6 +76,10 @@ void ModuleManager::autoLoadModules(int maxPriority)
         ModulePtr module = pair.second;
         module->load();
     }
+
+    // everything was loaded, drop prefetched files that were never used
+    if(m_autoLoadModules.empty() || m_autoLoadModules.rbegin()->first <= maxPriority)
+        clearPrefetched();
 }
 
 ModulePtr ModuleManager::discoverModule(const std::string& moduleFile)
@@ -107,6 +126,9 @@ void ModuleManager::reloadModules()
 {
     std::deque<ModulePtr> toLoadList;
 
+    // scripts may have been edited since they were cached
+    g_resources.clearCache();
+
     // unload in the reverse direction, try to unload upto 10 times (because of dependencies)
     for(int i=0;i<10;++i) {
         auto modulesBackup = m_modules;
@@ -122,6 +144,48 @@ void ModuleManager::reloadModules()
         module->load();
 }
 
+void ModuleManager::prefetchModule(const ModulePtr& module, const std::string& moduleDir, const std::list<std::string>& moduleFiles)
+{
+    for(const std::string& script : module->m_scripts) {
+        std::string filePath = g_resources.guessFilePath(script, "lua");
+        if(m_prefetchedScripts.find(filePath) != m_prefetchedScripts.end())
+            continue;
+
+        m_prefetchedScripts[filePath] = g_asyncDispatcher.schedule([filePath]() -> std::string {
+            try {
+                TraceScope scope("io", filePath);
+                return g_resources.readFileContents(filePath);
+            } catch(stdext::exception&) {
+                // the script is read again when loading, reporting the error there
+                return std::string();
+            }
+        });
+    }
+
+    // interfaces next to the module file are usually loaded by its scripts
+    for(const std::string& file : moduleFiles) {
+        if(g_resources.isFileType(file, "otui"))
+            g_otmlcache.preload("/" + moduleDir + "/" + file);
+    }
+}
+
+bool ModuleManager::takePrefetchedScript(const std::string& filePath, std::string& buffer)
+{
+    auto it = m_prefetchedScripts.find(filePath);
+    if(it == m_prefetchedScripts.end())
+        return false;
+
+    buffer = it->second.get();
+    m_prefetchedScripts.erase(it);
+    return !buffer.empty();
+}
+
+void ModuleManager::clearPrefetched()
+{
+    m_prefetchedScripts.clear();
+    g_otmlcache.clearPreloaded();
+}
+
 ModulePtr ModuleManager::getModule(const std::string& moduleName)
 {
     for(const ModulePtr& module : m_modules)
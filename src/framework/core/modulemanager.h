@@ -43,12 +43,16 @@ public:
 
 protected:
     void updateModuleLoadOrder(ModulePtr module);
+    void prefetchModule(const ModulePtr& module, const std::string& moduleDir, const std::list<std::string>& moduleFiles);
+    bool takePrefetchedScript(const std::string& filePath, std::string& buffer);
+    void clearPrefetched();
 
     friend class Module;
 
 private:
     std::deque<ModulePtr> m_modules;
     std::multimap<int, ModulePtr> m_autoLoadModules;
+    std::unordered_map<std::string, boost::shared_future<std::string>> m_prefetchedScripts;
 };
 
 extern ModuleManager g_modules;
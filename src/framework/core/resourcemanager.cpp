@@ -22,6 +22,7 @@
 
 #include "resourcemanager.h"
 #include "filestream.h"
+#include "asyncdispatcher.h"
 
 #include <framework/core/application.h>
 #include <framework/luaengine/luainterface.h>
@@ -31,14 +32,26 @@
 
 ResourceManager g_resources;
 
+enum {
+    DEFAULT_CACHE_LIMIT = 32 * 1024 * 1024,
+    // bigger files are rarely read twice and would evict everything else
+    CACHE_FILE_RATIO = 8
+};
+
 void ResourceManager::init(const char *argv0)
 {
+    m_cacheLimit = DEFAULT_CACHE_LIMIT;
+    m_cachedBytes = 0;
+    m_cacheHits = 0;
+    m_cacheMisses = 0;
+
     PHYSFS_init(argv0);
     PHYSFS_permitSymbolicLinks(1);
 }
 
 void ResourceManager::terminate()
 {
+    clearCache();
     PHYSFS_deinit();
 }
 
@@ -128,6 +141,7 @@ bool ResourceManager::addSearchPath(const std::string& path, bool pushFront)
         m_searchPaths.push_front(savePath);
     else
         m_searchPaths.push_back(savePath);
+    clearCache();
     return true;
 }
 
@@ -138,6 +152,7 @@ bool ResourceManager::removeSearchPath(const std::string& path)
     auto it = std::find(m_searchPaths.begin(), m_searchPaths.end(), path);
     assert(it != m_searchPaths.end());
     m_searchPaths.erase(it);
+    clearCache();
     return true;
 }
 
@@ -156,44 +171,79 @@ void ResourceManager::searchAndAddPackages(const std::string& packagesDir, const
 
 bool ResourceManager::fileExists(const std::string& fileName)
 {
-    return (PHYSFS_exists(resolvePath(fileName).c_str()) && !PHYSFS_isDirectory(resolvePath(fileName).c_str()));
+    std::string fullPath = resolvePath(fileName);
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    const PathInfo *info = lookupPath(fullPath);
+    return info && !info->directory;
 }
 
 bool ResourceManager::directoryExists(const std::string& directoryName)
 {
-    return (PHYSFS_isDirectory(resolvePath(directoryName).c_str()));
+    std::string fullPath = resolvePath(directoryName);
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    const PathInfo *info = lookupPath(fullPath);
+    return info && info->directory;
 }
 
 void ResourceManager::readFileStream(const std::string& fileName, std::iostream& out)
 {
-    std::string buffer = readFileContents(fileName);
-    if(buffer.length() == 0) {
+    FileBufferPtr buffer = readFileBuffer(fileName);
+    if(buffer->length() == 0) {
         out.clear(std::ios::eofbit);
         return;
     }
     out.clear(std::ios::goodbit);
-    out.write(&buffer[0], buffer.length());
+    out.write(buffer->data(), buffer->length());
     out.seekg(0, std::ios::beg);
 }
 
 std::string ResourceManager::readFileContents(const std::string& fileName)
+{
+    return *readFileBuffer(fileName);
+}
+
+FileBufferPtr ResourceManager::readFileBuffer(const std::string& fileName)
 {
     std::string fullPath = resolvePath(fileName);
 
+    // files can change outside of the write functions (live reload, external editors),
+    // so cached bytes are only served while the file still has the same time and size
+    ticks_t modTime;
+    uint size;
+    bool known = getFileInfo(fullPath, modTime, size);
+    {
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+        auto it = m_bufferCache.find(fullPath);
+        if(it != m_bufferCache.end()) {
+            if(known && it->second.modTime == modTime && it->second.size == size) {
+                m_bufferOrder.splice(m_bufferOrder.begin(), m_bufferOrder, it->second.order);
+                m_cacheHits++;
+                return it->second.buffer;
+            }
+            uncacheBuffer(it);
+        }
+    }
+    m_cacheMisses++;
+
     PHYSFS_File* file = PHYSFS_openRead(fullPath.c_str());
     if(!file)
         stdext::throw_exception(stdext::format("unable to open file '%s': %s", fullPath, PHYSFS_getLastError()));
 
     int fileSize = PHYSFS_fileLength(file);
-    std::string buffer(fileSize, 0);
-    PHYSFS_read(file, (void*)&buffer[0], 1, fileSize);
+    std::string *buffer = new std::string(fileSize, 0);
+    FileBufferPtr ret(buffer);
+    PHYSFS_read(file, (void*)&(*buffer)[0], 1, fileSize);
     PHYSFS_close(file);
 
-    return buffer;
+    if(known)
+        cacheBuffer(fullPath, ret, modTime, size);
+    return ret;
 }
 
 bool ResourceManager::writeFileBuffer(const std::string& fileName, const uchar* data, uint size)
 {
+    invalidatePath(fileName);
+
     PHYSFS_file* file = PHYSFS_openWrite(fileName.c_str());
     if(!file) {
         g_logger.error(PHYSFS_getLastError());
@@ -235,6 +285,8 @@ FileStreamPtr ResourceManager::openFile(const std::string& fileName)
 
 FileStreamPtr ResourceManager::appendFile(const std::string& fileName)
 {
+    invalidatePath(fileName);
+
     PHYSFS_File* file = PHYSFS_openAppend(fileName.c_str());
     if(!file)
         stdext::throw_exception(stdext::format("failed to append file '%s': %s", fileName, PHYSFS_getLastError()));
@@ -243,6 +295,8 @@ FileStreamPtr ResourceManager::appendFile(const std::string& fileName)
 
 FileStreamPtr ResourceManager::createFile(const std::string& fileName)
 {
+    invalidatePath(fileName);
+
     PHYSFS_File* file = PHYSFS_openWrite(fileName.c_str());
     if(!file)
         stdext::throw_exception(stdext::format("failed to create file '%s': %s", fileName, PHYSFS_getLastError()));
@@ -251,11 +305,30 @@ FileStreamPtr ResourceManager::createFile(const std::string& fileName)
 
 bool ResourceManager::deleteFile(const std::string& fileName)
 {
-    return PHYSFS_delete(resolvePath(fileName).c_str()) != 0;
+    std::string fullPath = resolvePath(fileName);
+    invalidatePath(fullPath);
+    return PHYSFS_delete(fullPath.c_str()) != 0;
+}
+
+bool ResourceManager::renameFile(const std::string& fromFileName, const std::string& toFileName)
+{
+    invalidatePath(fromFileName);
+    invalidatePath(toFileName);
+
+    // physfs can't rename, so it goes to the write dir on disk
+    fs::path writeDir(m_writeDir);
+    boost::system::error_code ec;
+    fs::rename(writeDir / fs::path(fromFileName).relative_path(), writeDir / fs::path(toFileName).relative_path(), ec);
+    if(ec) {
+        g_logger.error(stdext::format("Unable to rename file '%s' to '%s': %s", fromFileName, toFileName, ec.message()));
+        return false;
+    }
+    return true;
 }
 
 bool ResourceManager::makeDir(const std::string directory)
 {
+    invalidatePath(directory);
     return PHYSFS_mkdir(directory.c_str());
 }
 
@@ -321,11 +394,20 @@ std::string ResourceManager::resolvePath(const std::string& path)
 
 std::string ResourceManager::getRealDir(const std::string& path)
 {
-    std::string dir;
-    const char *cdir = PHYSFS_getRealDir(resolvePath(path).c_str());
-    if(cdir)
-        dir = cdir;
-    return dir;
+    std::string fullPath = resolvePath(path);
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    PathInfo *info = lookupPath(fullPath);
+    if(!info) {
+        const char *cdir = PHYSFS_getRealDir(fullPath.c_str());
+        return cdir ? cdir : "";
+    }
+    if(!info->realDirKnown) {
+        const char *cdir = PHYSFS_getRealDir(fullPath.c_str());
+        if(cdir)
+            info->realDir = cdir;
+        info->realDirKnown = true;
+    }
+    return info->realDir;
 }
 
 std::string ResourceManager::getRealPath(const std::string& path)
@@ -361,3 +443,118 @@ ticks_t ResourceManager::getFileTime(const std::string& filename)
 {
     return g_platform.getFileModificationTime(getRealPath(filename));
 }
+
+bool ResourceManager::getFileInfo(const std::string& fileName, ticks_t& modTime, uint& size)
+{
+    std::string fullPath = resolvePath(fileName);
+
+    PHYSFS_File* file = PHYSFS_openRead(fullPath.c_str());
+    if(!file)
+        return false;
+    size = PHYSFS_fileLength(file);
+    PHYSFS_close(file);
+
+    modTime = PHYSFS_getLastModTime(fullPath.c_str());
+    return modTime != -1;
+}
+
+void ResourceManager::prefetchFiles(const std::vector<std::string>& fileNames)
+{
+    // paths are resolved here because relative ones depend on the running script
+    for(const std::string& fileName : fileNames) {
+        std::string fullPath = resolvePath(fileName);
+        {
+            std::lock_guard<std::mutex> lock(m_cacheMutex);
+            if(m_bufferCache.find(fullPath) != m_bufferCache.end())
+                continue;
+        }
+
+        g_asyncDispatcher.schedule([this, fullPath]() -> bool {
+            try {
+                readFileBuffer(fullPath);
+                return true;
+            } catch(stdext::exception&) {
+                // missing files are reported by whoever reads them later
+                return false;
+            }
+        });
+    }
+}
+
+void ResourceManager::clearCache()
+{
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    m_pathCache.clear();
+    m_bufferCache.clear();
+    m_bufferOrder.clear();
+    m_cachedBytes = 0;
+}
+
+void ResourceManager::setCacheLimit(uint bytes)
+{
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    m_cacheLimit = bytes;
+    trimCache();
+}
+
+ResourceManager::PathInfo *ResourceManager::lookupPath(const std::string& fullPath)
+{
+    auto it = m_pathCache.find(fullPath);
+    if(it != m_pathCache.end())
+        return &it->second;
+
+    // missing paths are not cached, files may be created without going through the write functions
+    if(!PHYSFS_exists(fullPath.c_str()))
+        return nullptr;
+
+    PathInfo& info = m_pathCache[fullPath];
+    info.directory = PHYSFS_isDirectory(fullPath.c_str()) != 0;
+    return &info;
+}
+
+void ResourceManager::cacheBuffer(const std::string& fullPath, const FileBufferPtr& buffer, ticks_t modTime, uint size)
+{
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    if(buffer->size() > m_cacheLimit / CACHE_FILE_RATIO || m_bufferCache.find(fullPath) != m_bufferCache.end())
+        return;
+
+    m_bufferOrder.push_front(fullPath);
+    CachedBuffer& cached = m_bufferCache[fullPath];
+    cached.buffer = buffer;
+    cached.modTime = modTime;
+    cached.size = size;
+    cached.order = m_bufferOrder.begin();
+    m_cachedBytes += buffer->size();
+    trimCache();
+}
+
+void ResourceManager::invalidatePath(const std::string& fileName)
+{
+    // files are written relative to the write dir, which is mounted at the root
+    std::string fullPath = fileName;
+    if(!stdext::starts_with(fullPath, "/"))
+        fullPath = "/" + fullPath;
+
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    m_pathCache.erase(fullPath);
+    auto it = m_bufferCache.find(fullPath);
+    if(it != m_bufferCache.end())
+        uncacheBuffer(it);
+}
+
+void ResourceManager::uncacheBuffer(std::unordered_map<std::string, CachedBuffer>::iterator it)
+{
+    m_cachedBytes -= it->second.buffer->size();
+    m_bufferOrder.erase(it->second.order);
+    m_bufferCache.erase(it);
+}
+
+void ResourceManager::trimCache()
+{
+    while(m_cachedBytes > m_cacheLimit && !m_bufferOrder.empty()) {
+        auto it = m_bufferCache.find(m_bufferOrder.back());
+        m_cachedBytes -= it->second.buffer->size();
+        m_bufferCache.erase(it);
+        m_bufferOrder.pop_back();
+    }
+}
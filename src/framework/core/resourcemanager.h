@@ -25,10 +25,15 @@
 
 #include "declarations.h"
 
+#include <framework/stdext/thread.h>
 #include <boost/filesystem.hpp>
+#include <atomic>
 
 namespace fs = boost::filesystem;
 
+// std::shared_ptr because buffers are shared with worker threads
+typedef std::shared_ptr<const std::string> FileBufferPtr;
+
 // @bindsingleton g_resources
 class ResourceManager
 {
@@ -52,6 +57,9 @@ public:
     // @dontbind
     void readFileStream(const std::string& fileName, std::iostream& out);
     std::string readFileContents(const std::string& fileName);
+    /// Reads a whole file, recently read files are shared from memory
+    // @dontbind
+    FileBufferPtr readFileBuffer(const std::string& fileName);
     // @dontbind
     bool writeFileBuffer(const std::string& fileName, const uchar* data, uint size);
     bool writeFileContents(const std::string& fileName, const std::string& data);
@@ -62,6 +70,8 @@ public:
     FileStreamPtr appendFile(const std::string& fileName);
     FileStreamPtr createFile(const std::string& fileName);
     bool deleteFile(const std::string& fileName);
+    /// Replaces toFileName by fromFileName, both in the write dir
+    bool renameFile(const std::string& fromFileName, const std::string& toFileName);
 
     bool makeDir(const std::string directory);
     std::list<std::string> listDirectoryFiles(const std::string& directoryPath = "");
@@ -79,14 +89,54 @@ public:
     std::string guessFilePath(const std::string& filename, const std::string& type);
     bool isFileType(const std::string& filename, const std::string& type);
     ticks_t getFileTime(const std::string& filename);
+    // @dontbind
+    bool getFileInfo(const std::string& fileName, ticks_t& modTime, uint& size);
+
+    /// Reads the given files into the file cache on worker threads
+    void prefetchFiles(const std::vector<std::string>& fileNames);
+    void clearCache();
+    void setCacheLimit(uint bytes);
+    uint getCacheLimit() { return m_cacheLimit; }
+    uint getCachedBytes() { return m_cachedBytes; }
+    int getCacheHits() { return m_cacheHits; }
+    int getCacheMisses() { return m_cacheMisses; }
 
 protected:
     std::vector<std::string> discoverPath(const fs::path& path, bool filenameOnly, bool recursive);
 
 private:
+    struct PathInfo {
+        PathInfo() : directory(false), realDirKnown(false) { }
+        bool directory;
+        bool realDirKnown;
+        std::string realDir;
+    };
+
+    struct CachedBuffer {
+        FileBufferPtr buffer;
+        ticks_t modTime;
+        uint size;
+        std::list<std::string>::iterator order;
+    };
+
+    PathInfo *lookupPath(const std::string& fullPath);
+    void cacheBuffer(const std::string& fullPath, const FileBufferPtr& buffer, ticks_t modTime, uint size);
+    void uncacheBuffer(std::unordered_map<std::string, CachedBuffer>::iterator it);
+    void invalidatePath(const std::string& fileName);
+    void trimCache();
+
     std::string m_workDir;
     std::string m_writeDir;
     std::deque<std::string> m_searchPaths;
+
+    std::mutex m_cacheMutex;
+    std::unordered_map<std::string, PathInfo> m_pathCache;
+    std::unordered_map<std::string, CachedBuffer> m_bufferCache;
+    std::list<std::string> m_bufferOrder;
+    uint m_cacheLimit;
+    std::atomic<uint> m_cachedBytes;
+    std::atomic<int> m_cacheHits;
+    std::atomic<int> m_cacheMisses;
 };
 
 extern ResourceManager g_resources;
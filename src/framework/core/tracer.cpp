@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2010-2017 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "tracer.h"
+#include "resourcemanager.h"
+
+Tracer g_tracer;
+
+Tracer::Tracer() : m_enabled(false)
+{
+    m_startTime = stdext::micros();
+}
+
+void Tracer::setEnabled(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // tracing is controlled from the main thread, it is always the thread 0
+    if(enabled && m_threads.empty())
+        m_threads[std::this_thread::get_id()] = 0;
+    m_enabled = enabled;
+}
+
+void Tracer::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_events.clear();
+    m_moduleTimes.clear();
+    m_startTime = stdext::micros();
+}
+
+void Tracer::pushModule(const std::string& name)
+{
+    if(!m_enabled)
+        return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_moduleStack.push_back(name);
+}
+
+void Tracer::popModule()
+{
+    if(!m_enabled)
+        return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(!m_moduleStack.empty())
+        m_moduleStack.pop_back();
+}
+
+void Tracer::beginScope(TraceScope *scope)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    TraceScope *& current = m_openScopes[std::this_thread::get_id()];
+    scope->m_parent = current;
+    current = scope;
+}
+
+void Tracer::endScope(TraceScope *scope)
+{
+    ticks_t duration = stdext::micros() - scope->m_start;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::thread::id threadId = std::this_thread::get_id();
+    m_openScopes[threadId] = scope->m_parent;
+    if(scope->m_parent)
+        scope->m_parent->m_childrenTime += duration;
+
+    // only the main thread runs modules, worker scopes are accounted as prefetch
+    int thread = getThreadIndex(threadId);
+    std::string module;
+    if(thread == 0 && !m_moduleStack.empty())
+        module = m_moduleStack.back();
+    else if(thread != 0)
+        module = "(prefetch)";
+
+    Event event;
+    event.name = scope->m_name;
+    event.category = scope->m_category;
+    event.module = module;
+    event.thread = thread;
+    event.start = scope->m_start - m_startTime;
+    event.duration = duration;
+    m_events.push_back(event);
+
+    if(!module.empty())
+        m_moduleTimes[module][event.category] += duration - scope->m_childrenTime;
+}
+
+int Tracer::getThreadIndex(std::thread::id id)
+{
+    auto it = m_threads.find(id);
+    if(it != m_threads.end())
+        return it->second;
+    int index = m_threads.size();
+    m_threads[id] = index;
+    return index;
+}
+
+static std::string escapeJson(const std::string& str)
+{
+    std::string ret;
+    for(char c : str) {
+        if(c == '"' || c == '\\')
+            ret += '\\';
+        if((uchar)c < 0x20)
+            ret += stdext::format("\\u%04x", (int)(uchar)c);
+        else
+            ret += c;
+    }
+    return ret;
+}
+
+bool Tracer::dump(const std::string& fileName)
+{
+    std::stringstream ss;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ss << "{\"traceEvents\":[";
+        for(std::size_t i = 0; i < m_events.size(); ++i) {
+            const Event& event = m_events[i];
+            if(i > 0)
+                ss << ",";
+            ss << "\n{\"name\":\"" << escapeJson(event.name) << "\",\"cat\":\"" << escapeJson(event.category) << "\",";
+            ss << "\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread << ",\"ts\":" << event.start << ",\"dur\":" << event.duration;
+            if(!event.module.empty())
+                ss << ",\"args\":{\"module\":\"" << escapeJson(event.module) << "\"}";
+            ss << "}";
+        }
+        ss << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    }
+    return g_resources.writeFileContents(fileName, ss.str());
+}
+
+void Tracer::logSummary()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for(auto& module : m_moduleTimes) {
+        std::string line = stdext::format("%s:", module.first);
+        ticks_t total = 0;
+        for(auto& category : module.second) {
+            line += stdext::format(" %s=%.2fms", category.first, category.second / 1000.0f);
+            total += category.second;
+        }
+        g_logger.info(stdext::format("%s total=%.2fms", line, total / 1000.0f));
+    }
+}
+
+TraceScope::TraceScope(const char *category, const std::string& name)
+{
+    m_active = g_tracer.isEnabled();
+    if(!m_active)
+        return;
+    m_category = category;
+    m_name = name;
+    m_childrenTime = 0;
+    m_parent = nullptr;
+    m_start = stdext::micros();
+    g_tracer.beginScope(this);
+}
+
+TraceScope::~TraceScope()
+{
+    if(m_active)
+        g_tracer.endScope(this);
+}
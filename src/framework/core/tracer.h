@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2010-2017 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include "declarations.h"
+#include <framework/stdext/thread.h>
+#include <atomic>
+
+class TraceScope;
+
+/// Records timed scopes that can be dumped as Chrome trace JSON (chrome://tracing),
+/// also accumulates exclusive time per module and category for a quick summary
+// @bindsingleton g_tracer
+class Tracer
+{
+public:
+    Tracer();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() { return m_enabled; }
+    void clear();
+
+    /// Writes recorded events in Chrome trace event format into the write directory
+    bool dump(const std::string& fileName);
+    /// Logs the exclusive time spent by each module in each category
+    void logSummary();
+
+    // @dontbind
+    void pushModule(const std::string& name);
+    // @dontbind
+    void popModule();
+
+protected:
+    void beginScope(TraceScope *scope);
+    void endScope(TraceScope *scope);
+    friend class TraceScope;
+
+private:
+    struct Event {
+        std::string name;
+        std::string category;
+        std::string module;
+        int thread;
+        ticks_t start;
+        ticks_t duration;
+    };
+
+    int getThreadIndex(std::thread::id id);
+
+    std::atomic<bool> m_enabled;
+    std::mutex m_mutex;
+    ticks_t m_startTime;
+    std::vector<Event> m_events;
+    std::vector<std::string> m_moduleStack;
+    std::map<std::thread::id, TraceScope*> m_openScopes;
+    std::map<std::thread::id, int> m_threads;
+    std::map<std::string, std::map<std::string, ticks_t>> m_moduleTimes;
+};
+
+/// Times the enclosing block when tracing is enabled
+class TraceScope
+{
+public:
+    TraceScope(const char *category, const std::string& name);
+    ~TraceScope();
+
+private:
+    const char *m_category;
+    std::string m_name;
+    ticks_t m_start;
+    ticks_t m_childrenTime;
+    TraceScope *m_parent;
+    bool m_active;
+    friend class Tracer;
+};
+
+extern Tracer g_tracer;
+
+#endif
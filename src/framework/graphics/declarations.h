@@ -30,6 +30,7 @@ class Texture;
 class TextureManager;
 class Image;
 class AnimatedTexture;
+class AtlasTexture;
 class BitmapFont;
 class CachedText;
 class FrameBuffer;
@@ -37,7 +38,7 @@ class FrameBufferManager;
 class Shader;
 class ShaderProgram;
 class PainterShaderProgram;
-class Particle;
+class ParticlePool;
 class ParticleType;
 class ParticleEmitter;
 class ParticleAffector;
@@ -48,13 +49,14 @@ class ParticleEffectType;
 typedef stdext::shared_object_ptr<Image> ImagePtr;
 typedef stdext::shared_object_ptr<Texture> TexturePtr;
 typedef stdext::shared_object_ptr<AnimatedTexture> AnimatedTexturePtr;
+typedef stdext::shared_object_ptr<AtlasTexture> AtlasTexturePtr;
 typedef stdext::shared_object_ptr<BitmapFont> BitmapFontPtr;
 typedef stdext::shared_object_ptr<CachedText> CachedTextPtr;
 typedef stdext::shared_object_ptr<FrameBuffer> FrameBufferPtr;
 typedef stdext::shared_object_ptr<Shader> ShaderPtr;
 typedef stdext::shared_object_ptr<ShaderProgram> ShaderProgramPtr;
 typedef stdext::shared_object_ptr<PainterShaderProgram> PainterShaderProgramPtr;
-typedef stdext::shared_object_ptr<Particle> ParticlePtr;
+typedef stdext::shared_object_ptr<ParticlePool> ParticlePoolPtr;
 typedef stdext::shared_object_ptr<ParticleType> ParticleTypePtr;
 typedef stdext::shared_object_ptr<ParticleEmitter> ParticleEmitterPtr;
 typedef stdext::shared_object_ptr<ParticleAffector> ParticleAffectorPtr;
@@ -90,6 +90,7 @@ void FrameBuffer::bind()
 
 void FrameBuffer::release()
 {
+    g_painter->flush();
     internalRelease();
     g_painter->restoreSavedState();
 }
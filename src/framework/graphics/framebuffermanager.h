@@ -34,6 +34,7 @@ public:
     void clear();
 
     FrameBufferPtr createFrameBuffer();
+    void destroyFrameBuffer(const FrameBufferPtr& framebuffer);
     const FrameBufferPtr& getTemporaryFrameBuffer() { return m_temporaryFramebuffer; }
 
 protected:
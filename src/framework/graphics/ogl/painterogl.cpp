@@ -49,10 +49,12 @@ void PainterOGL::resetState()
     resetTexture();
     resetAlphaWriting();
     resetTransformMatrix();
+    resetDrawOrigin();
 }
 
 void PainterOGL::refreshState()
 {
+    flush();
     updateGlViewport();
     updateGlCompositionMode();
     updateGlBlendEquation();
@@ -63,8 +65,10 @@ void PainterOGL::refreshState()
 
 void PainterOGL::saveState()
 {
+    flush();
     assert(m_oldStateIndex<10);
     m_olderStates[m_oldStateIndex].resolution = m_resolution;
+    m_olderStates[m_oldStateIndex].drawOrigin = m_drawOrigin;
     m_olderStates[m_oldStateIndex].transformMatrix = m_transformMatrix;
     m_olderStates[m_oldStateIndex].projectionMatrix = m_projectionMatrix;
     m_olderStates[m_oldStateIndex].textureMatrix = m_textureMatrix;
@@ -88,6 +92,7 @@ void PainterOGL::saveAndResetState()
 void PainterOGL::restoreSavedState()
 {
     m_oldStateIndex--;
+    setDrawOrigin(m_olderStates[m_oldStateIndex].drawOrigin);
     setResolution(m_olderStates[m_oldStateIndex].resolution);
     setTransformMatrix(m_olderStates[m_oldStateIndex].transformMatrix);
     setProjectionMatrix(m_olderStates[m_oldStateIndex].projectionMatrix);
@@ -104,12 +109,14 @@ void PainterOGL::restoreSavedState()
 
 void PainterOGL::clear(const Color& color)
 {
+    flush();
     glClearColor(color.rF(), color.gF(), color.bF(), color.aF());
     glClear(GL_COLOR_BUFFER_BIT);
 }
 
 void PainterOGL::clearRect(const Color& color, const Rect& rect)
 {
+    flush();
     Rect oldClipRect = m_clipRect;
     setClipRect(rect);
     glClearColor(color.rF(), color.gF(), color.bF(), color.aF());
@@ -121,6 +128,7 @@ void PainterOGL::setCompositionMode(Painter::CompositionMode compositionMode)
 {
     if(m_compositionMode == compositionMode)
         return;
+    flush();
     m_compositionMode = compositionMode;
     updateGlCompositionMode();
 }
@@ -129,6 +137,7 @@ void PainterOGL::setBlendEquation(Painter::BlendEquation blendEquation)
 {
     if(m_blendEquation == blendEquation)
         return;
+    flush();
     m_blendEquation = blendEquation;
     updateGlBlendEquation();
 }
@@ -137,12 +146,16 @@ void PainterOGL::setClipRect(const Rect& clipRect)
 {
     if(m_clipRect == clipRect)
         return;
+    flush();
     m_clipRect = clipRect;
     updateGlClipRect();
 }
 
 void PainterOGL::setTexture(Texture* texture)
 {
+    // textures may be rebound for uploads, held back draws must use their current pixels
+    flush();
+
     if(m_texture == texture)
         return;
 
@@ -157,6 +170,8 @@ void PainterOGL::setTexture(Texture* texture)
 
     if(m_glTextureId != glTextureId) {
         m_glTextureId = glTextureId;
+        if(glTextureId)
+            m_boundTextures.insert(glTextureId);
         updateGlTexture();
     }
 }
@@ -165,6 +180,7 @@ void PainterOGL::setAlphaWriting(bool enable)
 {
     if(m_alphaWriting == enable)
         return;
+    flush();
 
     m_alphaWriting = enable;
     updateGlAlphaWriting();
@@ -184,11 +200,17 @@ void PainterOGL::setResolution(const Size& resolution)
     //   -------------     | 2.0 / width  |      0.0      |      0.0      |     ---------------
     //   |  x  y  1  |  *  |     0.0      | -2.0 / height |      0.0      |  =  |  x'  y'  1  |
     //   -------------     |    -1.0      |      1.0      |      1.0      |     ---------------
+    //
+    // A draw origin shifts the painter coordinate that maps to GL's top-left corner, so widgets
+    // can be rendered into an offscreen layer with their usual screen coordinates.
 
+    float originX = -1.0f - (2.0f * m_drawOrigin.x) / resolution.width();
+    float originY =  1.0f + (2.0f * m_drawOrigin.y) / resolution.height();
     Matrix3 projectionMatrix = { 2.0f/resolution.width(),  0.0f,                      0.0f,
                                  0.0f,                    -2.0f/resolution.height(),  0.0f,
-                                -1.0f,                     1.0f,                      1.0f };
+                                 originX,                  originY,                   1.0f };
 
+    flush();
     m_resolution = resolution;
 
     setProjectionMatrix(projectionMatrix);
@@ -196,6 +218,17 @@ void PainterOGL::setResolution(const Size& resolution)
         updateGlViewport();
 }
 
+void PainterOGL::setDrawOrigin(const Point& origin)
+{
+    if(m_drawOrigin == origin)
+        return;
+    flush();
+    m_drawOrigin = origin;
+    setResolution(m_resolution);
+    if(g_painter == this)
+        updateGlClipRect();
+}
+
 void PainterOGL::scale(float x, float y)
 {
     Matrix3 scaleMatrix = {
@@ -279,6 +312,9 @@ void PainterOGL::updateGlCompositionMode()
         case CompositionMode_Light:
             glBlendFunc(GL_ZERO, GL_SRC_COLOR);
             break;
+        case CompositionMode_Premultiplied:
+            glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+            break;
     }
 }
 
@@ -296,7 +332,8 @@ void PainterOGL::updateGlClipRect()
 {
     if(m_clipRect.isValid()) {
         glEnable(GL_SCISSOR_TEST);
-        glScissor(m_clipRect.left(), m_resolution.height() - m_clipRect.bottom() - 1, m_clipRect.width(), m_clipRect.height());
+        Rect clipRect = m_clipRect.translated(-m_drawOrigin);
+        glScissor(clipRect.left(), m_resolution.height() - clipRect.bottom() - 1, clipRect.width(), clipRect.height());
     } else {
         glScissor(0, 0, m_resolution.width(), m_resolution.height());
         glDisable(GL_SCISSOR_TEST);
@@ -30,6 +30,7 @@ class PainterOGL : public Painter
 public:
     struct PainterState {
         Size resolution;
+        Point drawOrigin;
         Matrix3 transformMatrix;
         Matrix3 projectionMatrix;
         Matrix3 textureMatrix;
@@ -58,18 +59,20 @@ public:
     void clear(const Color& color);
     void clearRect(const Color& color, const Rect& rect);
 
-    virtual void setTransformMatrix(const Matrix3& transformMatrix) { m_transformMatrix = transformMatrix; }
-    virtual void setProjectionMatrix(const Matrix3& projectionMatrix) { m_projectionMatrix = projectionMatrix; }
+    virtual void setTransformMatrix(const Matrix3& transformMatrix) { if(m_transformMatrix != transformMatrix) flush(); m_transformMatrix = transformMatrix; }
+    virtual void setProjectionMatrix(const Matrix3& projectionMatrix) { if(m_projectionMatrix != projectionMatrix) flush(); m_projectionMatrix = projectionMatrix; }
     virtual void setTextureMatrix(const Matrix3& textureMatrix) { m_textureMatrix = textureMatrix; }
     virtual void setCompositionMode(CompositionMode compositionMode);
     virtual void setBlendEquation(BlendEquation blendEquation);
     virtual void setClipRect(const Rect& clipRect);
-    virtual void setShaderProgram(PainterShaderProgram *shaderProgram) { m_shaderProgram = shaderProgram; }
+    virtual void setShaderProgram(PainterShaderProgram *shaderProgram) { if(m_shaderProgram != shaderProgram) flush(); m_shaderProgram = shaderProgram; }
     virtual void setTexture(Texture *texture);
     virtual void setAlphaWriting(bool enable);
+    virtual void setOpacity(float opacity) { if(m_opacity != opacity) flush(); m_opacity = opacity; }
 
     void setTexture(const TexturePtr& texture) { setTexture(texture.get()); }
     void setResolution(const Size& resolution);
+    void setDrawOrigin(const Point& origin);
 
     void scale(float x, float y);
     void translate(float x, float y);
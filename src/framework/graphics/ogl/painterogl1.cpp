@@ -81,6 +81,8 @@ void PainterOGL1::drawCoords(CoordsBuffer& coordsBuffer, DrawMode drawMode)
     if(g_graphics.hasScissorBug())
         updateGlClipRect();
 
+    m_drawCalls++;
+
     // use vertex arrays if possible, much faster
     if(g_graphics.canUseDrawArrays()) {
         // update coords buffer hardware caches if enabled
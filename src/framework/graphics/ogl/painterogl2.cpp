@@ -22,6 +22,7 @@
 
 #include "painterogl2.h"
 #include "painterogl2_shadersources.h"
+#include <framework/graphics/textureatlas.h>
 #include <framework/platform/platformwindow.h>
 
 PainterOGL2 *g_painterOGL2 = nullptr;
@@ -29,6 +30,7 @@ PainterOGL2 *g_painterOGL2 = nullptr;
 PainterOGL2::PainterOGL2()
 {
     m_drawProgram = nullptr;
+    m_textureBatchCount = 0;
     resetState();
 
     m_drawTexturedProgram = PainterShaderProgramPtr(new PainterShaderProgram);
@@ -58,13 +60,111 @@ void PainterOGL2::bind()
 
 void PainterOGL2::unbind()
 {
+    flush();
     PainterShaderProgram::disableAttributeArray(PainterShaderProgram::VERTEX_ATTR);
     PainterShaderProgram::disableAttributeArray(PainterShaderProgram::TEXCOORD_ATTR);
     PainterShaderProgram::release();
 }
 
+void PainterOGL2::flush()
+{
+    int count = m_textureBatchCount;
+    if(count == 0)
+        return;
+    m_textureBatchCount = 0;
+
+    // the batches carry their own texture and color, everything else is the current state
+    Color color = m_color;
+    Texture *texture = m_texture;
+    Matrix3 textureMatrix = m_textureMatrix;
+    PainterShaderProgram *drawProgram = m_drawProgram;
+
+    setDrawProgram(m_drawTexturedProgram.get());
+    for(int i = 0; i < count; ++i) {
+        TextureBatch& batch = m_textureBatches[i];
+        m_color = batch.color;
+        setTexture(batch.texture.get());
+        drawCoords(batch.coordsBuffer);
+    }
+
+    m_color = color;
+    setTexture(texture);
+    m_textureMatrix = textureMatrix;
+    m_drawProgram = drawProgram;
+
+    for(int i = 0; i < count; ++i) {
+        m_textureBatches[i].coordsBuffer.clear();
+        m_textureBatches[i].texture = nullptr;
+    }
+}
+
+bool PainterOGL2::batchTextureCoords(CoordsBuffer& coordsBuffer, const TexturePtr& texture)
+{
+    int vertexCount = coordsBuffer.getVertexCount();
+    if(m_shaderProgram || vertexCount == 0 || vertexCount > MAX_BATCH_VERTICES || coordsBuffer.getTextureCoordCount() != vertexCount)
+        return false;
+
+    float *vertices = coordsBuffer.getVertexArray();
+    float left = vertices[0], top = vertices[1], right = vertices[0], bottom = vertices[1];
+    for(int i = 2; i < vertexCount * 2; i += 2) {
+        left = std::min<float>(left, vertices[i]);
+        right = std::max<float>(right, vertices[i]);
+        top = std::min<float>(top, vertices[i+1]);
+        bottom = std::max<float>(bottom, vertices[i+1]);
+    }
+
+    // images packed in an atlas are batched with every other image of their page
+    const TexturePtr *batchTexture = &texture;
+    Point textureOffset;
+    if(texture->isAtlasTexture()) {
+        AtlasTexture *atlasTexture = static_cast<AtlasTexture*>(texture.get());
+        batchTexture = &atlasTexture->getPage();
+        textureOffset = atlasTexture->getOffset();
+    }
+
+    // join the newest batch with the same texture and color, unless the geometry overlaps
+    // something drawn after that batch, which would then end up below it
+    int index = -1;
+    for(int i = m_textureBatchCount - 1; i >= 0; --i) {
+        TextureBatch& batch = m_textureBatches[i];
+        if(batch.texture == *batchTexture && batch.color == m_color) {
+            index = i;
+            break;
+        }
+        if(left < batch.right && right > batch.left && top < batch.bottom && bottom > batch.top)
+            break;
+    }
+
+    if(index == -1) {
+        if(m_textureBatchCount == MAX_TEXTURE_BATCHES)
+            flush();
+        index = m_textureBatchCount++;
+        TextureBatch& batch = m_textureBatches[index];
+        batch.texture = *batchTexture;
+        batch.color = m_color;
+        batch.left = left;
+        batch.top = top;
+        batch.right = right;
+        batch.bottom = bottom;
+    } else {
+        TextureBatch& batch = m_textureBatches[index];
+        batch.left = std::min<float>(batch.left, left);
+        batch.top = std::min<float>(batch.top, top);
+        batch.right = std::max<float>(batch.right, right);
+        batch.bottom = std::max<float>(batch.bottom, bottom);
+    }
+
+    if(textureOffset.isNull())
+        m_textureBatches[index].coordsBuffer.append(coordsBuffer);
+    else
+        m_textureBatches[index].coordsBuffer.append(coordsBuffer, textureOffset);
+    return true;
+}
+
 void PainterOGL2::drawCoords(CoordsBuffer& coordsBuffer, DrawMode drawMode)
 {
+    flush();
+
     int vertexCount = coordsBuffer.getVertexCount();
     if(vertexCount == 0)
         return;
@@ -88,6 +188,8 @@ void PainterOGL2::drawCoords(CoordsBuffer& coordsBuffer, DrawMode drawMode)
     m_drawProgram->setResolution(m_resolution);
     m_drawProgram->updateTime();
 
+    m_drawCalls++;
+
     // update coords buffer hardware caches if enabled
     coordsBuffer.updateCaches();
     bool hardwareCached = coordsBuffer.isHardwareCached();
@@ -132,6 +234,9 @@ void PainterOGL2::drawTextureCoords(CoordsBuffer& coordsBuffer, const TexturePtr
     if(texture && texture->isEmpty())
         return;
 
+    if(texture && batchTextureCoords(coordsBuffer, texture))
+        return;
+
     setDrawProgram(m_shaderProgram ? m_shaderProgram : m_drawTexturedProgram.get());
     setTexture(texture);
     drawCoords(coordsBuffer);
@@ -142,6 +247,13 @@ void PainterOGL2::drawTexturedRect(const Rect& dest, const TexturePtr& texture,
     if(dest.isEmpty() || src.isEmpty() || texture->isEmpty())
         return;
 
+    if(!m_shaderProgram) {
+        m_coordsBuffer.clear();
+        m_coordsBuffer.addRect(dest, src);
+        if(batchTextureCoords(m_coordsBuffer, texture))
+            return;
+    }
+
     setDrawProgram(m_shaderProgram ? m_shaderProgram : m_drawTexturedProgram.get());
     setTexture(texture);
 
@@ -168,11 +280,13 @@ void PainterOGL2::drawRepeatedTexturedRect(const Rect& dest, const TexturePtr& t
     if(dest.isEmpty() || src.isEmpty() || texture->isEmpty())
         return;
 
-    setDrawProgram(m_shaderProgram ? m_shaderProgram : m_drawTexturedProgram.get());
-    setTexture(texture);
-
     m_coordsBuffer.clear();
     m_coordsBuffer.addRepeatedRects(dest, src);
+    if(batchTextureCoords(m_coordsBuffer, texture))
+        return;
+
+    setDrawProgram(m_shaderProgram ? m_shaderProgram : m_drawTexturedProgram.get());
+    setTexture(texture);
     drawCoords(m_coordsBuffer);
 }
 
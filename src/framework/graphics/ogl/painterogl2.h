@@ -34,12 +34,27 @@
  */
 class PainterOGL2 : public PainterOGL
 {
+    enum {
+        MAX_TEXTURE_BATCHES = 8,
+        MAX_BATCH_VERTICES = 1024
+    };
+
+    // textured geometry held back to be submitted in a single draw
+    struct TextureBatch {
+        TexturePtr texture;
+        Color color;
+        float left, top, right, bottom;
+        CoordsBuffer coordsBuffer;
+    };
+
 public:
     PainterOGL2();
 
     void bind();
     void unbind();
 
+    void flush();
+
     void drawCoords(CoordsBuffer& coordsBuffer, DrawMode drawMode = Triangles);
     void drawFillCoords(CoordsBuffer& coordsBuffer);
     void drawTextureCoords(CoordsBuffer& coordsBuffer, const TexturePtr& texture);
@@ -55,6 +70,10 @@ public:
     bool hasShaders() { return true; }
 
 private:
+    bool batchTextureCoords(CoordsBuffer& coordsBuffer, const TexturePtr& texture);
+
+    TextureBatch m_textureBatches[MAX_TEXTURE_BATCHES];
+    int m_textureBatchCount;
     PainterShaderProgram *m_drawProgram;
     PainterShaderProgramPtr m_drawTexturedProgram;
     PainterShaderProgramPtr m_drawSolidColorProgram;
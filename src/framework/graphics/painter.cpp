@@ -29,5 +29,5 @@ Painter *g_painter = nullptr;
 
 Painter::Painter()
 {
-
+    m_drawCalls = 0;
 }
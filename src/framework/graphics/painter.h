@@ -27,6 +27,7 @@
 #include <framework/graphics/coordsbuffer.h>
 #include <framework/graphics/paintershaderprogram.h>
 #include <framework/graphics/texture.h>
+#include <unordered_set>
 
 class Painter
 {
@@ -41,7 +42,8 @@ public:
         CompositionMode_Add,
         CompositionMode_Replace,
         CompositionMode_DestBlending,
-        CompositionMode_Light
+        CompositionMode_Light,
+        CompositionMode_Premultiplied
     };
     enum DrawMode {
         Triangles = GL_TRIANGLES,
@@ -60,6 +62,8 @@ public:
     virtual void restoreSavedState() = 0;
 
     virtual void clear(const Color& color) = 0;
+    /// Submits the draws the painter is still holding back for batching
+    virtual void flush() { }
 
     virtual void drawCoords(CoordsBuffer& coordsBuffer, DrawMode drawMode = Triangles) = 0;
     virtual void drawFillCoords(CoordsBuffer& coordsBuffer) = 0;
@@ -90,12 +94,16 @@ public:
 
     virtual void setOpacity(float opacity) { m_opacity = opacity; }
     virtual void setResolution(const Size& resolution) { m_resolution = resolution; }
+    virtual void setDrawOrigin(const Point& origin) { m_drawOrigin = origin; }
 
     Size getResolution() { return m_resolution; }
+    Point getDrawOrigin() { return m_drawOrigin; }
     Color getColor() { return m_color; }
     float getOpacity() { return m_opacity; }
     Rect getClipRect() { return m_clipRect; }
     CompositionMode getCompositionMode() { return m_compositionMode; }
+    int getDrawCalls() { return m_drawCalls; }
+    int getBoundTextureCount() { return m_boundTextures.size(); }
 
     virtual void setCompositionMode(CompositionMode compositionMode) = 0;
 
@@ -107,6 +115,8 @@ public:
     void resetCompositionMode() { setCompositionMode(CompositionMode_Normal); }
     void resetColor() { setColor(Color::white); }
     void resetShaderProgram() { setShaderProgram(nullptr); }
+    void resetDrawOrigin() { setDrawOrigin(Point()); }
+    void resetFrameStats() { m_drawCalls = 0; m_boundTextures.clear(); }
 
     virtual bool hasShaders() = 0;
 
@@ -115,8 +125,11 @@ protected:
     CompositionMode m_compositionMode;
     Color m_color;
     Size m_resolution;
+    Point m_drawOrigin;
     float m_opacity;
     Rect m_clipRect;
+    int m_drawCalls;
+    std::unordered_set<uint> m_boundTextures;
 };
 
 extern Painter *g_painter;
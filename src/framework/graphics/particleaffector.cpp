@@ -20,7 +20,7 @@
  * THE SOFTWARE.
  */
 
-#include "particle.h"
+#include "particlepool.h"
 #include "particleaffector.h"
 #include <framework/core/clock.h>
 
@@ -87,14 +87,20 @@ void GravityAffector::load(const OTMLNodePtr& node)
     }
 }
 
-void GravityAffector::updateParticle(const ParticlePtr& particle, float elapsedTime)
+void GravityAffector::updateParticles(const ParticlePoolPtr& pool, float elapsedTime)
 {
     if(!m_active)
         return;
 
-    PointF velocity = particle->getVelocity();
-    velocity += PointF(m_gravity * elapsedTime * std::cos(m_angle), m_gravity * elapsedTime * std::sin(m_angle));
-    particle->setVelocity(velocity);
+    const int count = pool->size();
+    float *velocityX = pool->getVelocityX();
+    float *velocityY = pool->getVelocityY();
+    const float deltaX = m_gravity * elapsedTime * std::cos(m_angle);
+    const float deltaY = m_gravity * elapsedTime * std::sin(m_angle);
+    for(int i = 0; i < count; ++i) {
+        velocityX[i] += deltaX;
+        velocityY[i] += deltaY;
+    }
 }
 
 void AttractionAffector::load(const OTMLNodePtr& node)
@@ -117,20 +123,26 @@ void AttractionAffector::load(const OTMLNodePtr& node)
     }
 }
 
-void AttractionAffector::updateParticle(const ParticlePtr& particle, float elapsedTime)
+void AttractionAffector::updateParticles(const ParticlePoolPtr& pool, float elapsedTime)
 {
     if(!m_active)
         return;
 
-    PointF pPosition = particle->getPosition();
-    PointF d = PointF(m_position.x - pPosition.x, pPosition.y - m_position.y);
-    if(d.length() == 0)
-        return;
-
-    PointF direction = PointF(1, 1);
-    if(m_repelish)
-        direction = PointF(-1, -1);
-
-    PointF pVelocity = particle->getVelocity() + (d / d.length() * m_acceleration * elapsedTime) * direction;
-    particle->setVelocity(pVelocity - pVelocity * m_reduction/100.0 * elapsedTime);
+    const int count = pool->size();
+    const float *positionX = pool->getPositionX();
+    const float *positionY = pool->getPositionY();
+    float *velocityX = pool->getVelocityX();
+    float *velocityY = pool->getVelocityY();
+    const float acceleration = (m_repelish ? -m_acceleration : m_acceleration) * elapsedTime;
+    const float reduction = 1.0f - m_reduction/100.0f * elapsedTime;
+    for(int i = 0; i < count; ++i) {
+        float dx = m_position.x - positionX[i];
+        float dy = positionY[i] - m_position.y;
+        float length = std::sqrt(dx * dx + dy * dy);
+        if(length == 0)
+            continue;
+
+        velocityX[i] = (velocityX[i] + dx / length * acceleration) * reduction;
+        velocityY[i] = (velocityY[i] + dy / length * acceleration) * reduction;
+    }
 }
@@ -33,7 +33,7 @@ public:
 
     void update(float elapsedTime);
     virtual void load(const OTMLNodePtr& node);
-    virtual void updateParticle(const ParticlePtr&, float) {}
+    virtual void updateParticles(const ParticlePoolPtr&, float) {}
 
     bool hasFinished() { return m_finished; }
 
@@ -46,7 +46,7 @@ protected:
 class GravityAffector : public ParticleAffector {
 public:
     void load(const OTMLNodePtr& node);
-    void updateParticle(const ParticlePtr& particle, float elapsedTime);
+    void updateParticles(const ParticlePoolPtr& pool, float elapsedTime);
 
 private:
     float m_angle, m_gravity;
@@ -55,7 +55,7 @@ private:
 class AttractionAffector : public ParticleAffector {
 public:
     void load(const OTMLNodePtr& node);
-    void updateParticle(const ParticlePtr& particle, float elapsedTime);
+    void updateParticles(const ParticlePoolPtr& pool, float elapsedTime);
 
 private:
     Point m_position;
@@ -20,7 +20,7 @@
  * THE SOFTWARE.
  */
 
-#include "particle.h"
+#include "particlepool.h"
 #include "particleemitter.h"
 #include "particlesystem.h"
 #include <framework/core/clock.h>
@@ -60,9 +60,11 @@ void ParticleEmitter::load(const OTMLNodePtr& node)
 
     if(!m_particleType)
         stdext::throw_exception("emitter didn't provide a valid particle type");
+
+    m_pool = ParticlePoolPtr(new ParticlePool(m_particleType));
 }
 
-void ParticleEmitter::update(float elapsedTime, const ParticleSystemPtr& system)
+void ParticleEmitter::update(float elapsedTime)
 {
     m_elapsedTime += elapsedTime;
 
@@ -100,12 +102,7 @@ void ParticleEmitter::update(float elapsedTime, const ParticleSystemPtr& system)
             float pAccelerationAngle = stdext::random_range(type->pMinAccelerationAngle, type->pMaxAccelerationAngle);
             PointF pAcceleration(pAccelerationAbs * std::cos(pAccelerationAngle), pAccelerationAbs * std::sin(pAccelerationAngle));
 
-            ParticlePtr particle(new Particle(pPosition, type->pStartSize, type->pFinalSize,
-                                                pVelocity, pAcceleration,
-                                                pDuration, type->pIgnorePhysicsAfter,
-                                                type->pColors, type->pColorsStops,
-                                                type->pCompositionMode, type->pTexture));
-            system->addParticle(particle);
+            m_pool->addParticle(PointF(pPosition.x, pPosition.y), pVelocity, pAcceleration, pDuration);
         }
     }
 
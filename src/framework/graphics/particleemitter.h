@@ -36,9 +36,10 @@ public:
 
     void load(const OTMLNodePtr& node);
 
-    void update(float elapsedTime, const ParticleSystemPtr& system);
+    void update(float elapsedTime);
 
     bool hasFinished() { return m_finished; }
+    const ParticlePoolPtr& getPool() { return m_pool; }
 
 private:
     // self related
@@ -49,6 +50,7 @@ private:
     float m_burstRate;
     int m_currentBurst, m_burstCount;
     ParticleTypePtr m_particleType;
+    ParticlePoolPtr m_pool;
 };
 
 #endif
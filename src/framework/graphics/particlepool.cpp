@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2010-2017 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "particlepool.h"
+#include "particletype.h"
+#include "texture.h"
+
+ParticlePool::ParticlePool(const ParticleTypePtr& type)
+{
+    m_texture = type->pTexture;
+    m_compositionMode = type->pCompositionMode;
+    m_startSize = type->pStartSize;
+    m_finalSize = type->pFinalSize;
+    m_ignorePhysicsAfter = type->pIgnorePhysicsAfter;
+
+    // colors are interpolated once per step of the gradient here instead of once per particle on every update
+    const std::vector<Color>& colors = type->pColors;
+    m_colorsStops = type->pColorsStops;
+    m_colorsCount = std::min<int>(colors.size(), m_colorsStops.size());
+    if(m_colorsCount >= 2) {
+        for(int k = 0; k < m_colorsCount - 1; ++k) {
+            for(int q = 0; q < COLOR_STEPS; ++q) {
+                float factor = q / (float)(COLOR_STEPS - 1);
+                m_colorTable.push_back(colors[k] * (1.0f - factor) + colors[k + 1] * factor);
+            }
+        }
+        m_colorTable.push_back(colors[m_colorsCount - 1]);
+    } else
+        m_colorTable.push_back(colors.empty() ? Color::white : colors[0]);
+}
+
+void ParticlePool::addParticle(const PointF& position, const PointF& velocity, const PointF& acceleration, float duration)
+{
+    m_positionX.push_back(position.x);
+    m_positionY.push_back(position.y);
+    m_velocityX.push_back(velocity.x);
+    m_velocityY.push_back(velocity.y);
+    m_accelerationX.push_back(acceleration.x);
+    m_accelerationY.push_back(acceleration.y);
+    m_elapsedTime.push_back(0);
+    m_duration.push_back(duration);
+}
+
+void ParticlePool::removeFinished()
+{
+    // compact in place, keeping the order particles were emitted in
+    int count = size();
+    int alive = 0;
+    for(int i = 0; i < count; ++i) {
+        if(m_duration[i] >= 0 && m_elapsedTime[i] >= m_duration[i])
+            continue;
+
+        if(alive != i) {
+            m_positionX[alive] = m_positionX[i];
+            m_positionY[alive] = m_positionY[i];
+            m_velocityX[alive] = m_velocityX[i];
+            m_velocityY[alive] = m_velocityY[i];
+            m_accelerationX[alive] = m_accelerationX[i];
+            m_accelerationY[alive] = m_accelerationY[i];
+            m_elapsedTime[alive] = m_elapsedTime[i];
+            m_duration[alive] = m_duration[i];
+        }
+        ++alive;
+    }
+
+    if(alive == count)
+        return;
+
+    m_positionX.resize(alive);
+    m_positionY.resize(alive);
+    m_velocityX.resize(alive);
+    m_velocityY.resize(alive);
+    m_accelerationX.resize(alive);
+    m_accelerationY.resize(alive);
+    m_elapsedTime.resize(alive);
+    m_duration.resize(alive);
+}
+
+void ParticlePool::update(float elapsedTime)
+{
+    const int count = size();
+    float *positionX = m_positionX.data();
+    float *positionY = m_positionY.data();
+    float *velocityX = m_velocityX.data();
+    float *velocityY = m_velocityY.data();
+    const float *accelerationX = m_accelerationX.data();
+    const float *accelerationY = m_accelerationY.data();
+    float *particleElapsedTime = m_elapsedTime.data();
+
+    // painter orientate Y axis in the inverse direction
+    if(m_ignorePhysicsAfter < 0) {
+        for(int i = 0; i < count; ++i) {
+            positionX[i] += velocityX[i] * elapsedTime;
+            positionY[i] -= velocityY[i] * elapsedTime;
+            velocityX[i] += accelerationX[i] * elapsedTime;
+            velocityY[i] += accelerationY[i] * elapsedTime;
+        }
+    } else {
+        for(int i = 0; i < count; ++i) {
+            float step = particleElapsedTime[i] < m_ignorePhysicsAfter ? elapsedTime : 0.0f;
+            positionX[i] += velocityX[i] * step;
+            positionY[i] -= velocityY[i] * step;
+            velocityX[i] += accelerationX[i] * step;
+            velocityY[i] += accelerationY[i] * step;
+        }
+    }
+
+    for(int i = 0; i < count; ++i)
+        particleElapsedTime[i] += elapsedTime;
+}
+
+int ParticlePool::getColorIndex(int i)
+{
+    int last = m_colorTable.size() - 1;
+    if(m_colorsCount < 2)
+        return last;
+
+    float life = m_duration[i] > 0 ? m_elapsedTime[i] / m_duration[i] : 0;
+
+    int k = 0;
+    while(k + 1 < m_colorsCount && life >= m_colorsStops[k + 1])
+        ++k;
+    if(k + 1 >= m_colorsCount)
+        return last;
+
+    float factor = (life - m_colorsStops[k]) / (m_colorsStops[k + 1] - m_colorsStops[k]);
+    factor = std::max<float>(0.0f, std::min<float>(factor, 1.0f));
+    return k * COLOR_STEPS + (int)(factor * (COLOR_STEPS - 1) + 0.5f);
+}
+
+void ParticlePool::render()
+{
+    const int count = size();
+    if(count == 0)
+        return;
+
+    Rect src;
+    if(m_texture) {
+        src = Rect(Point(0, 0), m_texture->getSize());
+        g_painter->setCompositionMode(m_compositionMode);
+    }
+
+    // the painter takes one color per draw, so consecutive particles sharing a gradient
+    // step go out as a single draw; particles of one emitter age together, so runs are long
+    // and the emission order is kept for blending
+    Size sizeRange = m_finalSize - m_startSize;
+    int colorIndex = getColorIndex(0);
+    m_coordsBuffer.clear();
+    for(int i = 0; i < count; ++i) {
+        int index = getColorIndex(i);
+        if(index != colorIndex) {
+            drawCoords(colorIndex);
+            colorIndex = index;
+        }
+
+        float life = m_duration[i] > 0 ? m_elapsedTime[i] / m_duration[i] : 0;
+        int width = m_startSize.width() + (int)(sizeRange.width() * life);
+        int height = m_startSize.height() + (int)(sizeRange.height() * life);
+        Rect dest((int)m_positionX[i] - width / 2, (int)m_positionY[i] - height / 2, width, height);
+
+        if(m_texture)
+            m_coordsBuffer.addRect(dest, src);
+        else
+            m_coordsBuffer.addRect(dest);
+    }
+    drawCoords(colorIndex);
+}
+
+void ParticlePool::drawCoords(int colorIndex)
+{
+    g_painter->setColor(m_colorTable[colorIndex]);
+    if(m_texture)
+        g_painter->drawTextureCoords(m_coordsBuffer, m_texture);
+    else
+        g_painter->drawFillCoords(m_coordsBuffer);
+    m_coordsBuffer.clear();
+}
@@ -20,46 +20,58 @@
  * THE SOFTWARE.
  */
 
-#ifndef PARTICLE_H
-#define PARTICLE_H
+#ifndef PARTICLEPOOL_H
+#define PARTICLEPOOL_H
 
 #include "declarations.h"
+#include "coordsbuffer.h"
 #include "painter.h"
 
-class Particle : public stdext::shared_object
+// Particles of one emitter, stored as parallel arrays so the per step integration
+// and the affectors run as plain loops over contiguous floats.
+class ParticlePool : public stdext::shared_object
 {
+    enum {
+        COLOR_STEPS = 32
+    };
+
 public:
-    Particle(const Point& pos, const Size& startSize, const Size& finalSize, const PointF& velocity, const PointF& acceleration, float duration, float ignorePhysicsAfter, const std::vector<Color>& colors, const std::vector<float>& colorsStops, Painter::CompositionMode compositionMode = Painter::CompositionMode_Normal, TexturePtr texture = nullptr);
+    ParticlePool(const ParticleTypePtr& type);
+
+    void addParticle(const PointF& position, const PointF& velocity, const PointF& acceleration, float duration);
+    void removeFinished();
 
     void render();
     void update(float elapsedTime);
 
-    bool hasFinished() { return m_finished; }
-
-    PointF getPosition() { return m_position; }
-    PointF getVelocity() { return m_velocity; }
+    int size() { return m_elapsedTime.size(); }
+    bool isEmpty() { return m_elapsedTime.empty(); }
 
-    void setPosition(const PointF& position) { m_position = position; }
-    void setVelocity(const PointF& velocity) { m_velocity = velocity; }
+    float *getPositionX() { return m_positionX.data(); }
+    float *getPositionY() { return m_positionY.data(); }
+    float *getVelocityX() { return m_velocityX.data(); }
+    float *getVelocityY() { return m_velocityY.data(); }
 
 private:
-    void updateColor();
-    void updatePosition(float elapsedTime);
-    void updateSize();
+    int getColorIndex(int i);
+    void drawCoords(int colorIndex);
 
-    Color m_color;
-    std::vector<Color> m_colors;
+    std::vector<float> m_positionX, m_positionY;
+    std::vector<float> m_velocityX, m_velocityY;
+    std::vector<float> m_accelerationX, m_accelerationY;
+    std::vector<float> m_elapsedTime, m_duration;
+
+    // shared by every particle of the pool
+    std::vector<Color> m_colorTable;
     std::vector<float> m_colorsStops;
+    int m_colorsCount;
     TexturePtr m_texture;
-    PointF m_position;
-    PointF m_velocity;
-    PointF m_acceleration;
-    Size m_size, m_startSize, m_finalSize;
-    Rect m_rect;
     Painter::CompositionMode m_compositionMode;
-    float m_duration, m_ignorePhysicsAfter;
-    float m_elapsedTime;
-    bool m_finished;
+    Size m_startSize, m_finalSize;
+    float m_ignorePhysicsAfter;
+
+    // render scratch, kept to avoid reallocating every frame
+    CoordsBuffer m_coordsBuffer;
 };
 
 #endif
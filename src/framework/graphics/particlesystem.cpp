@@ -20,7 +20,7 @@
  * THE SOFTWARE.
  */
 
-#include "particle.h"
+#include "particlepool.h"
 #include "particlesystem.h"
 #include <framework/core/clock.h>
 
@@ -37,6 +37,7 @@ void ParticleSystem::load(const OTMLNodePtr& node)
             ParticleEmitterPtr emitter = ParticleEmitterPtr(new ParticleEmitter());
             emitter->load(childNode);
             m_emitters.push_back(emitter);
+            m_pools.push_back(emitter->getPool());
         }
         else if(childNode->tag().find("Affector") != std::string::npos) {
             ParticleAffectorPtr affector;
@@ -54,15 +55,10 @@ void ParticleSystem::load(const OTMLNodePtr& node)
     }
 }
 
-void ParticleSystem::addParticle(const ParticlePtr& particle)
-{
-    m_particles.push_back(particle);
-}
-
 void ParticleSystem::render()
 {
-    for(auto it = m_particles.begin(), end = m_particles.end(); it != end; ++it)
-        (*it)->render();
+    for(const ParticlePoolPtr& pool : m_pools)
+        pool->render();
     g_painter->resetCompositionMode();
 }
 
@@ -76,14 +72,13 @@ void ParticleSystem::update()
         return;
 
     // check if finished
-    if(m_particles.empty() && m_emitters.empty()) {
+    if(m_emitters.empty() && std::all_of(m_pools.begin(), m_pools.end(), [](const ParticlePoolPtr& pool) { return pool->isEmpty(); })) {
         m_finished = true;
         return;
     }
 
     m_lastUpdateTime = g_clock.seconds() - std::fmod(elapsedTime, delay);
 
-    auto self = static_self_cast<ParticleSystem>();
     for(int i = 0; i < std::floor(elapsedTime / delay); ++i) {
 
         // update emitters
@@ -92,7 +87,7 @@ void ParticleSystem::update()
             if(emitter->hasFinished()) {
                 it = m_emitters.erase(it);
             } else {
-                emitter->update(delay, self);
+                emitter->update(delay);
                 ++it;
             }
         }
@@ -109,18 +104,14 @@ void ParticleSystem::update()
         }
 
         // update particles
-        for(auto it = m_particles.begin(); it != m_particles.end();) {
-            const ParticlePtr& particle = *it;
-            if(particle->hasFinished()) {
-                it = m_particles.erase(it);
-            } else {
-                // pass particles through affectors
-                for(const ParticleAffectorPtr& particleAffector : m_affectors)
-                    particleAffector->updateParticle(particle, delay);
+        for(const ParticlePoolPtr& pool : m_pools) {
+            pool->removeFinished();
 
-                particle->update(delay);
-                ++it;
-            }
+            // pass particles through affectors
+            for(const ParticleAffectorPtr& particleAffector : m_affectors)
+                particleAffector->updateParticles(pool, delay);
+
+            pool->update(delay);
         }
     }
 }
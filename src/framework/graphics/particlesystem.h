@@ -24,7 +24,7 @@
 #define PARTICLESYSTEM_H
 
 #include "declarations.h"
-#include "particle.h"
+#include "particlepool.h"
 #include "particleemitter.h"
 #include "particleaffector.h"
 
@@ -34,8 +34,6 @@ public:
 
     void load(const OTMLNodePtr& node);
 
-    void addParticle(const ParticlePtr& particle);
-
     void render();
     void update();
 
@@ -44,7 +42,7 @@ public:
 private:
     bool m_finished;
     float m_lastUpdateTime;
-    std::list<ParticlePtr> m_particles;
+    std::vector<ParticlePoolPtr> m_pools;
     std::list<ParticleEmitterPtr> m_emitters;
     std::list<ParticleAffectorPtr> m_affectors;
 };
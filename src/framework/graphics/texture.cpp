@@ -73,6 +73,10 @@ void Texture::uploadPixels(const ImagePtr& image, bool buildMipmaps, bool compre
     if(!setupSize(image->getSize(), buildMipmaps))
         return;
 
+    // placeholders handed out by async loads receive their pixels later
+    if(!m_id)
+        createTexture();
+
     ImagePtr glImage = image;
     if(m_size != m_glSize) {
         glImage = ImagePtr(new Image(m_glSize, image->getBpp()));
@@ -95,6 +99,13 @@ void Texture::uploadPixels(const ImagePtr& image, bool buildMipmaps, bool compre
     setupFilters();
 }
 
+void Texture::updatePixels(const Rect& rect, const uchar *pixels)
+{
+    // replaces a rect of the base level with rgba pixels, mipmaps must be rebuilt by the caller
+    bind();
+    glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x(), rect.y(), rect.width(), rect.height(), GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+}
+
 void Texture::bind()
 {
     // must reset painter texture state
@@ -104,6 +115,8 @@ void Texture::bind()
 
 void Texture::copyFromScreen(const Rect& screenRect)
 {
+    // draws held back by the painter must reach the screen before it is read
+    g_painter->flush();
     bind();
     glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, screenRect.x(), screenRect.y(), screenRect.width(), screenRect.height());
 }
@@ -34,6 +34,7 @@ public:
     virtual ~Texture();
 
     void uploadPixels(const ImagePtr& image, bool buildMipmaps = false, bool compress = false);
+    void updatePixels(const Rect& rect, const uchar *pixels);
     void bind();
     void copyFromScreen(const Rect& screenRect);
     virtual bool buildHardwareMipmaps();
@@ -54,6 +55,7 @@ public:
     bool hasRepeat() { return m_repeat; }
     bool hasMipmaps() { return m_hasMipmaps; }
     virtual bool isAnimatedTexture() { return false; }
+    virtual bool isAtlasTexture() { return false; }
 
 protected:
     void createTexture();
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2010-2017 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "textureatlas.h"
+#include "graphics.h"
+#include "image.h"
+
+AtlasTexture::AtlasTexture(const TexturePtr& page, const Rect& rect)
+{
+    m_page = page;
+    m_rect = rect;
+    m_id = page->getId();
+    m_size = rect.size();
+    m_glSize = page->getGlSize();
+    m_transformMatrix = { 1.0f/m_glSize.width(),            0.0f,                              0.0f,
+                          0.0f,                             1.0f/m_glSize.height(),            0.0f,
+                          rect.x()/(float)m_glSize.width(), rect.y()/(float)m_glSize.height(), 1.0f };
+}
+
+AtlasTexture::~AtlasTexture()
+{
+    // the gl texture is owned by the page
+    m_id = 0;
+}
+
+void AtlasTexture::reload(const ImagePtr& image)
+{
+    if(image->getSize() != m_size || image->getBpp() != 4)
+        return;
+    TextureAtlas::uploadPadded(m_page, m_rect, image);
+}
+
+TextureAtlas::TextureAtlas()
+{
+    m_pageSize = 0;
+}
+
+AtlasTexturePtr TextureAtlas::add(const ImagePtr& image)
+{
+    if(image->getBpp() != 4 || image->getPixelCount() == 0)
+        return nullptr;
+
+    Size size = image->getSize() + Size(PADDING * 2, PADDING * 2);
+    int pageSize = getPageSize();
+    if(size.width() > pageSize || size.height() > pageSize)
+        return nullptr;
+
+    Point pos;
+    Page *page = nullptr;
+    for(Page& p : m_pages) {
+        if(allocate(p, size, pos)) {
+            page = &p;
+            break;
+        }
+    }
+
+    if(!page) {
+        Page newPage;
+        newPage.texture = TexturePtr(new Texture(Size(pageSize, pageSize)));
+        if(newPage.texture->isEmpty())
+            return nullptr;
+        newPage.texture->setSmooth(true);
+        newPage.height = 0;
+        m_pages.push_back(newPage);
+        page = &m_pages.back();
+        if(!allocate(*page, size, pos))
+            return nullptr;
+    }
+
+    Rect rect(pos + Point(PADDING, PADDING), image->getSize());
+    uploadPadded(page->texture, rect, image);
+    return AtlasTexturePtr(new AtlasTexture(page->texture, rect));
+}
+
+int TextureAtlas::getPageSize()
+{
+    if(m_pageSize == 0)
+        m_pageSize = std::min<int>(MAX_PAGE_SIZE, g_graphics.getMaxTextureSize());
+    return m_pageSize;
+}
+
+bool TextureAtlas::allocate(Page& page, const Size& size, Point& pos)
+{
+    // the shelf wasting the least height wins
+    Shelf *best = nullptr;
+    for(Shelf& shelf : page.shelves) {
+        if(shelf.height >= size.height() && shelf.width + size.width() <= m_pageSize) {
+            if(!best || shelf.height < best->height)
+                best = &shelf;
+        }
+    }
+
+    // a much taller shelf is only used once the page has no room for a new one
+    bool roomForShelf = page.height + size.height() <= m_pageSize;
+    if(best && best->height > size.height() * 2 && roomForShelf)
+        best = nullptr;
+
+    if(!best) {
+        if(!roomForShelf)
+            return false;
+        Shelf shelf;
+        shelf.y = page.height;
+        shelf.height = size.height();
+        shelf.width = 0;
+        page.shelves.push_back(shelf);
+        page.height += size.height();
+        best = &page.shelves.back();
+    }
+
+    pos = Point(best->width, best->y);
+    best->width += size.width();
+    return true;
+}
+
+void TextureAtlas::uploadPadded(const TexturePtr& page, const Rect& rect, const ImagePtr& image)
+{
+    int width = image->getWidth();
+    int height = image->getHeight();
+    int paddedWidth = width + PADDING * 2;
+    int paddedHeight = height + PADDING * 2;
+
+    std::vector<uint8> pixels(paddedWidth * paddedHeight * 4);
+    const uint32 *src = (const uint32*)image->getPixelData();
+    uint32 *dest = (uint32*)&pixels[0];
+    for(int y = 0; y < paddedHeight; ++y) {
+        const uint32 *srcRow = src + std::min<int>(std::max<int>(y - PADDING, 0), height - 1) * width;
+        for(int x = 0; x < paddedWidth; ++x)
+            *dest++ = srcRow[std::min<int>(std::max<int>(x - PADDING, 0), width - 1)];
+    }
+
+    page->updatePixels(Rect(rect.topLeft() - Point(PADDING, PADDING), paddedWidth, paddedHeight), &pixels[0]);
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2010-2017 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TEXTUREATLAS_H
+#define TEXTUREATLAS_H
+
+#include "texture.h"
+
+/**
+ * A rect of an atlas page seen as a standalone texture, its transform matrix
+ * maps the image pixel coords into the page so every painter call keeps working
+ */
+class AtlasTexture : public Texture
+{
+public:
+    AtlasTexture(const TexturePtr& page, const Rect& rect);
+    virtual ~AtlasTexture();
+
+    void reload(const ImagePtr& image);
+
+    virtual bool buildHardwareMipmaps() { return false; }
+
+    // filtering and wrapping belong to the whole page
+    virtual void setSmooth(bool smooth) { }
+    virtual void setRepeat(bool repeat) { }
+
+    const TexturePtr& getPage() { return m_page; }
+    Point getOffset() { return m_rect.topLeft(); }
+    virtual bool isAtlasTexture() { return true; }
+
+private:
+    TexturePtr m_page;
+    Rect m_rect;
+};
+
+/**
+ * Packs small images into shared texture pages, so widgets using different
+ * images can still be drawn without switching textures
+ */
+class TextureAtlas
+{
+    enum {
+        MAX_PAGE_SIZE = 2048,
+        // each image is surrounded by a copy of its edges, filtering never reaches the neighbours
+        PADDING = 1
+    };
+
+    struct Shelf {
+        int y;
+        int height;
+        int width;
+    };
+
+    struct Page {
+        TexturePtr texture;
+        std::vector<Shelf> shelves;
+        int height;
+    };
+
+public:
+    TextureAtlas();
+
+    /// Returns the image packed into a page, or nullptr when it doesn't fit in an empty page
+    AtlasTexturePtr add(const ImagePtr& image);
+    void clear() { m_pages.clear(); }
+
+    int getPageSize();
+    int getPageCount() { return m_pages.size(); }
+
+    static void uploadPadded(const TexturePtr& page, const Rect& rect, const ImagePtr& image);
+
+private:
+    bool allocate(Page& page, const Size& size, Point& pos);
+
+    std::vector<Page> m_pages;
+    int m_pageSize;
+};
+
+#endif
@@ -25,16 +25,30 @@
 #include "graphics.h"
 #include "image.h"
 
+#include <framework/core/asyncdispatcher.h>
 #include <framework/core/resourcemanager.h>
 #include <framework/core/clock.h>
 #include <framework/core/eventdispatcher.h>
+#include <framework/core/tracer.h>
 #include <framework/graphics/apngloader.h>
 
 TextureManager g_textures;
 
+struct TextureManager::DecodedTexture
+{
+    DecodedTexture() : loaded(false) { }
+    ~DecodedTexture() { if(loaded) free_apng(&apng); }
+
+    apng_data apng;
+    bool loaded;
+    std::string error;
+};
+
 void TextureManager::init()
 {
     m_emptyTexture = TexturePtr(new Texture);
+    m_atlasMaxImageSize = 256;
+    m_uploadBudget = 2;
 }
 
 void TextureManager::terminate()
@@ -44,12 +58,19 @@ void TextureManager::terminate()
         m_liveReloadEvent = nullptr;
     }
     m_textures.clear();
+    m_atlasTextures.clear();
+    m_atlas.clear();
     m_animatedTextures.clear();
+    m_pendingTextures.clear();
+    m_pendingOrder.clear();
     m_emptyTexture = nullptr;
 }
 
 void TextureManager::poll()
 {
+    if(!m_pendingTextures.empty())
+        uploadPending();
+
     // update only every 16msec, this allows upto 60 fps for animated textures
     static ticks_t lastUpdate = 0;
     ticks_t now = g_clock.millis();
@@ -65,6 +86,10 @@ void TextureManager::clearCache()
 {
     m_animatedTextures.clear();
     m_textures.clear();
+    m_atlasTextures.clear();
+    m_atlas.clear();
+    m_pendingTextures.clear();
+    m_pendingOrder.clear();
 }
 
 void TextureManager::liveReload()
@@ -75,7 +100,7 @@ void TextureManager::liveReload()
         for(auto& it : m_textures) {
             const std::string& path = g_resources.guessFilePath(it.first, "png");
             const TexturePtr& tex = it.second;
-            if(tex->getTime() >= g_resources.getFileTime(path))
+            if(tex->getTime() >= g_resources.getFileTime(path) || m_pendingTextures.find(it.first) != m_pendingTextures.end())
                 continue;
 
             ImagePtr image = Image::load(path);
@@ -84,6 +109,19 @@ void TextureManager::liveReload()
             tex->uploadPixels(image, tex->hasMipmaps());
             tex->setTime(stdext::time());
         }
+        for(auto& it : m_atlasTextures) {
+            const std::string& path = g_resources.guessFilePath(it.first, "png");
+            const AtlasTexturePtr& tex = it.second;
+            if(tex->getTime() >= g_resources.getFileTime(path))
+                continue;
+
+            // images keep their atlas rect, so only reloads with the same size apply
+            ImagePtr image = Image::load(path);
+            if(!image)
+                continue;
+            tex->reload(image);
+            tex->setTime(stdext::time());
+        }
     }, 1000);
 }
 
@@ -94,6 +132,10 @@ TexturePtr TextureManager::getTexture(const std::string& fileName)
     // before must resolve filename to full path
     std::string filePath = g_resources.resolvePath(fileName);
 
+    // an async request for the same file is finished right away
+    if(m_pendingTextures.find(filePath) != m_pendingTextures.end())
+        return takePending(filePath, false);
+
     // check if the texture is already loaded
     auto it = m_textures.find(filePath);
     if(it != m_textures.end()) {
@@ -102,6 +144,7 @@ TexturePtr TextureManager::getTexture(const std::string& fileName)
 
     // texture not found, load it
     if(!texture) {
+        TraceScope scope("texture", filePath);
         try {
             std::string filePathEx = g_resources.guessFilePath(filePath, "png");
 
@@ -124,32 +167,241 @@ TexturePtr TextureManager::getTexture(const std::string& fileName)
     return texture;
 }
 
+TexturePtr TextureManager::getAtlasTexture(const std::string& fileName)
+{
+    if(m_atlasMaxImageSize <= 0)
+        return getTexture(fileName);
+
+    std::string filePath = g_resources.resolvePath(fileName);
+
+    auto it = m_atlasTextures.find(filePath);
+    if(it != m_atlasTextures.end())
+        return it->second;
+
+    if(m_pendingTextures.find(filePath) != m_pendingTextures.end())
+        return takePending(filePath, true);
+
+    // images already loaded standalone are not duplicated into the atlas
+    if(m_textures.find(filePath) != m_textures.end())
+        return getTexture(fileName);
+
+    AtlasTexturePtr texture;
+    try {
+        TraceScope scope("texture", filePath);
+        std::string filePathEx = g_resources.guessFilePath(filePath, "png");
+
+        std::stringstream fin;
+        g_resources.readFileStream(filePathEx, fin);
+
+        apng_data apng;
+        if(load_apng(fin, &apng) == 0) {
+            Size imageSize(apng.width, apng.height);
+            if(apng.num_frames == 1 && imageSize.width() <= m_atlasMaxImageSize && imageSize.height() <= m_atlasMaxImageSize)
+                texture = m_atlas.add(ImagePtr(new Image(imageSize, apng.bpp, apng.pdata)));
+            free_apng(&apng);
+        }
+    } catch(stdext::exception&) {
+        // getTexture reports the failure
+    }
+
+    // animated, large or unpackable images get their own texture
+    if(!texture)
+        return getTexture(fileName);
+
+    texture->setTime(stdext::time());
+    m_atlasTextures[filePath] = texture;
+    return texture;
+}
+
+TexturePtr TextureManager::getTextureAsync(const std::string& fileName, const LoadCallback& callback)
+{
+    std::string filePath = g_resources.resolvePath(fileName);
+
+    auto atlasIt = m_atlasTextures.find(filePath);
+    if(atlasIt != m_atlasTextures.end()) {
+        if(callback)
+            callback(atlasIt->second);
+        return atlasIt->second;
+    }
+
+    auto pendingIt = m_pendingTextures.find(filePath);
+    if(pendingIt == m_pendingTextures.end()) {
+        auto it = m_textures.find(filePath);
+        if(it != m_textures.end()) {
+            if(callback)
+                callback(it->second);
+            return it->second;
+        }
+        requestDecode(filePath);
+        pendingIt = m_pendingTextures.find(filePath);
+    }
+
+    // a warm up request becomes a regular texture once someone holds a placeholder for it
+    PendingTexture& pending = pendingIt->second;
+    if(!pending.placeholder) {
+        pending.placeholder = TexturePtr(new Texture);
+        pending.atlas = false;
+        m_textures[filePath] = pending.placeholder;
+    }
+    if(callback)
+        pending.callbacks.push_back(callback);
+    return pending.placeholder;
+}
+
+void TextureManager::warmUp(const std::vector<std::string>& fileNames)
+{
+    for(const std::string& fileName : fileNames) {
+        std::string filePath = g_resources.resolvePath(fileName);
+        if(m_textures.find(filePath) != m_textures.end() ||
+           m_atlasTextures.find(filePath) != m_atlasTextures.end() ||
+           m_pendingTextures.find(filePath) != m_pendingTextures.end())
+            continue;
+
+        requestDecode(filePath).atlas = m_atlasMaxImageSize > 0;
+    }
+}
+
+TextureManager::PendingTexture& TextureManager::requestDecode(const std::string& filePath)
+{
+    PendingTexture& pending = m_pendingTextures[filePath];
+    pending.atlas = false;
+    pending.decoded = g_asyncDispatcher.schedule([filePath]() -> DecodedTexturePtr {
+        DecodedTexturePtr decoded(new DecodedTexture);
+        try {
+            std::string filePathEx = g_resources.guessFilePath(filePath, "png");
+
+            std::stringstream fin;
+            g_resources.readFileStream(filePathEx, fin);
+            decoded->loaded = load_apng(fin, &decoded->apng) == 0;
+            if(!decoded->loaded)
+                decoded->error = "invalid png data";
+        } catch(stdext::exception& e) {
+            // reported on the main thread when the texture is taken
+            decoded->error = e.what();
+        }
+        return decoded;
+    });
+    m_pendingOrder.push_back(filePath);
+    return pending;
+}
+
+TexturePtr TextureManager::takePending(const std::string& filePath, bool allowAtlas)
+{
+    auto it = m_pendingTextures.find(filePath);
+    PendingTexture pending = it->second;
+    m_pendingTextures.erase(it);
+
+    // waits for the worker when taken synchronously
+    DecodedTexturePtr decoded = pending.decoded.get();
+
+    TexturePtr texture;
+    if(!decoded->loaded) {
+        g_logger.error(stdext::format("Unable to load texture '%s': %s", filePath, decoded->error));
+        texture = m_emptyTexture;
+    } else {
+        apng_data& apng = decoded->apng;
+        Size imageSize(apng.width, apng.height);
+        if(pending.atlas && allowAtlas && apng.num_frames == 1 &&
+           imageSize.width() <= m_atlasMaxImageSize && imageSize.height() <= m_atlasMaxImageSize) {
+            AtlasTexturePtr atlasTexture = m_atlas.add(ImagePtr(new Image(imageSize, apng.bpp, apng.pdata)));
+            if(atlasTexture) {
+                atlasTexture->setTime(stdext::time());
+                m_atlasTextures[filePath] = atlasTexture;
+                texture = atlasTexture;
+            }
+        }
+
+        if(!texture) {
+            if(pending.placeholder && apng.num_frames == 1) {
+                texture = pending.placeholder;
+                texture->uploadPixels(ImagePtr(new Image(imageSize, apng.bpp, apng.pdata)));
+            } else {
+                // an animated texture can't take the placeholder's place, so holders of the
+                // placeholder get a still first frame and the callbacks get the animation
+                if(pending.placeholder) {
+                    uchar *frameData = apng.pdata + (apng.first_frame * imageSize.area() * apng.bpp);
+                    pending.placeholder->uploadPixels(ImagePtr(new Image(imageSize, apng.bpp, frameData)));
+                    pending.placeholder->setTime(stdext::time());
+                    pending.placeholder->setSmooth(true);
+                }
+                texture = loadTexture(apng);
+            }
+        }
+    }
+
+    if(!texture)
+        texture = m_emptyTexture;
+
+    if(!texture->isAtlasTexture()) {
+        texture->setTime(stdext::time());
+        texture->setSmooth(true);
+        m_textures[filePath] = texture;
+    }
+
+    for(const LoadCallback& callback : pending.callbacks)
+        callback(texture);
+    return texture;
+}
+
+void TextureManager::uploadPending()
+{
+    // at least one texture goes up every frame so the queue always drains
+    stdext::timer timer;
+    do {
+        auto it = m_pendingOrder.begin();
+        while(it != m_pendingOrder.end()) {
+            auto pendingIt = m_pendingTextures.find(*it);
+            if(pendingIt == m_pendingTextures.end())
+                it = m_pendingOrder.erase(it); // already taken synchronously
+            else if(pendingIt->second.decoded.is_ready())
+                break;
+            else
+                ++it;
+        }
+        if(it == m_pendingOrder.end())
+            return;
+
+        std::string filePath = *it;
+        m_pendingOrder.erase(it);
+        takePending(filePath, true);
+    } while(timer.elapsed_millis() < m_uploadBudget);
+}
+
 TexturePtr TextureManager::loadTexture(std::stringstream& file)
 {
     TexturePtr texture;
 
     apng_data apng;
     if(load_apng(file, &apng) == 0) {
-        Size imageSize(apng.width, apng.height);
-        if(apng.num_frames > 1) { // animated texture
-            std::vector<ImagePtr> frames;
-            std::vector<int> framesDelay;
-            for(uint i=0;i<apng.num_frames;++i) {
-                uchar *frameData = apng.pdata + ((apng.first_frame+i) * imageSize.area() * apng.bpp);
-                int frameDelay = apng.frames_delay[i];
-
-                framesDelay.push_back(frameDelay);
-                frames.push_back(ImagePtr(new Image(imageSize, apng.bpp, frameData)));
-            }
-            AnimatedTexturePtr animatedTexture = new AnimatedTexture(imageSize, frames, framesDelay);
-            m_animatedTextures.push_back(animatedTexture);
-            texture = animatedTexture;
-        } else {
-            ImagePtr image = ImagePtr(new Image(imageSize, apng.bpp, apng.pdata));
-            texture = TexturePtr(new Texture(image));
-        }
+        texture = loadTexture(apng);
         free_apng(&apng);
     }
 
     return texture;
 }
+
+TexturePtr TextureManager::loadTexture(apng_data& apng)
+{
+    TexturePtr texture;
+
+    Size imageSize(apng.width, apng.height);
+    if(apng.num_frames > 1) { // animated texture
+        std::vector<ImagePtr> frames;
+        std::vector<int> framesDelay;
+        for(uint i=0;i<apng.num_frames;++i) {
+            uchar *frameData = apng.pdata + ((apng.first_frame+i) * imageSize.area() * apng.bpp);
+            int frameDelay = apng.frames_delay[i];
+
+            framesDelay.push_back(frameDelay);
+            frames.push_back(ImagePtr(new Image(imageSize, apng.bpp, frameData)));
+        }
+        AnimatedTexturePtr animatedTexture = new AnimatedTexture(imageSize, frames, framesDelay);
+        m_animatedTextures.push_back(animatedTexture);
+        texture = animatedTexture;
+    } else {
+        ImagePtr image = ImagePtr(new Image(imageSize, apng.bpp, apng.pdata));
+        texture = TexturePtr(new Texture(image));
+    }
+
+    return texture;
+}
@@ -24,11 +24,17 @@
 #define TEXTUREMANAGER_H
 
 #include "texture.h"
+#include "textureatlas.h"
 #include <framework/core/declarations.h>
+#include <framework/stdext/thread.h>
+
+struct apng_data;
 
 class TextureManager
 {
 public:
+    typedef std::function<void(const TexturePtr&)> LoadCallback;
+
     void init();
     void terminate();
     void poll();
@@ -38,15 +44,51 @@ public:
 
     void preload(const std::string& fileName) { getTexture(fileName); }
     TexturePtr getTexture(const std::string& fileName);
+    /// Same as getTexture, but small still images are packed into the shared ui atlas
+    TexturePtr getAtlasTexture(const std::string& fileName);
+    /// Returns at once and decodes on the async dispatcher, poll uploads the result within the upload budget.
+    /// Images not loaded yet are returned as a placeholder that receives the pixels, the callback gets the final texture.
+    /// Animated images only put their first frame in the placeholder, the animation is delivered through the callback
+    TexturePtr getTextureAsync(const std::string& fileName, const LoadCallback& callback = nullptr);
+    /// Decodes images in the background so later getTexture/getAtlasTexture calls find them ready
+    void warmUp(const std::vector<std::string>& fileNames);
     const TexturePtr& getEmptyTexture() { return m_emptyTexture; }
 
+    void setUploadBudget(int millis) { m_uploadBudget = millis; }
+    int getUploadBudget() { return m_uploadBudget; }
+    int getPendingCount() { return m_pendingTextures.size(); }
+
+    void setAtlasMaxImageSize(int size) { m_atlasMaxImageSize = size; }
+    int getAtlasMaxImageSize() { return m_atlasMaxImageSize; }
+    int getAtlasPageCount() { return m_atlas.getPageCount(); }
+
 private:
+    struct DecodedTexture;
+    typedef std::shared_ptr<DecodedTexture> DecodedTexturePtr;
+
+    struct PendingTexture {
+        boost::shared_future<DecodedTexturePtr> decoded;
+        TexturePtr placeholder;
+        bool atlas;
+        std::vector<LoadCallback> callbacks;
+    };
+
     TexturePtr loadTexture(std::stringstream& file);
+    TexturePtr loadTexture(apng_data& apng);
+    PendingTexture& requestDecode(const std::string& filePath);
+    TexturePtr takePending(const std::string& filePath, bool allowAtlas);
+    void uploadPending();
 
     std::unordered_map<std::string, TexturePtr> m_textures;
+    std::unordered_map<std::string, AtlasTexturePtr> m_atlasTextures;
+    TextureAtlas m_atlas;
+    int m_atlasMaxImageSize;
     std::vector<AnimatedTexturePtr> m_animatedTextures;
     TexturePtr m_emptyTexture;
     ScheduledEventPtr m_liveReloadEvent;
+    std::unordered_map<std::string, PendingTexture> m_pendingTextures;
+    std::list<std::string> m_pendingOrder;
+    int m_uploadBudget;
 };
 
 extern TextureManager g_textures;
@@ -73,6 +73,22 @@ public:
         addVertex(right, top);
     }
 
+    void append(const VertexArray& other) {
+        uint size = m_buffer.size();
+        m_buffer.grow(size + other.m_buffer.size());
+        memcpy(m_buffer.data() + size, other.vertices(), other.m_buffer.size() * sizeof(float));
+    }
+    void append(const VertexArray& other, float offsetX, float offsetY) {
+        uint size = m_buffer.size();
+        m_buffer.grow(size + other.m_buffer.size());
+        float *dest = m_buffer.data() + size;
+        const float *src = other.vertices();
+        for(uint i = 0; i < other.m_buffer.size(); i += 2) {
+            dest[i] = src[i] + offsetX;
+            dest[i+1] = src[i+1] + offsetY;
+        }
+    }
+
     void clear() { m_buffer.reset(); }
     float *vertices() const { return m_buffer.data(); }
     int vertexCount() const { return m_buffer.size() / 2; }
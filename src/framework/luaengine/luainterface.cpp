@@ -24,12 +24,27 @@
 #include "luaobject.h"
 
 #include <framework/core/resourcemanager.h>
+#include <framework/core/tracer.h>
 #include <lua.hpp>
 
 #include "lbitlib.h"
 
 LuaInterface g_lua;
 
+enum {
+    // lua defaults, used when the idle time collection is keeping up
+    GC_DEFAULT_PAUSE = 200,
+    GC_DEFAULT_STEPMUL = 200,
+    // bounds for the automatic tuning
+    GC_MIN_PAUSE = 110,
+    GC_MAX_PAUSE = 400,
+    GC_MAX_STEPMUL = 800,
+    // amount of kbytes collected by each incremental step
+    GC_STEP_KBYTES = 16,
+    // heap growth in percent after a finished cycle before idle steps start a new one
+    GC_IDLE_GROWTH = 25
+};
+
 LuaInterface::LuaInterface()
 {
     L = nullptr;
@@ -37,6 +52,10 @@ LuaInterface::LuaInterface()
     m_weakTableRef = 0;
     m_totalObjRefs = 0;
     m_totalFuncRefs = 0;
+    m_gcPause = GC_DEFAULT_PAUSE;
+    m_gcStepMul = GC_DEFAULT_STEPMUL;
+    m_gcCycleMemory = 0;
+    m_gcWaitMemory = 0;
 }
 
 LuaInterface::~LuaInterface()
@@ -330,7 +349,13 @@ void LuaInterface::loadScript(const std::string& fileName)
 
     filePath = g_resources.guessFilePath(filePath, "lua");
 
-    std::string buffer = g_resources.readFileContents(filePath);
+    std::string buffer;
+    {
+        TraceScope scope("io", filePath);
+        buffer = g_resources.readFileContents(filePath);
+    }
+
+    TraceScope scope("lua-compile", filePath);
     std::string source = "@" + filePath;
     loadBuffer(buffer, source);
 }
@@ -727,6 +752,52 @@ void LuaInterface::collectGarbage()
     }
 }
 
+int LuaInterface::stepGarbage(int budgetMicros)
+{
+    if(!L || budgetMicros <= 0)
+        return 0;
+
+    // after a finished cycle there is nothing worth collecting until the heap grows again
+    if(m_gcWaitMemory > 0) {
+        if(getUsedMemory() < m_gcWaitMemory)
+            return 0;
+        m_gcWaitMemory = 0;
+    }
+
+    stdext::timer timer;
+    bool finished = false;
+    do {
+        if(lua_gc(L, LUA_GCSTEP, GC_STEP_KBYTES) == 1) {
+            finished = true;
+            break;
+        }
+    } while(timer.elapsed_micros() < budgetMicros);
+
+    int usedMemory = getUsedMemory();
+    if(finished) {
+        // idle steps are keeping up, let allocations trigger the collector less often
+        m_gcCycleMemory = usedMemory;
+        m_gcWaitMemory = usedMemory + usedMemory * GC_IDLE_GROWTH / 100 + 1;
+        m_gcPause = std::min<int>(m_gcPause + 10, GC_MAX_PAUSE);
+        m_gcStepMul = std::max<int>(m_gcStepMul - 20, GC_DEFAULT_STEPMUL);
+    } else if(m_gcCycleMemory > 0 && usedMemory > m_gcCycleMemory * 2) {
+        // heap is growing faster than idle steps can collect, fall back to the allocation driven collector
+        m_gcPause = std::max<int>(m_gcPause - 20, GC_MIN_PAUSE);
+        m_gcStepMul = std::min<int>(m_gcStepMul + 50, GC_MAX_STEPMUL);
+    }
+    lua_gc(L, LUA_GCSETPAUSE, m_gcPause);
+    lua_gc(L, LUA_GCSETSTEPMUL, m_gcStepMul);
+
+    return timer.elapsed_micros();
+}
+
+int LuaInterface::getUsedMemory()
+{
+    if(!L)
+        return 0;
+    return lua_gc(L, LUA_GCCOUNT, 0);
+}
+
 void LuaInterface::loadBuffer(const std::string& buffer, const std::string& source)
 {
     // loads lua buffer
@@ -221,6 +221,13 @@ public:
 
     void collectGarbage();
 
+    /// Performs incremental garbage collection steps until the time budget is spent
+    /// or a collection cycle finishes, also tunes the collector pause and step multiplier
+    /// @return the time spent collecting in microseconds
+    int stepGarbage(int budgetMicros);
+    /// Memory currently used by the lua state in kilobytes
+    int getUsedMemory();
+
     void loadBuffer(const std::string& buffer, const std::string& source);
 
     int pcall(int numArgs = 0, int numRets = 0, int errorFuncIndex = 0);
@@ -345,6 +352,10 @@ private:
     int m_totalObjRefs;
     int m_totalFuncRefs;
     int m_globalEnv;
+    int m_gcPause;
+    int m_gcStepMul;
+    int m_gcCycleMemory;
+    int m_gcWaitMemory;
 };
 
 extern LuaInterface g_lua;
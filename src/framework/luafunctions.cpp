@@ -30,6 +30,7 @@
 #include <framework/core/module.h>
 #include <framework/util/crypt.h>
 #include <framework/core/resourcemanager.h>
+#include <framework/core/tracer.h>
 #include <framework/graphics/texturemanager.h>
 #include <framework/stdext/net.h>
 #include <framework/platform/platform.h>
@@ -190,6 +191,13 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_resources", "listDirectoryFiles", &ResourceManager::listDirectoryFiles, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "getDirectoryFiles", &ResourceManager::getDirectoryFiles, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "readFileContents", &ResourceManager::readFileContents, &g_resources);
+    g_lua.bindSingletonFunction("g_resources", "prefetchFiles", &ResourceManager::prefetchFiles, &g_resources);
+    g_lua.bindSingletonFunction("g_resources", "clearCache", &ResourceManager::clearCache, &g_resources);
+    g_lua.bindSingletonFunction("g_resources", "setCacheLimit", &ResourceManager::setCacheLimit, &g_resources);
+    g_lua.bindSingletonFunction("g_resources", "getCacheLimit", &ResourceManager::getCacheLimit, &g_resources);
+    g_lua.bindSingletonFunction("g_resources", "getCachedBytes", &ResourceManager::getCachedBytes, &g_resources);
+    g_lua.bindSingletonFunction("g_resources", "getCacheHits", &ResourceManager::getCacheHits, &g_resources);
+    g_lua.bindSingletonFunction("g_resources", "getCacheMisses", &ResourceManager::getCacheMisses, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "writeFileContents", &ResourceManager::writeFileContents, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "guessFilePath", &ResourceManager::guessFilePath, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "isFileType", &ResourceManager::isFileType, &g_resources);
@@ -198,6 +206,24 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_resources", "deleteFile", &ResourceManager::deleteFile, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "resolvePath", &ResourceManager::resolvePath, &g_resources);
 
+    // OTMLCache
+    g_lua.registerSingletonClass("g_otmlcache");
+    g_lua.bindSingletonFunction("g_otmlcache", "clear", &OTMLCache::clear, &g_otmlcache);
+    g_lua.bindSingletonFunction("g_otmlcache", "setEnabled", &OTMLCache::setEnabled, &g_otmlcache);
+    g_lua.bindSingletonFunction("g_otmlcache", "isEnabled", &OTMLCache::isEnabled, &g_otmlcache);
+    g_lua.bindSingletonFunction("g_otmlcache", "getHits", &OTMLCache::getHits, &g_otmlcache);
+    g_lua.bindSingletonFunction("g_otmlcache", "getMisses", &OTMLCache::getMisses, &g_otmlcache);
+    g_lua.bindSingletonFunction("g_otmlcache", "getLoadMillis", &OTMLCache::getLoadMillis, &g_otmlcache);
+    g_lua.bindSingletonFunction("g_otmlcache", "resetStats", &OTMLCache::resetStats, &g_otmlcache);
+
+    // Tracer
+    g_lua.registerSingletonClass("g_tracer");
+    g_lua.bindSingletonFunction("g_tracer", "setEnabled", &Tracer::setEnabled, &g_tracer);
+    g_lua.bindSingletonFunction("g_tracer", "isEnabled", &Tracer::isEnabled, &g_tracer);
+    g_lua.bindSingletonFunction("g_tracer", "clear", &Tracer::clear, &g_tracer);
+    g_lua.bindSingletonFunction("g_tracer", "dump", &Tracer::dump, &g_tracer);
+    g_lua.bindSingletonFunction("g_tracer", "logSummary", &Tracer::logSummary, &g_tracer);
+
     // Config
     g_lua.registerClass<Config>();
     g_lua.bindClassMemberFunction<Config>("save", &Config::save);
@@ -256,6 +282,11 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_app", "getBackgroundPaneFps", &GraphicalApplication::getBackgroundPaneFps, &g_app);
     g_lua.bindSingletonFunction("g_app", "getForegroundPaneMaxFps", &GraphicalApplication::getForegroundPaneMaxFps, &g_app);
     g_lua.bindSingletonFunction("g_app", "getBackgroundPaneMaxFps", &GraphicalApplication::getBackgroundPaneMaxFps, &g_app);
+    g_lua.bindSingletonFunction("g_app", "getGarbageCollectMicros", &GraphicalApplication::getGarbageCollectMicros, &g_app);
+    g_lua.bindSingletonFunction("g_app", "getForegroundFrameMicros", &GraphicalApplication::getForegroundFrameMicros, &g_app);
+    g_lua.bindSingletonFunction("g_app", "getDrawCallsPerFrame", &GraphicalApplication::getDrawCallsPerFrame, &g_app);
+    g_lua.bindSingletonFunction("g_app", "getTexturesPerFrame", &GraphicalApplication::getTexturesPerFrame, &g_app);
+    g_lua.bindSingletonFunction("g_app", "getLuaUsedMemory", &GraphicalApplication::getLuaUsedMemory, &g_app);
 
     // PlatformWindow
     g_lua.registerSingletonClass("g_window");
@@ -325,6 +356,13 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_textures", "preload", &TextureManager::preload, &g_textures);
     g_lua.bindSingletonFunction("g_textures", "clearCache", &TextureManager::clearCache, &g_textures);
     g_lua.bindSingletonFunction("g_textures", "liveReload", &TextureManager::liveReload, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "setAtlasMaxImageSize", &TextureManager::setAtlasMaxImageSize, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "getAtlasMaxImageSize", &TextureManager::getAtlasMaxImageSize, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "getAtlasPageCount", &TextureManager::getAtlasPageCount, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "warmUp", &TextureManager::warmUp, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "setUploadBudget", &TextureManager::setUploadBudget, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "getUploadBudget", &TextureManager::getUploadBudget, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "getPendingCount", &TextureManager::getPendingCount, &g_textures);
 
     // UI
     g_lua.registerSingletonClass("g_ui");
@@ -341,6 +379,10 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_ui", "getPressedWidget", &UIManager::getPressedWidget, &g_ui);
     g_lua.bindSingletonFunction("g_ui", "setDebugBoxesDrawing", &UIManager::setDebugBoxesDrawing, &g_ui);
     g_lua.bindSingletonFunction("g_ui", "isDrawingDebugBoxes", &UIManager::isDrawingDebugBoxes, &g_ui);
+    g_lua.bindSingletonFunction("g_ui", "getLayerRedraws", &UIManager::getLayerRedraws, &g_ui);
+    g_lua.bindSingletonFunction("g_ui", "getLayerBlits", &UIManager::getLayerBlits, &g_ui);
+    g_lua.bindSingletonFunction("g_ui", "getMouseMoveMicros", &UIManager::getMouseMoveMicros, &g_ui);
+    g_lua.bindSingletonFunction("g_ui", "getLayoutSolves", &UIManager::getLayoutSolves, &g_ui);
     g_lua.bindSingletonFunction("g_ui", "isMouseGrabbed", &UIManager::isMouseGrabbed, &g_ui);
     g_lua.bindSingletonFunction("g_ui", "isKeyboardGrabbed", &UIManager::isKeyboardGrabbed, &g_ui);
 
@@ -391,6 +433,7 @@ void Application::registerLuaFunctions()
     g_lua.bindClassMemberFunction<UIWidget>("bindRectToParent", &UIWidget::bindRectToParent);
     g_lua.bindClassMemberFunction<UIWidget>("destroy", &UIWidget::destroy);
     g_lua.bindClassMemberFunction<UIWidget>("destroyChildren", &UIWidget::destroyChildren);
+    g_lua.bindClassMemberFunction<UIWidget>("repaint", &UIWidget::repaint);
     g_lua.bindClassMemberFunction<UIWidget>("setId", &UIWidget::setId);
     g_lua.bindClassMemberFunction<UIWidget>("setParent", &UIWidget::setParent);
     g_lua.bindClassMemberFunction<UIWidget>("setLayout", &UIWidget::setLayout);
@@ -406,6 +449,7 @@ void Application::registerLuaFunctions()
     g_lua.bindClassMemberFunction<UIWidget>("setDraggable", &UIWidget::setDraggable);
     g_lua.bindClassMemberFunction<UIWidget>("setFixedSize", &UIWidget::setFixedSize);
     g_lua.bindClassMemberFunction<UIWidget>("setClipping", &UIWidget::setClipping);
+    g_lua.bindClassMemberFunction<UIWidget>("setRenderLayer", &UIWidget::setRenderLayer);
     g_lua.bindClassMemberFunction<UIWidget>("setLastFocusReason", &UIWidget::setLastFocusReason);
     g_lua.bindClassMemberFunction<UIWidget>("setAutoFocusPolicy", &UIWidget::setAutoFocusPolicy);
     g_lua.bindClassMemberFunction<UIWidget>("setAutoRepeatDelay", &UIWidget::setAutoRepeatDelay);
@@ -458,6 +502,7 @@ void Application::registerLuaFunctions()
     g_lua.bindClassMemberFunction<UIWidget>("isDraggable", &UIWidget::isDraggable);
     g_lua.bindClassMemberFunction<UIWidget>("isFixedSize", &UIWidget::isFixedSize);
     g_lua.bindClassMemberFunction<UIWidget>("isClipping", &UIWidget::isClipping);
+    g_lua.bindClassMemberFunction<UIWidget>("isRenderLayer", &UIWidget::isRenderLayer);
     g_lua.bindClassMemberFunction<UIWidget>("isDestroyed", &UIWidget::isDestroyed);
     g_lua.bindClassMemberFunction<UIWidget>("hasChildren", &UIWidget::hasChildren);
     g_lua.bindClassMemberFunction<UIWidget>("containsMarginPoint", &UIWidget::containsMarginPoint);
@@ -478,6 +523,7 @@ void Application::registerLuaFunctions()
     g_lua.bindClassMemberFunction<UIWidget>("getVirtualOffset", &UIWidget::getVirtualOffset);
     g_lua.bindClassMemberFunction<UIWidget>("getStyleName", &UIWidget::getStyleName);
     g_lua.bindClassMemberFunction<UIWidget>("getLastClickPosition", &UIWidget::getLastClickPosition);
+    g_lua.bindClassMemberFunction<UIWidget>("getLayerRedraws", &UIWidget::getLayerRedraws);
     g_lua.bindClassMemberFunction<UIWidget>("setX", &UIWidget::setX);
     g_lua.bindClassMemberFunction<UIWidget>("setY", &UIWidget::setY);
     g_lua.bindClassMemberFunction<UIWidget>("setWidth", &UIWidget::setWidth);
@@ -575,6 +621,7 @@ void Application::registerLuaFunctions()
     g_lua.bindClassMemberFunction<UIWidget>("getOpacity", &UIWidget::getOpacity);
     g_lua.bindClassMemberFunction<UIWidget>("getRotation", &UIWidget::getRotation);
     g_lua.bindClassMemberFunction<UIWidget>("setImageSource", &UIWidget::setImageSource);
+    g_lua.bindClassMemberFunction<UIWidget>("setImageSourceAsync", &UIWidget::setImageSourceAsync);
     g_lua.bindClassMemberFunction<UIWidget>("setImageClip", &UIWidget::setImageClip);
     g_lua.bindClassMemberFunction<UIWidget>("setImageOffsetX", &UIWidget::setImageOffsetX);
     g_lua.bindClassMemberFunction<UIWidget>("setImageOffsetY", &UIWidget::setImageOffsetY);
@@ -737,6 +784,33 @@ void Application::registerLuaFunctions()
     g_lua.bindClassMemberFunction<UITextEdit>("isShiftNavigation", &UITextEdit::isShiftNavigation);
     g_lua.bindClassMemberFunction<UITextEdit>("isMultiline", &UITextEdit::isMultiline);
 
+    // UIVirtualList
+    g_lua.registerClass<UIVirtualList, UIWidget>();
+    g_lua.bindClassStaticFunction<UIVirtualList>("create", []{ return UIVirtualListPtr(new UIVirtualList); } );
+    g_lua.bindClassMemberFunction<UIVirtualList>("setItemCount", &UIVirtualList::setItemCount);
+    g_lua.bindClassMemberFunction<UIVirtualList>("setRowStyle", &UIVirtualList::setRowStyle);
+    g_lua.bindClassMemberFunction<UIVirtualList>("setRowHeight", &UIVirtualList::setRowHeight);
+    g_lua.bindClassMemberFunction<UIVirtualList>("setColumns", &UIVirtualList::setColumns);
+    g_lua.bindClassMemberFunction<UIVirtualList>("setScrollOffset", &UIVirtualList::setScrollOffset);
+    g_lua.bindClassMemberFunction<UIVirtualList>("setScrollStep", &UIVirtualList::setScrollStep);
+    g_lua.bindClassMemberFunction<UIVirtualList>("setAlwaysScrollMaximum", &UIVirtualList::setAlwaysScrollMaximum);
+    g_lua.bindClassMemberFunction<UIVirtualList>("ensureIndexVisible", &UIVirtualList::ensureIndexVisible);
+    g_lua.bindClassMemberFunction<UIVirtualList>("refresh", &UIVirtualList::refresh);
+    g_lua.bindClassMemberFunction<UIVirtualList>("refreshIndex", &UIVirtualList::refreshIndex);
+    g_lua.bindClassMemberFunction<UIVirtualList>("getRowWidget", &UIVirtualList::getRowWidget);
+    g_lua.bindClassMemberFunction<UIVirtualList>("getRowIndex", &UIVirtualList::getRowIndex);
+    g_lua.bindClassMemberFunction<UIVirtualList>("getFirstVisibleIndex", &UIVirtualList::getFirstVisibleIndex);
+    g_lua.bindClassMemberFunction<UIVirtualList>("getLastVisibleIndex", &UIVirtualList::getLastVisibleIndex);
+    g_lua.bindClassMemberFunction<UIVirtualList>("getMaxScrollOffset", &UIVirtualList::getMaxScrollOffset);
+    g_lua.bindClassMemberFunction<UIVirtualList>("getItemCount", &UIVirtualList::getItemCount);
+    g_lua.bindClassMemberFunction<UIVirtualList>("getRowStyle", &UIVirtualList::getRowStyle);
+    g_lua.bindClassMemberFunction<UIVirtualList>("getRowHeight", &UIVirtualList::getRowHeight);
+    g_lua.bindClassMemberFunction<UIVirtualList>("getColumns", &UIVirtualList::getColumns);
+    g_lua.bindClassMemberFunction<UIVirtualList>("getScrollOffset", &UIVirtualList::getScrollOffset);
+    g_lua.bindClassMemberFunction<UIVirtualList>("getScrollStep", &UIVirtualList::getScrollStep);
+    g_lua.bindClassMemberFunction<UIVirtualList>("getPoolSize", &UIVirtualList::getPoolSize);
+    g_lua.bindClassMemberFunction<UIVirtualList>("isAlwaysScrollMaximum", &UIVirtualList::isAlwaysScrollMaximum);
+
     g_lua.registerClass<ShaderProgram>();
     g_lua.registerClass<PainterShaderProgram>();
     g_lua.bindClassMemberFunction<PainterShaderProgram>("addMultiTexture", &PainterShaderProgram::addMultiTexture);
@@ -25,5 +25,6 @@
 
 #include "otmldocument.h"
 #include "otmlnode.h"
+#include "otmlcache.h"
 
 #endif
\ No newline at end of file
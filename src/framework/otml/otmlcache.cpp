@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2010-2017 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "otmlcache.h"
+#include "otmldocument.h"
+
+#include <framework/core/resourcemanager.h>
+#include <framework/core/filestream.h>
+#include <framework/core/asyncdispatcher.h>
+#include <framework/core/tracer.h>
+
+OTMLCache g_otmlcache;
+
+enum {
+    NODE_UNIQUE = 1,
+    NODE_NULL = 2,
+    NODE_LINE_SOURCE = 4
+};
+
+OTMLCache::OTMLCache() :
+    m_enabled(true),
+    m_hits(0),
+    m_misses(0),
+    m_loadMicros(0)
+{
+}
+
+OTMLDocumentPtr OTMLCache::load(const std::string& source, const std::string& text)
+{
+    if(!m_enabled)
+        return nullptr;
+
+    std::string cacheFile = getCacheFile(source);
+    if(g_resources.fileExists(cacheFile)) {
+        try {
+            FileStreamPtr fin = g_resources.openFile(cacheFile);
+            fin->cache();
+            return read(source, text, fin);
+        } catch(stdext::exception&) {
+            // unreadable cache files are just overwritten
+        }
+    }
+
+    m_misses++;
+    return nullptr;
+}
+
+OTMLDocumentPtr OTMLCache::read(const std::string& source, const std::string& text, const FileStreamPtr& fin)
+{
+    // files may change within the same second keeping their size (config.otml is rewritten at runtime),
+    // so entries are matched by content
+    uint64 hash = stdext::fnv1a64((const uint8*)text.data(), text.size());
+
+    try {
+        if(fin->getU32() != CACHE_SIGNATURE || fin->getU16() != CACHE_VERSION ||
+           fin->getString() != source || fin->getU64() != hash || fin->getU32() != text.size()) {
+            m_misses++;
+            return nullptr;
+        }
+
+        // interned tags and values
+        std::vector<std::string> strings(fin->getU32());
+        for(std::string& str : strings) {
+            str.resize(fin->getU32());
+            if(!str.empty() && fin->read(&str[0], str.size()) != 1)
+                stdext::throw_exception("unexpected end of cache file");
+        }
+
+        OTMLDocumentPtr doc = OTMLDocument::create();
+        doc->setSource(source);
+        readNode(fin, doc, source, strings);
+        m_hits++;
+        return doc;
+    } catch(stdext::exception&) {
+        // corrupted or truncated cache files are just overwritten
+    }
+
+    m_misses++;
+    return nullptr;
+}
+
+void OTMLCache::store(const std::string& source, const std::string& text, const OTMLDocumentPtr& doc)
+{
+    if(!m_enabled || g_resources.getWriteDir().empty())
+        return;
+
+    std::unordered_map<std::string, uint32> stringIndex;
+    std::vector<std::string> strings;
+    collectStrings(doc, stringIndex, strings);
+
+    try {
+        g_resources.makeDir("otmlcache");
+        FileStreamPtr fout = g_resources.createFile(getCacheFile(source));
+        fout->cache();
+
+        fout->addU32(CACHE_SIGNATURE);
+        fout->addU16(CACHE_VERSION);
+        fout->addString(source);
+        fout->addU64(stdext::fnv1a64((const uint8*)text.data(), text.size()));
+        fout->addU32(text.size());
+
+        fout->addU32(strings.size());
+        for(const std::string& str : strings) {
+            fout->addU32(str.size());
+            fout->write(str.c_str(), str.size());
+        }
+
+        writeNode(fout, doc, source, stringIndex);
+
+        fout->flush();
+        fout->close();
+    } catch(stdext::exception&) {
+        // the cache is only an optimization, failing to write it is not an error
+    }
+}
+
+void OTMLCache::clear()
+{
+    for(const std::string& file : g_resources.listDirectoryFiles("/otmlcache"))
+        g_resources.deleteFile("/otmlcache/" + file);
+}
+
+void OTMLCache::preload(const std::string& source)
+{
+    std::lock_guard<std::mutex> lock(m_preloadMutex);
+    if(m_preloaded.find(source) != m_preloaded.end())
+        return;
+
+    // workers only read files, documents are refcounted objects and are built on the main thread
+    std::string cacheFile = m_enabled ? getCacheFile(source) : std::string();
+    m_preloaded[source] = g_asyncDispatcher.schedule([source, cacheFile]() -> PreloadedFile {
+        PreloadedFile file;
+        file.loaded = false;
+        try {
+            if(!cacheFile.empty() && g_resources.fileExists(cacheFile))
+                file.cache = g_resources.readFileContents(cacheFile);
+        } catch(stdext::exception&) {
+            // the text is parsed instead
+        }
+        try {
+            file.text = g_resources.readFileContents(source);
+            file.loaded = true;
+        } catch(stdext::exception&) {
+            // errors are reported when the file is read again on the main thread
+        }
+        return file;
+    });
+}
+
+OTMLDocumentPtr OTMLCache::takePreloaded(const std::string& source)
+{
+    boost::shared_future<PreloadedFile> future;
+    {
+        std::lock_guard<std::mutex> lock(m_preloadMutex);
+        auto it = m_preloaded.find(source);
+        if(it == m_preloaded.end())
+            return nullptr;
+        future = it->second;
+        m_preloaded.erase(it);
+    }
+
+    const PreloadedFile& file = future.get();
+    if(!file.loaded)
+        return nullptr;
+
+    TraceScope scope("otml", source);
+    stdext::timer loadTimer;
+
+    OTMLDocumentPtr doc;
+    try {
+        if(m_enabled) {
+            if(!file.cache.empty())
+                doc = read(source, file.text, FileStreamPtr(new FileStream(getCacheFile(source), file.cache)));
+            else
+                m_misses++;
+        }
+
+        if(!doc) {
+            std::stringstream fin(file.text);
+            doc = OTMLDocument::parse(fin, source);
+            store(source, file.text, doc);
+        }
+    } catch(stdext::exception&) {
+        // parsed again by the caller, which reports the error
+        return nullptr;
+    }
+
+    addLoadMicros(loadTimer.elapsed_micros());
+    return doc;
+}
+
+void OTMLCache::clearPreloaded()
+{
+    std::lock_guard<std::mutex> lock(m_preloadMutex);
+    m_preloaded.clear();
+}
+
+std::string OTMLCache::getCacheFile(const std::string& source)
+{
+    // FNV-1a, collisions are detected by the source path stored in the header
+    uint32 hash = 2166136261u;
+    for(char c : source) {
+        hash ^= (uint8)c;
+        hash *= 16777619u;
+    }
+    return stdext::format("/otmlcache/%08x.otmc", hash);
+}
+
+void OTMLCache::collectStrings(const OTMLNodePtr& node, std::unordered_map<std::string, uint32>& stringIndex, std::vector<std::string>& strings)
+{
+    const std::string values[] = { node->tag(), node->rawValue() };
+    for(const std::string& value : values) {
+        if(stringIndex.find(value) == stringIndex.end()) {
+            stringIndex[value] = strings.size();
+            strings.push_back(value);
+        }
+    }
+
+    for(int i=0;i<node->size();++i)
+        collectStrings(node->atIndex(i), stringIndex, strings);
+}
+
+void OTMLCache::writeNode(const FileStreamPtr& fout, const OTMLNodePtr& node, const std::string& source, std::unordered_map<std::string, uint32>& stringIndex)
+{
+    uint8 flags = 0;
+    if(node->isUnique())
+        flags |= NODE_UNIQUE;
+    if(node->isNull())
+        flags |= NODE_NULL;
+
+    // nodes created by the parser have their source as "file:line"
+    int line = 0;
+    std::string nodeSource = node->source();
+    if(nodeSource.size() > source.size() + 1 && stdext::starts_with(nodeSource, source + ":") &&
+       stdext::cast(nodeSource.substr(source.size() + 1), line))
+        flags |= NODE_LINE_SOURCE;
+
+    fout->addU32(stringIndex[node->tag()]);
+    fout->addU32(stringIndex[node->rawValue()]);
+    fout->addU8(flags);
+    if(flags & NODE_LINE_SOURCE)
+        fout->addU32(line);
+
+    fout->addU32(node->size());
+    for(int i=0;i<node->size();++i)
+        writeNode(fout, node->atIndex(i), source, stringIndex);
+}
+
+void OTMLCache::readNode(const FileStreamPtr& fin, const OTMLNodePtr& node, const std::string& source, const std::vector<std::string>& strings)
+{
+    uint32 tag = fin->getU32();
+    uint32 value = fin->getU32();
+    uint8 flags = fin->getU8();
+    if(tag >= strings.size() || value >= strings.size())
+        stdext::throw_exception("invalid string index");
+
+    node->setTag(strings[tag]);
+    node->setValue(strings[value]);
+    node->setUnique(flags & NODE_UNIQUE);
+    node->setNull(flags & NODE_NULL);
+    if(flags & NODE_LINE_SOURCE)
+        node->setSource(source + ":" + stdext::to_string(fin->getU32()));
+
+    uint32 children = fin->getU32();
+    for(uint32 i=0;i<children;++i) {
+        OTMLNodePtr child = OTMLNode::create();
+        readNode(fin, child, source, strings);
+        node->addChild(child);
+    }
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2010-2017 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef OTMLCACHE_H
+#define OTMLCACHE_H
+
+#include "declarations.h"
+#include <framework/core/declarations.h>
+#include <framework/stdext/thread.h>
+#include <atomic>
+
+/// Stores parsed OTML documents in a compact binary form inside the write directory,
+/// entries are keyed by the resolved file path and invalidated by a hash of its contents
+// @bindsingleton g_otmlcache
+class OTMLCache
+{
+    enum {
+        CACHE_SIGNATURE = 0x434D544F, // "OTMC"
+        CACHE_VERSION = 2
+    };
+
+public:
+    OTMLCache();
+
+    // @dontbind
+    OTMLDocumentPtr load(const std::string& source, const std::string& text);
+    // @dontbind
+    void store(const std::string& source, const std::string& text, const OTMLDocumentPtr& doc);
+
+    void clear();
+
+    /// Reads a document and its cache file on a worker thread, the next OTMLDocument::parse of the same file builds from them
+    // @dontbind
+    void preload(const std::string& source);
+    // @dontbind
+    OTMLDocumentPtr takePreloaded(const std::string& source);
+    void clearPreloaded();
+
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    bool isEnabled() { return m_enabled; }
+
+    int getHits() { return m_hits; }
+    int getMisses() { return m_misses; }
+    /// Total time spent building documents, either from cache or text parsing
+    int getLoadMillis() { return m_loadMicros / 1000; }
+    // @dontbind
+    void addLoadMicros(ticks_t micros) { m_loadMicros += micros; }
+    void resetStats() { m_hits = 0; m_misses = 0; m_loadMicros = 0; }
+
+private:
+    struct PreloadedFile {
+        std::string cache;
+        std::string text;
+        bool loaded;
+    };
+
+    OTMLDocumentPtr read(const std::string& source, const std::string& text, const FileStreamPtr& fin);
+    std::string getCacheFile(const std::string& source);
+
+    void collectStrings(const OTMLNodePtr& node, std::unordered_map<std::string, uint32>& stringIndex, std::vector<std::string>& strings);
+    void writeNode(const FileStreamPtr& fout, const OTMLNodePtr& node, const std::string& source, std::unordered_map<std::string, uint32>& stringIndex);
+    void readNode(const FileStreamPtr& fin, const OTMLNodePtr& node, const std::string& source, const std::vector<std::string>& strings);
+
+    std::atomic<bool> m_enabled;
+    std::atomic<int> m_hits;
+    std::atomic<int> m_misses;
+    std::atomic<ticks_t> m_loadMicros;
+    std::mutex m_preloadMutex;
+    std::unordered_map<std::string, boost::shared_future<PreloadedFile>> m_preloaded;
+};
+
+extern OTMLCache g_otmlcache;
+
+#endif
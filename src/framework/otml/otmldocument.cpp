@@ -23,8 +23,10 @@
 #include "otmldocument.h"
 #include "otmlparser.h"
 #include "otmlemitter.h"
+#include "otmlcache.h"
 
 #include <framework/core/resourcemanager.h>
+#include <framework/core/tracer.h>
 
 OTMLDocumentPtr OTMLDocument::create()
 {
@@ -35,10 +37,32 @@ OTMLDocumentPtr OTMLDocument::create()
 
 OTMLDocumentPtr OTMLDocument::parse(const std::string& fileName)
 {
-    std::stringstream fin;
     std::string source = g_resources.resolvePath(fileName);
-    g_resources.readFileStream(source, fin);
-    return parse(fin, source);
+    if(OTMLDocumentPtr doc = g_otmlcache.takePreloaded(source))
+        return doc;
+    return parseFile(source);
+}
+
+OTMLDocumentPtr OTMLDocument::parseFile(const std::string& source)
+{
+    TraceScope scope("otml", source);
+    stdext::timer loadTimer;
+
+    std::string text;
+    {
+        TraceScope ioScope("io", source);
+        text = g_resources.readFileContents(source);
+    }
+
+    OTMLDocumentPtr doc = g_otmlcache.load(source, text);
+    if(!doc) {
+        std::stringstream fin(text);
+        doc = parse(fin, source);
+        g_otmlcache.store(source, text, doc);
+    }
+
+    g_otmlcache.addLoadMicros(loadTimer.elapsed_micros());
+    return doc;
 }
 
 OTMLDocumentPtr OTMLDocument::parse(std::istream& in, const std::string& source)
@@ -24,6 +24,90 @@
 #include "otmlemitter.h"
 #include "otmldocument.h"
 
+#include <unordered_set>
+
+namespace {
+
+// tags and pool are intentionally leaked, nodes may be released by other globals destructors,
+// both are unlocked because nodes are only created and released on the main thread
+struct TagTable {
+    std::unordered_set<std::string> tags;
+};
+
+// free list of fixed size blocks, carved from chunks that are never released
+struct NodePool {
+    std::vector<void*> freeBlocks;
+};
+
+TagTable& tagTable()
+{
+    static TagTable *table = new TagTable;
+    return *table;
+}
+
+NodePool& nodePool()
+{
+    static NodePool *pool = new NodePool;
+    return *pool;
+}
+
+const std::size_t POOL_BLOCK_SIZE = (sizeof(OTMLDocument) + 15) & ~(std::size_t)15;
+const std::size_t POOL_CHUNK_BLOCKS = 512;
+
+}
+
+void* OTMLNode::operator new(std::size_t size)
+{
+    if(size > POOL_BLOCK_SIZE)
+        return ::operator new(size);
+
+    NodePool& pool = nodePool();
+    if(pool.freeBlocks.empty()) {
+        char *chunk = new char[POOL_BLOCK_SIZE * POOL_CHUNK_BLOCKS];
+        for(std::size_t i = POOL_CHUNK_BLOCKS; i > 0; --i)
+            pool.freeBlocks.push_back(chunk + (i - 1) * POOL_BLOCK_SIZE);
+    }
+    void *p = pool.freeBlocks.back();
+    pool.freeBlocks.pop_back();
+    return p;
+}
+
+void OTMLNode::operator delete(void* p, std::size_t size)
+{
+    if(!p)
+        return;
+
+    if(size > POOL_BLOCK_SIZE) {
+        ::operator delete(p);
+        return;
+    }
+
+    NodePool& pool = nodePool();
+    pool.freeBlocks.push_back(p);
+}
+
+const std::string* OTMLNode::internTag(const std::string& tag)
+{
+    TagTable& table = tagTable();
+    // pointers to unordered_set elements stay valid across rehashes
+    return &(*table.tags.insert(tag).first);
+}
+
+const std::string* OTMLNode::emptyTag()
+{
+    static const std::string *tag = internTag(std::string());
+    return tag;
+}
+
+const std::string* OTMLNode::findTag(const std::string& tag)
+{
+    TagTable& table = tagTable();
+    auto it = table.tags.find(tag);
+    if(it == table.tags.end())
+        return nullptr;
+    return &(*it);
+}
+
 OTMLNodePtr OTMLNode::create(std::string tag, bool unique)
 {
     OTMLNodePtr node(new OTMLNode);
@@ -41,6 +125,20 @@ OTMLNodePtr OTMLNode::create(std::string tag, std::string value)
     return node;
 }
 
+OTMLNode::~OTMLNode()
+{
+    invalidateChildIndex();
+}
+
+void OTMLNode::setTag(const std::string& tag)
+{
+    m_tag = internTag(tag);
+
+    // only the parent indexing this node by its tag is affected
+    if(m_indexParent)
+        m_indexParent->invalidateChildIndex();
+}
+
 bool OTMLNode::hasChildren()
 {
     int count = 0;
@@ -51,15 +149,45 @@ bool OTMLNode::hasChildren()
     return count > 0;
 }
 
-OTMLNodePtr OTMLNode::get(const std::string& childTag)
+OTMLNode* OTMLNode::findChild(const std::string* tag)
 {
-    for(const OTMLNodePtr& child : m_children) {
-        if(child->tag() == childTag && !child->isNull())
+    if(!tag)
+        return nullptr;
+
+    std::size_t start = 0;
+    if(m_children.size() >= CHILD_INDEX_MIN_SIZE) {
+        // the index points at the first child with the tag, null children are skipped by the scan below
+        if(!m_childIndex) {
+            m_childIndex.reset(new std::unordered_map<const std::string*, int>);
+            for(int i = m_children.size() - 1; i >= 0; --i) {
+                OTMLNode *child = m_children[i].get();
+                // a node shared by two parents reports tag changes to the last one that indexed it
+                if(child->m_indexParent && child->m_indexParent != this)
+                    child->m_indexParent->invalidateChildIndex();
+                child->m_indexParent = this;
+                (*m_childIndex)[child->m_tag] = i;
+            }
+        }
+
+        auto it = m_childIndex->find(tag);
+        if(it == m_childIndex->end())
+            return nullptr;
+        start = it->second;
+    }
+
+    for(std::size_t i = start; i < m_children.size(); ++i) {
+        OTMLNode *child = m_children[i].get();
+        if(child->m_tag == tag && !child->isNull())
             return child;
     }
     return nullptr;
 }
 
+OTMLNodePtr OTMLNode::get(const std::string& childTag)
+{
+    return findChild(findTag(childTag));
+}
+
 OTMLNodePtr OTMLNode::getIndex(int childIndex)
 {
     if(childIndex < size() && childIndex >= 0)
@@ -69,13 +197,7 @@ OTMLNodePtr OTMLNode::getIndex(int childIndex)
 
 OTMLNodePtr OTMLNode::at(const std::string& childTag)
 {
-    OTMLNodePtr res;
-    for(const OTMLNodePtr& child : m_children) {
-        if(child->tag() == childTag && !child->isNull()) {
-            res = child;
-            break;
-        }
-    }
+    OTMLNodePtr res = findChild(findTag(childTag));
     if(!res)
         throw OTMLException(asOTMLNode(), stdext::format("child node with tag '%s' not found", childTag));
     return res;
@@ -90,10 +212,12 @@ OTMLNodePtr OTMLNode::atIndex(int childIndex)
 
 void OTMLNode::addChild(const OTMLNodePtr& newChild)
 {
+    invalidateChildIndex();
+
     // replace is needed when the tag is marked as unique
     if(newChild->hasTag()) {
         for(const OTMLNodePtr& node : m_children) {
-            if(node->tag() == newChild->tag() && (node->isUnique() || newChild->isUnique())) {
+            if(node->m_tag == newChild->m_tag && (node->isUnique() || newChild->isUnique())) {
                 newChild->setUnique(true);
 
                 if(node->hasChildren() && newChild->hasChildren()) {
@@ -108,7 +232,7 @@ void OTMLNode::addChild(const OTMLNodePtr& newChild)
                 auto it = m_children.begin();
                 while(it != m_children.end()) {
                     OTMLNodePtr node = (*it);
-                    if(node != newChild && node->tag() == newChild->tag()) {
+                    if(node != newChild && node->m_tag == newChild->m_tag) {
                         it = m_children.erase(it);
                     } else
                         ++it;
@@ -125,6 +249,7 @@ bool OTMLNode::removeChild(const OTMLNodePtr& oldChild)
 {
     auto it = std::find(m_children.begin(), m_children.end(), oldChild);
     if(it != m_children.end()) {
+        invalidateChildIndex();
         m_children.erase(it);
         return true;
     }
@@ -135,6 +260,7 @@ bool OTMLNode::replaceChild(const OTMLNodePtr& oldChild, const OTMLNodePtr& newC
 {
     auto it = std::find(m_children.begin(), m_children.end(), oldChild);
     if(it != m_children.end()) {
+        invalidateChildIndex();
         it = m_children.erase(it);
         m_children.insert(it, newChild);
         return true;
@@ -164,9 +290,23 @@ void OTMLNode::merge(const OTMLNodePtr& node)
 
 void OTMLNode::clear()
 {
+    invalidateChildIndex();
     m_children.clear();
 }
 
+void OTMLNode::invalidateChildIndex()
+{
+    if(!m_childIndex)
+        return;
+
+    // children must not point back here once they are no longer indexed
+    for(const OTMLNodePtr& child : m_children) {
+        if(child->m_indexParent == this)
+            child->m_indexParent = nullptr;
+    }
+    m_childIndex.reset();
+}
+
 OTMLNodeList OTMLNode::children()
 {
     OTMLNodeList children;
@@ -179,7 +319,7 @@ OTMLNodeList OTMLNode::children()
 OTMLNodePtr OTMLNode::clone()
 {
     OTMLNodePtr myClone(new OTMLNode);
-    myClone->setTag(m_tag);
+    myClone->m_tag = m_tag;
     myClone->setValue(m_value);
     myClone->setUnique(m_unique);
     myClone->setNull(m_null);
@@ -27,13 +27,27 @@
 
 class OTMLNode : public stdext::shared_object
 {
+    enum {
+        // nodes with this many children get a hash index for tag lookups
+        CHILD_INDEX_MIN_SIZE = 8
+    };
+
 public:
-    virtual ~OTMLNode() { }
+    virtual ~OTMLNode();
 
     static OTMLNodePtr create(std::string tag = "", bool unique = false);
     static OTMLNodePtr create(std::string tag, std::string value);
 
-    std::string tag() { return m_tag; }
+    /// Nodes are allocated from a pool of fixed size blocks, main thread only
+    static void* operator new(std::size_t size);
+    static void operator delete(void* p, std::size_t size);
+
+    /// Returns the unique instance of a tag string, equal tags share the same pointer
+    static const std::string* internTag(const std::string& tag);
+    /// Same as internTag but never inserts, returns nullptr for unknown tags
+    static const std::string* findTag(const std::string& tag);
+
+    const std::string& tag() { return *m_tag; }
     int size() { return m_children.size(); }
     std::string source() { return m_source; }
     std::string rawValue() { return m_value; }
@@ -41,13 +55,13 @@ public:
     bool isUnique() { return m_unique; }
     bool isNull() { return m_null; }
 
-    bool hasTag() { return !m_tag.empty(); }
+    bool hasTag() { return !m_tag->empty(); }
     bool hasValue() { return !m_value.empty(); }
     bool hasChildren();
     bool hasChildAt(const std::string& childTag) { return !!get(childTag); }
     bool hasChildAtIndex(int childIndex) { return !!getIndex(childIndex); }
 
-    void setTag(const std::string& tag) { m_tag = tag; }
+    void setTag(const std::string& tag);
     void setValue(const std::string& value) { m_value = value; }
     void setNull(bool null) { m_null = null; }
     void setUnique(bool unique) { m_unique = unique; }
@@ -92,14 +106,21 @@ public:
     OTMLNodePtr asOTMLNode() { return static_self_cast<OTMLNode>(); }
 
 protected:
-    OTMLNode() : m_unique(false), m_null(false) { }
+    OTMLNode() : m_tag(emptyTag()), m_unique(false), m_null(false), m_indexParent(nullptr) { }
+
+    static const std::string* emptyTag();
+
+    OTMLNode* findChild(const std::string* tag);
+    void invalidateChildIndex();
 
     OTMLNodeList m_children;
-    std::string m_tag;
+    std::unique_ptr<std::unordered_map<const std::string*, int>> m_childIndex;
+    const std::string* m_tag;
     std::string m_value;
     std::string m_source;
     bool m_unique;
     bool m_null;
+    OTMLNode* m_indexParent; // the node whose child index holds this one
 };
 
 #include "otmlexception.h"
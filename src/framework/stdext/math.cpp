@@ -45,6 +45,15 @@ uint32_t adler32(const uint8_t *buffer, size_t size) {
     return (b << 16) | a;
 }
 
+uint64_t fnv1a64(const uint8_t *buffer, size_t size) {
+    uint64_t hash = 14695981039346656037ull;
+    while(size-- > 0) {
+        hash ^= *buffer++;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
 long random_range(long min, long max)
 {
     static std::random_device rd;
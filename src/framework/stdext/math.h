@@ -48,6 +48,7 @@ inline void writeSLE32(uchar *addr, int32_t value) { writeSLE16(addr + 2, value
 inline void writeSLE64(uchar *addr, int64_t value) { writeSLE32(addr + 4, value >> 32); writeSLE32(addr, (int32_t)value); }
 
 uint32_t adler32(const uint8_t *buffer, size_t size);
+uint64_t fnv1a64(const uint8_t *buffer, size_t size);
 
 long random_range(long min, long max);
 float random_range(float min, float max);
@@ -37,10 +37,14 @@ class UIAnchor;
 class UIAnchorGroup;
 class UIAnchorLayout;
 class UIParticles;
+class UIVirtualList;
+class UICompiledStyle;
 
 typedef stdext::shared_object_ptr<UIWidget> UIWidgetPtr;
 typedef stdext::shared_object_ptr<UIParticles> UIParticlesPtr;
 typedef stdext::shared_object_ptr<UITextEdit> UITextEditPtr;
+typedef stdext::shared_object_ptr<UIVirtualList> UIVirtualListPtr;
+typedef stdext::shared_object_ptr<UICompiledStyle> UICompiledStylePtr;
 typedef stdext::shared_object_ptr<UILayout> UILayoutPtr;
 typedef stdext::shared_object_ptr<UIBoxLayout> UIBoxLayoutPtr;
 typedef stdext::shared_object_ptr<UIHorizontalLayout> UIHorizontalLayoutPtr;
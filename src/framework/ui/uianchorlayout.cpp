@@ -23,7 +23,51 @@
 #include "uianchorlayout.h"
 #include "uiwidget.h"
 
-UIWidgetPtr UIAnchor::getHookedWidget(const UIWidgetPtr& widget, const UIWidgetPtr& parentWidget)
+void UIAnchorLookup::index()
+{
+    m_indexed = true;
+    m_children = m_parentWidget->getChildren();
+    m_indexes.reserve(m_children.size());
+    m_ids.reserve(m_children.size());
+    for(int i = 0; i < (int)m_children.size(); ++i) {
+        const UIWidgetPtr& child = m_children[i];
+        m_indexes[child.get()] = i;
+        // the first child with an id wins, like UIWidget::getChildById
+        m_ids.emplace(child->getId(), i);
+    }
+}
+
+UIWidgetPtr UIAnchorLookup::getChildById(const std::string& childId)
+{
+    if(!m_indexed)
+        index();
+    auto it = m_ids.find(childId);
+    if(it != m_ids.end())
+        return m_children[it->second];
+    return nullptr;
+}
+
+UIWidgetPtr UIAnchorLookup::getChildAfter(const UIWidgetPtr& relativeChild)
+{
+    if(!m_indexed)
+        index();
+    auto it = m_indexes.find(relativeChild.get());
+    if(it != m_indexes.end() && it->second + 1 < (int)m_children.size())
+        return m_children[it->second + 1];
+    return nullptr;
+}
+
+UIWidgetPtr UIAnchorLookup::getChildBefore(const UIWidgetPtr& relativeChild)
+{
+    if(!m_indexed)
+        index();
+    auto it = m_indexes.find(relativeChild.get());
+    if(it != m_indexes.end() && it->second > 0)
+        return m_children[it->second - 1];
+    return nullptr;
+}
+
+UIWidgetPtr UIAnchor::getHookedWidget(const UIWidgetPtr& widget, const UIWidgetPtr& parentWidget, UIAnchorLookup& lookup)
 {
     // determine hooked widget
     UIWidgetPtr hookedWidget;
@@ -31,11 +75,11 @@ UIWidgetPtr UIAnchor::getHookedWidget(const UIWidgetPtr& widget, const UIWidgetP
         if(m_hookedWidgetId == "parent")
             hookedWidget = parentWidget;
         else if(m_hookedWidgetId == "next")
-            hookedWidget = parentWidget->getChildAfter(widget);
+            hookedWidget = lookup.getChildAfter(widget);
         else if(m_hookedWidgetId == "prev")
-            hookedWidget = parentWidget->getChildBefore(widget);
+            hookedWidget = lookup.getChildBefore(widget);
         else
-            hookedWidget = parentWidget->getChildById(m_hookedWidgetId);
+            hookedWidget = lookup.getChildById(m_hookedWidgetId);
     }
     return hookedWidget;
 }
@@ -105,20 +149,24 @@ void UIAnchorGroup::addAnchor(const UIAnchorPtr& anchor)
     m_anchors.push_back(anchor);
 }
 
-void UIAnchorLayout::addAnchor(const UIWidgetPtr& anchoredWidget, Fw::AnchorEdge anchoredEdge,
-                               const std::string& hookedWidgetId, Fw::AnchorEdge hookedEdge)
+void UIAnchorLayout::insertAnchor(const UIWidgetPtr& anchoredWidget, const UIAnchorPtr& anchor)
 {
-    if(!anchoredWidget)
-        return;
-
     assert(anchoredWidget != getParentWidget());
 
-    UIAnchorPtr anchor(new UIAnchor(anchoredEdge, hookedWidgetId, hookedEdge));
     UIAnchorGroupPtr& anchorGroup = m_anchorsGroups[anchoredWidget];
     if(!anchorGroup)
         anchorGroup = UIAnchorGroupPtr(new UIAnchorGroup);
 
     anchorGroup->addAnchor(anchor);
+}
+
+void UIAnchorLayout::addAnchor(const UIWidgetPtr& anchoredWidget, Fw::AnchorEdge anchoredEdge,
+                               const std::string& hookedWidgetId, Fw::AnchorEdge hookedEdge)
+{
+    if(!anchoredWidget)
+        return;
+
+    insertAnchor(anchoredWidget, UIAnchorPtr(new UIAnchor(anchoredEdge, hookedWidgetId, hookedEdge)));
 
     // layout must be updated because a new anchor got in
     update();
@@ -137,16 +185,24 @@ bool UIAnchorLayout::hasAnchors(const UIWidgetPtr& anchoredWidget)
 
 void UIAnchorLayout::centerIn(const UIWidgetPtr& anchoredWidget, const std::string& hookedWidgetId)
 {
-    addAnchor(anchoredWidget, Fw::AnchorHorizontalCenter, hookedWidgetId, Fw::AnchorHorizontalCenter);
-    addAnchor(anchoredWidget, Fw::AnchorVerticalCenter, hookedWidgetId, Fw::AnchorVerticalCenter);
+    if(!anchoredWidget)
+        return;
+
+    insertAnchor(anchoredWidget, UIAnchorPtr(new UIAnchor(Fw::AnchorHorizontalCenter, hookedWidgetId, Fw::AnchorHorizontalCenter)));
+    insertAnchor(anchoredWidget, UIAnchorPtr(new UIAnchor(Fw::AnchorVerticalCenter, hookedWidgetId, Fw::AnchorVerticalCenter)));
+    update();
 }
 
 void UIAnchorLayout::fill(const UIWidgetPtr& anchoredWidget, const std::string& hookedWidgetId)
 {
-    addAnchor(anchoredWidget, Fw::AnchorLeft, hookedWidgetId, Fw::AnchorLeft);
-    addAnchor(anchoredWidget, Fw::AnchorRight, hookedWidgetId, Fw::AnchorRight);
-    addAnchor(anchoredWidget, Fw::AnchorTop, hookedWidgetId, Fw::AnchorTop);
-    addAnchor(anchoredWidget, Fw::AnchorBottom, hookedWidgetId, Fw::AnchorBottom);
+    if(!anchoredWidget)
+        return;
+
+    insertAnchor(anchoredWidget, UIAnchorPtr(new UIAnchor(Fw::AnchorLeft, hookedWidgetId, Fw::AnchorLeft)));
+    insertAnchor(anchoredWidget, UIAnchorPtr(new UIAnchor(Fw::AnchorRight, hookedWidgetId, Fw::AnchorRight)));
+    insertAnchor(anchoredWidget, UIAnchorPtr(new UIAnchor(Fw::AnchorTop, hookedWidgetId, Fw::AnchorTop)));
+    insertAnchor(anchoredWidget, UIAnchorPtr(new UIAnchor(Fw::AnchorBottom, hookedWidgetId, Fw::AnchorBottom)));
+    update();
 }
 
 void UIAnchorLayout::addWidget(const UIWidgetPtr& widget)
@@ -159,7 +215,7 @@ void UIAnchorLayout::removeWidget(const UIWidgetPtr& widget)
     removeAnchors(widget);
 }
 
-bool UIAnchorLayout::updateWidget(const UIWidgetPtr& widget, const UIAnchorGroupPtr& anchorGroup, UIWidgetPtr first)
+bool UIAnchorLayout::updateWidget(const UIWidgetPtr& widget, const UIAnchorGroupPtr& anchorGroup, UIAnchorLookup& lookup, UIWidgetPtr first)
 {
     UIWidgetPtr parentWidget = getParentWidget();
     if(!parentWidget)
@@ -184,7 +240,7 @@ bool UIAnchorLayout::updateWidget(const UIWidgetPtr& widget, const UIAnchorGroup
             continue;
 
         // determine hooked widget
-        UIWidgetPtr hookedWidget = anchor->getHookedWidget(widget, parentWidget);
+        UIWidgetPtr hookedWidget = anchor->getHookedWidget(widget, parentWidget, lookup);
 
         // skip invalid anchors
         if(!hookedWidget)
@@ -196,7 +252,7 @@ bool UIAnchorLayout::updateWidget(const UIWidgetPtr& widget, const UIAnchorGroup
             if(it != m_anchorsGroups.end()) {
                 const UIAnchorGroupPtr& hookedAnchorGroup = it->second;
                 if(!hookedAnchorGroup->isUpdated())
-                    updateWidget(hookedWidget, hookedAnchorGroup, first);
+                    updateWidget(hookedWidget, hookedAnchorGroup, lookup, first);
             }
         }
 
@@ -254,6 +310,7 @@ bool UIAnchorLayout::updateWidget(const UIWidgetPtr& widget, const UIAnchorGroup
 bool UIAnchorLayout::internalUpdate()
 {
     bool changed = false;
+    UIAnchorLookup lookup(getParentWidget());
 
     // reset all anchors groups update state
     for(auto& it : m_anchorsGroups) {
@@ -266,7 +323,7 @@ bool UIAnchorLayout::internalUpdate()
         const UIWidgetPtr& widget = it.first;
         const UIAnchorGroupPtr& anchorGroup = it.second;
         if(!anchorGroup->isUpdated()) {
-            if(updateWidget(widget, anchorGroup))
+            if(updateWidget(widget, anchorGroup, lookup))
                 changed = true;
         }
     }
@@ -25,6 +25,26 @@
 
 #include "uilayout.h"
 
+// resolves anchor targets among the children of a layout, indexed once per update pass
+class UIAnchorLookup
+{
+public:
+    UIAnchorLookup(const UIWidgetPtr& parentWidget) : m_parentWidget(parentWidget), m_indexed(false) { }
+
+    UIWidgetPtr getChildById(const std::string& childId);
+    UIWidgetPtr getChildAfter(const UIWidgetPtr& relativeChild);
+    UIWidgetPtr getChildBefore(const UIWidgetPtr& relativeChild);
+
+private:
+    void index();
+
+    UIWidgetPtr m_parentWidget;
+    UIWidgetList m_children;
+    std::unordered_map<UIWidget*, int> m_indexes;
+    std::unordered_map<std::string, int> m_ids;
+    bool m_indexed;
+};
+
 class UIAnchor : public stdext::shared_object
 {
 public:
@@ -34,7 +54,7 @@ public:
     Fw::AnchorEdge getAnchoredEdge() const { return m_anchoredEdge; }
     Fw::AnchorEdge getHookedEdge() const { return m_hookedEdge; }
 
-    virtual UIWidgetPtr getHookedWidget(const UIWidgetPtr& widget, const UIWidgetPtr& parentWidget);
+    virtual UIWidgetPtr getHookedWidget(const UIWidgetPtr& widget, const UIWidgetPtr& parentWidget, UIAnchorLookup& lookup);
     virtual int getHookedPoint(const UIWidgetPtr& hookedWidget, const UIWidgetPtr& parentWidget);
 
 protected:
@@ -77,8 +97,9 @@ public:
     bool isUIAnchorLayout() { return true; }
 
 protected:
+    void insertAnchor(const UIWidgetPtr& anchoredWidget, const UIAnchorPtr& anchor);
     virtual bool internalUpdate();
-    virtual bool updateWidget(const UIWidgetPtr& widget, const UIAnchorGroupPtr& anchorGroup, UIWidgetPtr first = nullptr);
+    virtual bool updateWidget(const UIWidgetPtr& widget, const UIAnchorGroupPtr& anchorGroup, UIAnchorLookup& lookup, UIWidgetPtr first = nullptr);
     std::unordered_map<UIWidgetPtr, UIAnchorGroupPtr> m_anchorsGroups;
 };
 
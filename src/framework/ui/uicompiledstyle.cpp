@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2010-2017 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "uicompiledstyle.h"
+#include "uitranslator.h"
+
+UICompiledStyle::UICompiledStyle(const OTMLNodePtr& style)
+{
+    m_style = style;
+    m_dynamic = false;
+
+    for(const OTMLNodePtr& node : style->children()) {
+        int states, excludedStates;
+        if(!Fw::translateStateSelector(node, states, excludedStates)) {
+            // style values are reapplied when resetting, lua expressions among them can't be shared
+            if(!node->tag().empty() && node->tag()[0] == '!')
+                m_dynamic = true;
+            continue;
+        }
+
+        StateBlock block;
+        block.states = states;
+        block.excludedStates = excludedStates;
+        block.node = node;
+        m_blocks.push_back(block);
+
+        for(const OTMLNodePtr& child : node->children()) {
+            const std::string& tag = child->tag();
+            if(!tag.empty() && tag[0] == '!') {
+                // lua expressions are evaluated when applied, so they can't be shared
+                m_dynamic = true;
+                m_stateTags.insert(tag.substr(1));
+            } else
+                m_stateTags.insert(tag);
+        }
+    }
+
+    // active blocks are tracked as bits
+    m_cacheable = m_blocks.size() <= 64;
+}
+
+OTMLNodePtr UICompiledStyle::getStateStyle(int states, uint64& appliedBlocks)
+{
+    uint64 activeBlocks = 0;
+    for(uint i = 0; i < m_blocks.size(); ++i) {
+        const StateBlock& block = m_blocks[i];
+        if((states & block.states) == block.states && !(states & block.excludedStates))
+            activeBlocks |= (uint64)1 << i;
+    }
+
+    std::pair<uint64, uint64> key(appliedBlocks, activeBlocks);
+    auto it = m_stateStyles.find(key);
+    if(it == m_stateStyles.end())
+        it = m_stateStyles.insert(std::make_pair(key, buildStateStyle(appliedBlocks, activeBlocks))).first;
+    appliedBlocks |= activeBlocks;
+
+    // applying translates ! tags in place
+    return m_dynamic ? it->second->clone() : it->second;
+}
+
+bool UICompiledStyle::isAffectedBy(const OTMLNodePtr& node)
+{
+    for(const OTMLNodePtr& child : node->children()) {
+        std::string tag = child->tag();
+        if(!tag.empty() && tag[0] == '!')
+            tag = tag.substr(1);
+        if(!tag.empty() && (tag[0] == '$' || m_stateTags.find(tag) != m_stateTags.end()))
+            return true;
+    }
+    return false;
+}
+
+OTMLNodePtr UICompiledStyle::buildStateStyle(uint64 appliedBlocks, uint64 activeBlocks)
+{
+    OTMLNodePtr stateStyle = OTMLNode::create();
+
+    // properties changed by previously applied blocks go back to the style values, in style order
+    if(appliedBlocks) {
+        std::unordered_set<std::string> resetTags;
+        for(uint i = 0; i < m_blocks.size(); ++i) {
+            if(!(appliedBlocks & ((uint64)1 << i)))
+                continue;
+            for(const OTMLNodePtr& child : m_blocks[i].node->children()) {
+                const std::string& tag = child->tag();
+                resetTags.insert(!tag.empty() && tag[0] == '!' ? tag.substr(1) : tag);
+            }
+        }
+
+        for(const OTMLNodePtr& child : m_style->children()) {
+            const std::string& tag = child->tag();
+            if(resetTags.find(!tag.empty() && tag[0] == '!' ? tag.substr(1) : tag) != resetTags.end())
+                stateStyle->addChild(child->clone());
+        }
+    }
+
+    for(uint i = 0; i < m_blocks.size(); ++i) {
+        if(activeBlocks & ((uint64)1 << i))
+            stateStyle->merge(m_blocks[i].node);
+    }
+
+    return stateStyle;
+}
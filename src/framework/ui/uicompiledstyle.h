@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2010-2017 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef UICOMPILEDSTYLE_H
+#define UICOMPILEDSTYLE_H
+
+#include "declarations.h"
+#include <framework/otml/otmlnode.h>
+#include <unordered_set>
+
+/// State blocks ($hover, $!disabled...) of a style translated once. The node applied on a state
+/// change only depends on the blocks applied before and the blocks active now, so it is merged
+/// once per combination and shared by every widget using the style
+class UICompiledStyle : public stdext::shared_object
+{
+public:
+    UICompiledStyle(const OTMLNodePtr& style);
+
+    /// Node to apply for the given states, appliedBlocks accumulates the blocks applied so far
+    OTMLNodePtr getStateStyle(int states, uint64& appliedBlocks);
+    /// Whether a node merged over the style adds state blocks or overrides properties they reset
+    bool isAffectedBy(const OTMLNodePtr& node);
+    bool isCacheable() { return m_cacheable; }
+
+private:
+    struct StateBlock {
+        int states;
+        int excludedStates;
+        OTMLNodePtr node;
+    };
+
+    OTMLNodePtr buildStateStyle(uint64 appliedBlocks, uint64 activeBlocks);
+
+    OTMLNodePtr m_style;
+    std::vector<StateBlock> m_blocks;
+    std::unordered_set<std::string> m_stateTags;
+    std::map<std::pair<uint64, uint64>, OTMLNodePtr> m_stateStyles;
+    bool m_cacheable;
+    bool m_dynamic;
+};
+
+#endif
@@ -22,8 +22,7 @@
 
 #include "uilayout.h"
 #include "uiwidget.h"
-
-#include <framework/core/eventdispatcher.h>
+#include "uimanager.h"
 
 void UILayout::update()
 {
@@ -41,8 +40,11 @@ void UILayout::update()
     } while(parent);
     */
 
-    if(m_updateDisabled)
+    if(m_updateDisabled) {
+        // remember it, so whoever disabled updates can solve once when enabling them again
+        m_updatePending = true;
         return;
+    }
 
     if(m_updating) {
         updateLater();
@@ -50,23 +52,31 @@ void UILayout::update()
     }
 
     m_updating = true;
+    m_updatePending = false;
     internalUpdate();
-    m_parentWidget->onLayoutUpdate();
+    g_ui.onLayoutSolve();
+
+    // inside a scheduled pass lua callbacks fire once every pending layout got solved
+    if(g_ui.isUpdatingLayouts())
+        g_ui.deferLayoutCallback(m_parentWidget);
+    else
+        m_parentWidget->onLayoutUpdate();
     m_updating = false;
 }
 
 void UILayout::updateLater()
 {
-    if(m_updateDisabled || m_updateScheduled)
+    if(m_updateDisabled) {
+        m_updatePending = true;
+        return;
+    }
+
+    if(m_updateScheduled)
         return;
 
     if(!getParentWidget())
         return;
 
-    auto self = static_self_cast<UILayout>();
-    g_dispatcher.addEvent([self] {
-        self->m_updateScheduled = false;
-        self->update();
-    });
     m_updateScheduled = true;
+    g_ui.scheduleLayoutUpdate(static_self_cast<UILayout>());
 }
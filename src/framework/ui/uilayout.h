@@ -46,6 +46,7 @@ public:
     UIWidgetPtr getParentWidget() { return m_parentWidget; }
 
     bool isUpdateDisabled() { return m_updateDisabled > 0; }
+    bool isUpdatePending() { return m_updatePending; }
     bool isUpdating() { return m_updating; }
 
     virtual bool isUIAnchorLayout() { return false; }
@@ -60,7 +61,10 @@ protected:
     int m_updateDisabled;
     stdext::boolean<false> m_updating;
     stdext::boolean<false> m_updateScheduled;
+    stdext::boolean<false> m_updatePending;
     UIWidgetPtr m_parentWidget;
+
+    friend class UIManager;
 };
 
 #endif
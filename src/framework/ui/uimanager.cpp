@@ -22,6 +22,7 @@
 
 #include "uimanager.h"
 #include "ui.h"
+#include "uicompiledstyle.h"
 
 #include <framework/otml/otml.h>
 #include <framework/graphics/graphics.h>
@@ -32,8 +33,19 @@
 
 UIManager g_ui;
 
+// size of the screen grid cells used to bucket widgets for hit testing
+static const int HIT_CELL_SIZE = 64;
+
 void UIManager::init()
 {
+    m_layerRedraws = 0;
+    m_layerBlits = 0;
+    m_mouseMoveMicros = 0;
+    m_mouseMoveMicrosSum = 0;
+    m_mouseMoveEvents = 0;
+    m_layoutSolves = 0;
+    m_lastFrameLayoutSolves = 0;
+
     // creates root widget
     m_rootWidget = UIWidgetPtr(new UIWidget);
     m_rootWidget->setId("root");
@@ -52,12 +64,30 @@ void UIManager::terminate()
     m_hoveredWidget = nullptr;
     m_pressedWidget = nullptr;
     m_styles.clear();
+    m_compiledStyles.clear();
     m_destroyedWidgets.clear();
     m_checkEvent = nullptr;
+    m_hitEntries.clear();
+    m_hitCells.clear();
+    m_pendingLayouts.clear();
+    m_layoutCallbacks.clear();
 }
 
 void UIManager::render(Fw::DrawPane drawPane)
 {
+    // layouts are always solved before painting
+    if(!m_pendingLayouts.empty())
+        updateLayouts();
+
+    if(drawPane & Fw::BackgroundPane) {
+        m_lastFrameLayoutSolves = m_layoutSolves;
+        m_layoutSolves = 0;
+    }
+
+    // rebuild the hit index at most once per frame, mouse events in between walk the tree
+    if(m_hitIndexDirty)
+        updateHitIndex();
+
     m_rootWidget->draw(m_rootWidget->getRect(), drawPane);
 }
 
@@ -68,6 +98,7 @@ void UIManager::resize(const Size& size)
 
 void UIManager::inputEvent(const InputEvent& event)
 {
+    ticks_t startTime = stdext::micros();
     UIWidgetList widgetList;
     switch(event.type) {
         case Fw::KeyTextInputEvent:
@@ -84,7 +115,11 @@ void UIManager::inputEvent(const InputEvent& event)
             break;
         case Fw::MousePressInputEvent:
             if(event.mouseButton == Fw::MouseLeftButton && m_mouseReceiver->isVisible()) {
-                UIWidgetPtr pressedWidget = m_mouseReceiver->recursiveGetChildByPos(event.mousePos, false);
+                UIWidgetPtr pressedWidget;
+                if(m_mouseReceiver == m_rootWidget)
+                    pressedWidget = getWidgetByPos(event.mousePos, false);
+                else
+                    pressedWidget = m_mouseReceiver->recursiveGetChildByPos(event.mousePos, false);
                 if(pressedWidget && !pressedWidget->isEnabled())
                     pressedWidget = nullptr;
                 updatePressedWidget(pressedWidget, event.mousePos);
@@ -159,6 +194,15 @@ void UIManager::inputEvent(const InputEvent& event)
         default:
             break;
     };
+
+    if(event.type == Fw::MouseMoveInputEvent) {
+        m_mouseMoveMicrosSum += stdext::micros() - startTime;
+        if(++m_mouseMoveEvents >= 100) {
+            m_mouseMoveMicros = m_mouseMoveMicrosSum / m_mouseMoveEvents;
+            m_mouseMoveMicrosSum = 0;
+            m_mouseMoveEvents = 0;
+        }
+    }
 }
 
 void UIManager::updatePressedWidget(const UIWidgetPtr& newPressedWidget, const Point& clickedPos, bool fireClicks)
@@ -222,7 +266,7 @@ void UIManager::updateHoveredWidget(bool now)
         m_hoverUpdateScheduled = false;
         UIWidgetPtr hoveredWidget;
         //if(!g_window.isMouseButtonPressed(Fw::MouseLeftButton) && !g_window.isMouseButtonPressed(Fw::MouseRightButton)) {
-            hoveredWidget = m_rootWidget->recursiveGetChildByPos(g_window.getMousePosition(), false);
+            hoveredWidget = getWidgetByPos(g_window.getMousePosition(), false);
             if(hoveredWidget && !hoveredWidget->isEnabled())
                 hoveredWidget = nullptr;
         //}
@@ -249,6 +293,145 @@ void UIManager::updateHoveredWidget(bool now)
     }
 }
 
+void UIManager::scheduleLayoutUpdate(const UILayoutPtr& layout)
+{
+    m_pendingLayouts.push_back(layout);
+
+    // every layout dirtied until the next poll is solved in a single pass
+    if(!m_layoutUpdateScheduled) {
+        m_layoutUpdateScheduled = true;
+        g_dispatcher.addEvent([this] { updateLayouts(); });
+    }
+}
+
+void UIManager::updateLayouts()
+{
+    m_layoutUpdateScheduled = false;
+    if(m_updatingLayouts)
+        return;
+
+    m_updatingLayouts = true;
+
+    // layouts dirtied while solving join the pass, a few rounds at most to break feedback loops
+    for(int round = 0; round < 10 && !m_pendingLayouts.empty(); ++round) {
+        std::vector<std::pair<int, UILayoutPtr>> layouts;
+        layouts.reserve(m_pendingLayouts.size());
+        for(const UILayoutPtr& layout : m_pendingLayouts) {
+            int depth = 0;
+            for(UIWidgetPtr widget = layout->getParentWidget(); widget; widget = widget->getParent())
+                depth++;
+            layouts.push_back(std::make_pair(depth, layout));
+        }
+        m_pendingLayouts.clear();
+
+        // parents are solved before their children, so children see their final parent rect
+        std::stable_sort(layouts.begin(), layouts.end(), [](const std::pair<int, UILayoutPtr>& a, const std::pair<int, UILayoutPtr>& b) {
+            return a.first < b.first;
+        });
+
+        for(const auto& it : layouts) {
+            const UILayoutPtr& layout = it.second;
+            layout->m_updateScheduled = false;
+            layout->update();
+        }
+    }
+
+    m_updatingLayouts = false;
+
+    std::vector<UIWidgetPtr> callbacks;
+    callbacks.swap(m_layoutCallbacks);
+    for(const UIWidgetPtr& widget : callbacks) {
+        if(!widget->isDestroyed())
+            widget->onLayoutUpdate();
+    }
+
+    if(!m_pendingLayouts.empty() && !m_layoutUpdateScheduled) {
+        m_layoutUpdateScheduled = true;
+        g_dispatcher.addEvent([this] { updateLayouts(); });
+    }
+}
+
+void UIManager::deferLayoutCallback(const UIWidgetPtr& widget)
+{
+    if(std::find(m_layoutCallbacks.begin(), m_layoutCallbacks.end(), widget) == m_layoutCallbacks.end())
+        m_layoutCallbacks.push_back(widget);
+}
+
+UIWidgetPtr UIManager::getWidgetByPos(const Point& pos, bool wantsPhantom)
+{
+    if(m_hitIndexDirty)
+        return m_rootWidget->recursiveGetChildByPos(pos, wantsPhantom);
+
+    Point cellPos = pos - m_rootWidget->getPosition();
+    if(cellPos.x < 0 || cellPos.y < 0)
+        return nullptr;
+
+    int x = cellPos.x / HIT_CELL_SIZE;
+    int y = cellPos.y / HIT_CELL_SIZE;
+    if(x >= m_hitGridSize.width() || y >= m_hitGridSize.height())
+        return nullptr;
+
+    // the topmost widget is the last one painted, same as walking children backwards
+    const std::vector<int>& cell = m_hitCells[y * m_hitGridSize.width() + x];
+    for(auto it = cell.rbegin(); it != cell.rend(); ++it) {
+        const HitEntry& entry = m_hitEntries[*it];
+        if(entry.rect.contains(pos) && (wantsPhantom || !entry.phantom))
+            return entry.widget->static_self_cast<UIWidget>();
+    }
+    return nullptr;
+}
+
+void UIManager::updateHitIndex()
+{
+    m_hitIndexDirty = false;
+    m_hitEntries.clear();
+
+    // each widget can only be hit inside its own rect and the padding rects of its ancestors
+    Rect rootArea = m_rootWidget->getPaddingRect();
+    if(rootArea.isValid())
+        collectHitEntries(m_rootWidget, rootArea);
+
+    Rect rootRect = m_rootWidget->getRect();
+    m_hitGridSize = Size((rootRect.width() + HIT_CELL_SIZE - 1) / HIT_CELL_SIZE,
+                         (rootRect.height() + HIT_CELL_SIZE - 1) / HIT_CELL_SIZE);
+    m_hitCells.resize(std::max<int>(m_hitGridSize.area(), 0));
+    for(std::vector<int>& cell : m_hitCells)
+        cell.clear();
+
+    for(int i = 0; i < (int)m_hitEntries.size(); ++i) {
+        Rect rect = m_hitEntries[i].rect.translated(-rootRect.topLeft());
+        int left = std::max<int>(rect.left() / HIT_CELL_SIZE, 0);
+        int top = std::max<int>(rect.top() / HIT_CELL_SIZE, 0);
+        int right = std::min<int>(rect.right() / HIT_CELL_SIZE, m_hitGridSize.width() - 1);
+        int bottom = std::min<int>(rect.bottom() / HIT_CELL_SIZE, m_hitGridSize.height() - 1);
+        for(int y = top; y <= bottom; ++y)
+            for(int x = left; x <= right; ++x)
+                m_hitCells[y * m_hitGridSize.width() + x].push_back(i);
+    }
+}
+
+void UIManager::collectHitEntries(const UIWidgetPtr& parent, const Rect& area)
+{
+    for(const UIWidgetPtr& child : parent->m_children) {
+        if(!child->isExplicitlyVisible() || !child->getRect().isValid())
+            continue;
+
+        Rect rect = area.intersection(child->getRect());
+        if(!rect.isValid())
+            continue;
+
+        HitEntry entry;
+        entry.rect = rect;
+        entry.widget = child.get();
+        entry.phantom = child->isPhantom();
+        m_hitEntries.push_back(entry);
+
+        Rect childrenArea = rect.intersection(child->getPaddingRect());
+        if(child->hasChildren() && childrenArea.isValid())
+            collectHitEntries(child, childrenArea);
+    }
+}
+
 void UIManager::onWidgetAppear(const UIWidgetPtr& widget)
 {
     if(widget->containsPoint(g_window.getMousePosition()))
@@ -306,6 +489,7 @@ void UIManager::onWidgetDestroy(const UIWidgetPtr& widget)
 void UIManager::clearStyles()
 {
     m_styles.clear();
+    m_compiledStyles.clear();
 }
 
 bool UIManager::importStyle(std::string file)
@@ -365,6 +549,7 @@ void UIManager::importStyleFromOTML(const OTMLNodePtr& styleNode)
         style->merge(styleNode);
         style->setTag(name);
         m_styles[name] = style;
+        m_compiledStyles.erase(name);
     }
 }
 
@@ -385,6 +570,21 @@ OTMLNodePtr UIManager::getStyle(const std::string& styleName)
     return nullptr;
 }
 
+UICompiledStylePtr UIManager::getCompiledStyle(const std::string& styleName)
+{
+    auto it = m_compiledStyles.find(styleName);
+    if(it != m_compiledStyles.end())
+        return it->second;
+
+    OTMLNodePtr style = getStyle(styleName);
+    if(!style)
+        return nullptr;
+
+    UICompiledStylePtr compiledStyle(new UICompiledStyle(style));
+    m_compiledStyles[styleName] = compiledStyle;
+    return compiledStyle;
+}
+
 std::string UIManager::getStyleClass(const std::string& styleName)
 {
     OTMLNodePtr style = getStyle(styleName);
@@ -450,7 +650,11 @@ UIWidgetPtr UIManager::createWidgetFromOTML(const OTMLNodePtr& widgetNode, const
     if(widget) {
         widget->callLuaField("onCreate");
 
-        widget->setStyleFromNode(styleNode);
+        // widgets not touching the state blocks share the compiled states of their style
+        UICompiledStylePtr compiledStyle = getCompiledStyle(widgetNode->tag());
+        if(compiledStyle && compiledStyle->isAffectedBy(widgetNode))
+            compiledStyle = nullptr;
+        widget->setStyleNode(styleNode, compiledStyle);
 
         for(const OTMLNodePtr& childNode : styleNode->children()) {
             if(!childNode->isUnique()) {
@@ -42,11 +42,15 @@ public:
     void updatePressedWidget(const UIWidgetPtr& newPressedWidget, const Point& clickedPos = Point(), bool fireClicks = true);
     bool updateDraggingWidget(const UIWidgetPtr& draggingWidget, const Point& clickedPos = Point());
     void updateHoveredWidget(bool now = false);
+    UIWidgetPtr getWidgetByPos(const Point& pos, bool wantsPhantom);
+    void scheduleLayoutUpdate(const UILayoutPtr& layout);
+    void updateLayouts();
 
     void clearStyles();
     bool importStyle(std::string file);
     void importStyleFromOTML(const OTMLNodePtr& styleNode);
     OTMLNodePtr getStyle(const std::string& styleName);
+    UICompiledStylePtr getCompiledStyle(const std::string& styleName);
     std::string getStyleClass(const std::string& styleName);
 
     UIWidgetPtr loadUI(std::string file, const UIWidgetPtr& parent);
@@ -69,15 +73,35 @@ public:
     bool isKeyboardGrabbed() { return m_keyboardReceiver != m_rootWidget; }
 
     bool isDrawingDebugBoxes() { return m_drawDebugBoxes; }
+    int getLayerRedraws() { return m_layerRedraws; }
+    int getLayerBlits() { return m_layerBlits; }
+    int getMouseMoveMicros() { return m_mouseMoveMicros; }
+    int getLayoutSolves() { return m_lastFrameLayoutSolves; }
+    bool isUpdatingLayouts() { return m_updatingLayouts; }
 
 protected:
     void onWidgetAppear(const UIWidgetPtr& widget);
     void onWidgetDisappear(const UIWidgetPtr& widget);
     void onWidgetDestroy(const UIWidgetPtr& widget);
+    void onLayerRedraw() { m_layerRedraws++; }
+    void onLayerBlit() { m_layerBlits++; }
+    void onWidgetHitAreaChange() { m_hitIndexDirty = true; }
+    void onLayoutSolve() { m_layoutSolves++; }
+    void deferLayoutCallback(const UIWidgetPtr& widget);
 
     friend class UIWidget;
+    friend class UILayout;
 
 private:
+    void updateHitIndex();
+    void collectHitEntries(const UIWidgetPtr& parent, const Rect& area);
+
+    struct HitEntry {
+        Rect rect;
+        UIWidget *widget;
+        bool phantom;
+    };
+
     UIWidgetPtr m_rootWidget;
     UIWidgetPtr m_mouseReceiver;
     UIWidgetPtr m_keyboardReceiver;
@@ -87,8 +111,27 @@ private:
     stdext::boolean<false> m_hoverUpdateScheduled;
     stdext::boolean<false> m_drawDebugBoxes;
     std::unordered_map<std::string, OTMLNodePtr> m_styles;
+    std::unordered_map<std::string, UICompiledStylePtr> m_compiledStyles;
     UIWidgetList m_destroyedWidgets;
     ScheduledEventPtr m_checkEvent;
+    int m_layerRedraws;
+    int m_layerBlits;
+    int m_mouseMoveMicros;
+    ticks_t m_mouseMoveMicrosSum;
+    int m_mouseMoveEvents;
+
+    // widgets in paint order with the area they can be hit in, bucketed in a screen grid
+    std::vector<HitEntry> m_hitEntries;
+    std::vector<std::vector<int>> m_hitCells;
+    Size m_hitGridSize;
+    stdext::boolean<true> m_hitIndexDirty;
+
+    std::vector<UILayoutPtr> m_pendingLayouts;
+    std::vector<UIWidgetPtr> m_layoutCallbacks;
+    stdext::boolean<false> m_layoutUpdateScheduled;
+    stdext::boolean<false> m_updatingLayouts;
+    int m_layoutSolves;
+    int m_lastFrameLayoutSolves;
 
 };
 
@@ -52,6 +52,11 @@ UITextEdit::UITextEdit()
     m_glyphsTextCoordsBuffer.enableHardwareCaching();
     m_glyphsSelectCoordsBuffer.enableHardwareCaching();
     m_glyphsMustRecache = true;
+    m_selectionMustRecache = true;
+    m_layoutWrapWidth = -1;
+    m_layoutHidden = false;
+    m_maxLineWidth = 0;
+    m_glyphsCoordsStart = 0;
     blinkCursor();
 }
 
@@ -77,18 +82,25 @@ void UITextEdit::drawSelf(Fw::DrawPane drawPane)
     if(m_color != Color::alpha) {
         if(glyphsMustRecache) {
             m_glyphsTextCoordsBuffer.clear();
-            for(int i=0;i<textLength;++i)
-                m_glyphsTextCoordsBuffer.addRect(m_glyphsCoords[i], m_glyphsTexCoords[i]);
+            for(uint i=0;i<m_glyphsCoords.size();++i) {
+                if(m_glyphsCoords[i].isValid())
+                    m_glyphsTextCoordsBuffer.addRect(m_glyphsCoords[i], m_glyphsTexCoords[i]);
+            }
         }
         g_painter->setColor(m_color);
         g_painter->drawTextureCoords(m_glyphsTextCoordsBuffer, texture);
     }
 
     if(hasSelection()) {
-        if(glyphsMustRecache) {
+        if(glyphsMustRecache || m_selectionMustRecache) {
+            m_selectionMustRecache = false;
             m_glyphsSelectCoordsBuffer.clear();
-            for(int i=m_selectionStart;i<m_selectionEnd;++i)
-                m_glyphsSelectCoordsBuffer.addRect(m_glyphsCoords[i], m_glyphsTexCoords[i]);
+            int first = std::max<int>(m_selectionStart, m_glyphsCoordsStart) - m_glyphsCoordsStart;
+            int last = std::min<int>(m_selectionEnd, m_glyphsCoordsStart + m_glyphsCoords.size()) - m_glyphsCoordsStart;
+            for(int i=first;i<last;++i) {
+                if(m_glyphsCoords[i].isValid())
+                    m_glyphsSelectCoordsBuffer.addRect(m_glyphsCoords[i], m_glyphsTexCoords[i]);
+            }
         }
         g_painter->setColor(m_selectionBackgroundColor);
         g_painter->drawFillCoords(m_glyphsSelectCoordsBuffer);
@@ -107,8 +119,10 @@ void UITextEdit::drawSelf(Fw::DrawPane drawPane)
             // when cursor is at 0
             if(m_cursorPos == 0)
                 cursorRect = Rect(m_rect.left()+m_padding.left, m_rect.top()+m_padding.top, 1, m_font->getGlyphHeight());
-            else
-                cursorRect = Rect(m_glyphsCoords[m_cursorPos-1].right(), m_glyphsCoords[m_cursorPos-1].top(), 1, m_font->getGlyphHeight());
+            else {
+                Rect glyphRect = getGlyphCoords(m_cursorPos-1);
+                cursorRect = Rect(glyphRect.right(), glyphRect.top(), 1, m_font->getGlyphHeight());
+            }
 
             if(hasSelection() && m_cursorPos >= m_selectionStart && m_cursorPos <= m_selectionEnd)
                 g_painter->setColor(m_selectionColor);
@@ -119,6 +133,9 @@ void UITextEdit::drawSelf(Fw::DrawPane drawPane)
         } else if(elapsed >= 2*delay) {
             m_cursorTicks = g_clock.millis();
         }
+
+        // the blinking cursor keeps an enclosing layer redrawing
+        repaint();
     }
 
     g_painter->resetColor();
@@ -129,9 +146,9 @@ void UITextEdit::update(bool focusCursor)
     if(!m_updatesEnabled)
         return;
 
-    std::string text = getDisplayedText();
-    m_drawText = text;
-    int textLength = text.length();
+    // bring the lines up to date, only the ones touched by an edit are laid out again
+    layoutText();
+    int textLength = m_drawText.length();
 
     // prevent glitches
     if(m_rect.isEmpty())
@@ -140,9 +157,12 @@ void UITextEdit::update(bool focusCursor)
     // recache coords buffers
     recacheGlyphs();
 
-    // map glyphs positions
-    Size textBoxSize;
-    const std::vector<Point>& glyphsPositions = m_font->calculateGlyphsPositions(text, m_textAlign, &textBoxSize);
+    // text box size
+    int glyphHeight = m_font->getGlyphHeight();
+    int lineHeight = glyphHeight + m_font->getGlyphSpacing().height();
+    Size textBoxSize(0, glyphHeight);
+    if(textLength > 0)
+        textBoxSize.resize(m_maxLineWidth, m_font->getYOffset() + ((int)m_lines.size() - 1) * lineHeight + glyphHeight);
     const Rect *glyphsTextureCoords = m_font->getGlyphsTextureCoords();
     const Size *glyphsSize = m_font->getGlyphsSize();
     int glyph;
@@ -158,12 +178,6 @@ void UITextEdit::update(bool focusCursor)
         setSize(size);
     }
 
-    // resize just on demand
-    if(textLength > (int)m_glyphsCoords.size()) {
-        m_glyphsCoords.resize(textLength);
-        m_glyphsTexCoords.resize(textLength);
-    }
-
     Point oldTextAreaOffset = m_textVirtualOffset;
 
     if(textBoxSize.width() <= getPaddingRect().width())
@@ -177,9 +191,9 @@ void UITextEdit::update(bool focusCursor)
         if(m_cursorPos > 0 && textLength > 0) {
                 assert(m_cursorPos <= textLength);
                 Rect virtualRect(m_textVirtualOffset, m_rect.size() - Size(m_padding.left+m_padding.right, 0)); // previous rendered virtual rect
-                int pos = m_cursorPos - 1; // element before cursor
-                glyph = (uchar)text[pos]; // glyph of the element before cursor
-                Rect glyphRect(glyphsPositions[pos], glyphsSize[glyph]);
+                int pos = std::min<int>(m_cursorPos, textLength) - 1; // element before cursor
+                glyph = (uchar)m_drawText[pos]; // glyph of the element before cursor
+                Rect glyphRect(getGlyphPosition(pos), glyphsSize[glyph]);
 
                 // if the cursor is not on the previous rendered virtual rect we need to update it
                 if(!virtualRect.contains(glyphRect.topLeft()) || !virtualRect.contains(glyphRect.bottomRight())) {
@@ -188,18 +202,23 @@ void UITextEdit::update(bool focusCursor)
                     startGlyphPos.y = std::max<int>(glyphRect.bottom() - virtualRect.height(), 0);
                     startGlyphPos.x = std::max<int>(glyphRect.right() - virtualRect.width(), 0);
 
-                    // find that glyph
-                    for(pos = 0; pos < textLength; ++pos) {
-                        glyph = (uchar)text[pos];
-                        glyphRect = Rect(glyphsPositions[pos], glyphsSize[glyph]);
-                        glyphRect.setTop(std::max<int>(glyphRect.top() - m_font->getYOffset() - m_font->getGlyphSpacing().height(), 0));
-                        glyphRect.setLeft(std::max<int>(glyphRect.left() - m_font->getGlyphSpacing().width(), 0));
-
-                        // first glyph entirely visible found
-                        if(glyphRect.topLeft() >= startGlyphPos) {
-                            m_textVirtualOffset.x = glyphsPositions[pos].x;
-                            m_textVirtualOffset.y = glyphsPositions[pos].y - m_font->getYOffset();
-                            break;
+                    // find that glyph, lines above the start position can't hold it
+                    bool found = false;
+                    for(int line = 0; line < (int)m_lines.size() && !found; ++line) {
+                        int top = line * lineHeight;
+                        if(std::max<int>(top - m_font->getGlyphSpacing().height(), 0) < startGlyphPos.y)
+                            continue;
+
+                        const TextLine& textLine = m_lines[line];
+                        int lineOffset = getLineOffset(textLine);
+                        for(int x : textLine.glyphsX) {
+                            // first glyph entirely visible found
+                            if(std::max<int>(lineOffset + x - m_font->getGlyphSpacing().width(), 0) >= startGlyphPos.x) {
+                                m_textVirtualOffset.x = lineOffset + x;
+                                m_textVirtualOffset.y = top;
+                                found = true;
+                                break;
+                            }
                         }
                     }
                 }
@@ -210,9 +229,9 @@ void UITextEdit::update(bool focusCursor)
     } else {
         if(m_cursorPos > 0 && textLength > 0) {
             Rect virtualRect(m_textVirtualOffset, m_rect.size() - Size(2*m_padding.left+m_padding.right, 0) ); // previous rendered virtual rect
-            int pos = m_cursorPos - 1; // element before cursor
-            glyph = (uchar)text[pos]; // glyph of the element before cursor
-            Rect glyphRect(glyphsPositions[pos], glyphsSize[glyph]);
+            int pos = std::min<int>(m_cursorPos, textLength) - 1; // element before cursor
+            glyph = (uchar)m_drawText[pos]; // glyph of the element before cursor
+            Rect glyphRect(getGlyphPosition(pos), glyphsSize[glyph]);
             if(virtualRect.contains(glyphRect.topLeft()) && virtualRect.contains(glyphRect.bottomRight()))
                 m_cursorInRange = true;
         } else {
@@ -246,93 +265,280 @@ void UITextEdit::update(bool focusCursor)
         fireAreaUpdate = true;
     }
 
+    Point alignOffset;
     if(m_textAlign & Fw::AlignBottom) {
-        m_drawArea.translate(0, textScreenCoords.height() - textBoxSize.height());
+        alignOffset.y = textScreenCoords.height() - textBoxSize.height();
     } else if(m_textAlign & Fw::AlignVerticalCenter) {
-        m_drawArea.translate(0, (textScreenCoords.height() - textBoxSize.height()) / 2);
+        alignOffset.y = (textScreenCoords.height() - textBoxSize.height()) / 2;
     } else { // AlignTop
     }
 
     if(m_textAlign & Fw::AlignRight) {
-        m_drawArea.translate(textScreenCoords.width() - textBoxSize.width(), 0);
+        alignOffset.x = textScreenCoords.width() - textBoxSize.width();
     } else if(m_textAlign & Fw::AlignHorizontalCenter) {
-        m_drawArea.translate((textScreenCoords.width() - textBoxSize.width()) / 2, 0);
+        alignOffset.x = (textScreenCoords.width() - textBoxSize.width()) / 2;
     } else { // AlignLeft
-
     }
+    m_drawArea.translate(alignOffset);
+
+    // only glyphs on the visible lines get coords, the others are never drawn
+    int firstLine = std::max<int>((m_textVirtualOffset.y - alignOffset.y - m_font->getYOffset() - glyphHeight) / lineHeight, 0);
+    firstLine = std::min<int>(firstLine, m_lines.size() - 1);
+    int lastLine = std::min<int>((m_textVirtualOffset.y - alignOffset.y - m_font->getYOffset() + textScreenCoords.height()) / lineHeight + 1, m_lines.size() - 1);
+    int firstGlyph = m_lines[firstLine].start;
+    int lastGlyph = lastLine + 1 < (int)m_lines.size() ? m_lines[lastLine + 1].start : textLength;
+
+    m_glyphsCoordsStart = firstGlyph;
+    m_glyphsCoords.assign(std::max<int>(lastGlyph - firstGlyph, 0), Rect());
+    m_glyphsTexCoords.resize(m_glyphsCoords.size());
+
+    for(int line = firstLine; line <= lastLine; ++line) {
+        const TextLine& textLine = m_lines[line];
+        Point linePos(getLineOffset(textLine), m_font->getYOffset() + line * lineHeight);
+
+        for(uint j = 0; j < textLine.glyphsX.size(); ++j) {
+            int i = textLine.start + j;
+            glyph = (uchar)m_drawText[i];
+
+            // skip invalid glyphs
+            if(glyph < 32 && glyph != (uchar)'\n')
+                continue;
+
+            // calculate initial glyph rect and texture coords
+            Rect glyphScreenCoords(linePos + Point(textLine.glyphsX[j], 0), glyphsSize[glyph]);
+            Rect glyphTextureCoords = glyphsTextureCoords[glyph];
+
+            // first translate to align position
+            glyphScreenCoords.translate(alignOffset);
+
+            // only render glyphs that are after startRenderPosition
+            if(glyphScreenCoords.bottom() < m_textVirtualOffset.y || glyphScreenCoords.right() < m_textVirtualOffset.x)
+                continue;
+
+            // bound glyph topLeft to startRenderPosition
+            if(glyphScreenCoords.top() < m_textVirtualOffset.y) {
+                glyphTextureCoords.setTop(glyphTextureCoords.top() + (m_textVirtualOffset.y - glyphScreenCoords.top()));
+                glyphScreenCoords.setTop(m_textVirtualOffset.y);
+            }
+            if(glyphScreenCoords.left() < m_textVirtualOffset.x) {
+                glyphTextureCoords.setLeft(glyphTextureCoords.left() + (m_textVirtualOffset.x - glyphScreenCoords.left()));
+                glyphScreenCoords.setLeft(m_textVirtualOffset.x);
+            }
 
-    for(int i = 0; i < textLength; ++i) {
-        glyph = (uchar)text[i];
-        m_glyphsCoords[i].clear();
+            // subtract startInternalPos
+            glyphScreenCoords.translate(-m_textVirtualOffset);
 
-        // skip invalid glyphs
-        if(glyph < 32 && glyph != (uchar)'\n')
-            continue;
+            // translate rect to screen coords
+            glyphScreenCoords.translate(textScreenCoords.topLeft());
 
-        // calculate initial glyph rect and texture coords
-        Rect glyphScreenCoords(glyphsPositions[i], glyphsSize[glyph]);
-        Rect glyphTextureCoords = glyphsTextureCoords[glyph];
-
-        // first translate to align position
-        if(m_textAlign & Fw::AlignBottom) {
-            glyphScreenCoords.translate(0, textScreenCoords.height() - textBoxSize.height());
-        } else if(m_textAlign & Fw::AlignVerticalCenter) {
-            glyphScreenCoords.translate(0, (textScreenCoords.height() - textBoxSize.height()) / 2);
-        } else { // AlignTop
-            // nothing to do
-        }
+            // only render if glyph rect is visible on screenCoords
+            if(!textScreenCoords.intersects(glyphScreenCoords))
+                continue;
+
+            // bound glyph bottomRight to screenCoords bottomRight
+            if(glyphScreenCoords.bottom() > textScreenCoords.bottom()) {
+                glyphTextureCoords.setBottom(glyphTextureCoords.bottom() + (textScreenCoords.bottom() - glyphScreenCoords.bottom()));
+                glyphScreenCoords.setBottom(textScreenCoords.bottom());
+            }
+            if(glyphScreenCoords.right() > textScreenCoords.right()) {
+                glyphTextureCoords.setRight(glyphTextureCoords.right() + (textScreenCoords.right() - glyphScreenCoords.right()));
+                glyphScreenCoords.setRight(textScreenCoords.right());
+            }
 
-        if(m_textAlign & Fw::AlignRight) {
-            glyphScreenCoords.translate(textScreenCoords.width() - textBoxSize.width(), 0);
-        } else if(m_textAlign & Fw::AlignHorizontalCenter) {
-            glyphScreenCoords.translate((textScreenCoords.width() - textBoxSize.width()) / 2, 0);
-        } else { // AlignLeft
-            // nothing to do
+            // render glyph
+            m_glyphsCoords[i - firstGlyph] = glyphScreenCoords;
+            m_glyphsTexCoords[i - firstGlyph] = glyphTextureCoords;
         }
+    }
 
-        // only render glyphs that are after startRenderPosition
-        if(glyphScreenCoords.bottom() < m_textVirtualOffset.y || glyphScreenCoords.right() < m_textVirtualOffset.x)
-            continue;
+    if(fireAreaUpdate)
+        onTextAreaUpdate(m_textVirtualOffset, m_textVirtualSize, m_textTotalSize);
 
-        // bound glyph topLeft to startRenderPosition
-        if(glyphScreenCoords.top() < m_textVirtualOffset.y) {
-            glyphTextureCoords.setTop(glyphTextureCoords.top() + (m_textVirtualOffset.y - glyphScreenCoords.top()));
-            glyphScreenCoords.setTop(m_textVirtualOffset.y);
-        }
-        if(glyphScreenCoords.left() < m_textVirtualOffset.x) {
-            glyphTextureCoords.setLeft(glyphTextureCoords.left() + (m_textVirtualOffset.x - glyphScreenCoords.left()));
-            glyphScreenCoords.setLeft(m_textVirtualOffset.x);
-        }
+    repaint();
+    g_app.repaint();
+}
 
-        // subtract startInternalPos
-        glyphScreenCoords.translate(-m_textVirtualOffset);
+void UITextEdit::layoutText()
+{
+    int wrapWidth = (m_textWrap && m_rect.isValid()) ? getPaddingRect().width() - m_textOffset.x : -1;
 
-        // translate rect to screen coords
-        glyphScreenCoords.translate(textScreenCoords.topLeft());
+    // hidden texts are short, they are always laid out from scratch
+    bool relayout = m_lines.empty() || m_layoutFont != m_font || m_layoutWrapWidth != wrapWidth || m_layoutHidden != m_textHidden || m_textHidden;
+    if(!relayout && m_layoutText == m_text)
+        return;
 
-        // only render if glyph rect is visible on screenCoords
-        if(!textScreenCoords.intersects(glyphScreenCoords))
-            continue;
+    if(relayout) {
+        std::string text;
+        if(m_textHidden)
+            text = std::string(m_text.length(), '*');
+        else
+            text = m_text;
+
+        m_paragraphs.clear();
+        if(wrapWidth >= 0) {
+            m_drawText.clear();
+            wrapParagraphs(text, wrapWidth, m_drawText, m_paragraphs);
+        } else
+            m_drawText = text;
+
+        m_lines.clear();
+        layoutLines(0, m_drawText.length(), false, m_lines);
+    } else {
+        // find the edited range, the common prefix and suffix are kept as they are
+        int oldLength = m_layoutText.length();
+        int newLength = m_text.length();
+        int common = std::min<int>(oldLength, newLength);
+        const char *oldText = m_layoutText.data();
+        const char *newText = m_text.data();
+        int prefix = 0;
+        while(prefix + 64 <= common && memcmp(oldText + prefix, newText + prefix, 64) == 0)
+            prefix += 64;
+        while(prefix < common && oldText[prefix] == newText[prefix])
+            ++prefix;
+        int suffix = 0;
+        while(suffix + 64 <= common - prefix && memcmp(oldText + oldLength - suffix - 64, newText + newLength - suffix - 64, 64) == 0)
+            suffix += 64;
+        while(suffix < common - prefix && oldText[oldLength - suffix - 1] == newText[newLength - suffix - 1])
+            ++suffix;
+
+        if(wrapWidth < 0) {
+            m_drawText.replace(prefix, oldLength - suffix - prefix, m_text, prefix, newLength - suffix - prefix);
+            relayoutLines(prefix, oldLength - suffix, newLength - suffix);
+        } else {
+            // paragraphs are wrapped on their own, so only the edited ones are wrapped again
+            int first = 0, textStart = 0, drawStart = 0;
+            while(first + 1 < (int)m_paragraphs.size() && textStart + m_paragraphs[first].first < prefix) {
+                textStart += m_paragraphs[first].first + 1;
+                drawStart += m_paragraphs[first].second + 1;
+                ++first;
+            }
 
-        // bound glyph bottomRight to screenCoords bottomRight
-        if(glyphScreenCoords.bottom() > textScreenCoords.bottom()) {
-            glyphTextureCoords.setBottom(glyphTextureCoords.bottom() + (textScreenCoords.bottom() - glyphScreenCoords.bottom()));
-            glyphScreenCoords.setBottom(textScreenCoords.bottom());
+            int last = first;
+            int textEnd = textStart + m_paragraphs[first].first;
+            int drawEnd = drawStart + m_paragraphs[first].second;
+            while(last + 1 < (int)m_paragraphs.size() && textEnd < oldLength - suffix) {
+                ++last;
+                textEnd += m_paragraphs[last].first + 1;
+                drawEnd += m_paragraphs[last].second + 1;
+            }
+            textEnd += newLength - oldLength;
+
+            std::string wrapped;
+            std::vector<std::pair<int, int>> paragraphs;
+            wrapParagraphs(m_text.substr(textStart, textEnd - textStart), wrapWidth, wrapped, paragraphs);
+            m_paragraphs.erase(m_paragraphs.begin() + first, m_paragraphs.begin() + last + 1);
+            m_paragraphs.insert(m_paragraphs.begin() + first, paragraphs.begin(), paragraphs.end());
+
+            m_drawText.replace(drawStart, drawEnd - drawStart, wrapped);
+            relayoutLines(drawStart, drawEnd, drawStart + wrapped.length());
         }
-        if(glyphScreenCoords.right() > textScreenCoords.right()) {
-            glyphTextureCoords.setRight(glyphTextureCoords.right() + (textScreenCoords.right() - glyphScreenCoords.right()));
-            glyphScreenCoords.setRight(textScreenCoords.right());
+    }
+
+    m_maxLineWidth = 0;
+    for(const TextLine& line : m_lines)
+        m_maxLineWidth = std::max<int>(m_maxLineWidth, line.width);
+
+    m_layoutText = m_text;
+    m_layoutFont = m_font;
+    m_layoutWrapWidth = wrapWidth;
+    m_layoutHidden = m_textHidden;
+}
+
+void UITextEdit::wrapParagraphs(const std::string& text, int wrapWidth, std::string& wrapped, std::vector<std::pair<int, int>>& paragraphs)
+{
+    std::size_t start = 0;
+    while(true) {
+        std::size_t end = text.find('\n', start);
+        if(end == std::string::npos)
+            end = text.length();
+
+        std::string paragraph = m_font->wrapText(text.substr(start, end - start), wrapWidth);
+        paragraphs.push_back(std::make_pair(end - start, paragraph.length()));
+        wrapped += paragraph;
+
+        if(end == text.length())
+            break;
+        wrapped += '\n';
+        start = end + 1;
+    }
+}
+
+void UITextEdit::relayoutLines(int start, int oldEnd, int newEnd)
+{
+    int delta = newEnd - oldEnd;
+    int oldLength = (int)m_drawText.length() - delta;
+
+    // the line before the edit may join it when a line break got removed
+    int firstLine = start > 0 ? getLineAt(start - 1) : 0;
+    int lastLine = oldLength > 0 ? getLineAt(std::min<int>(oldEnd, oldLength - 1)) : (int)m_lines.size() - 1;
+    int begin = m_lines[firstLine].start;
+    int end = (lastLine + 1 < (int)m_lines.size() ? m_lines[lastLine + 1].start : oldLength) + delta;
+
+    std::vector<TextLine> lines;
+    layoutLines(begin, end, firstLine > 0, lines);
+
+    for(int i = lastLine + 1; i < (int)m_lines.size(); ++i)
+        m_lines[i].start += delta;
+    m_lines.erase(m_lines.begin() + firstLine, m_lines.begin() + lastLine + 1);
+    m_lines.insert(m_lines.begin() + firstLine, std::make_move_iterator(lines.begin()), std::make_move_iterator(lines.end()));
+}
+
+void UITextEdit::layoutLines(int begin, int end, bool continued, std::vector<TextLine>& lines)
+{
+    // same placement as BitmapFont::calculateGlyphsPositions, a line break starts the line it belongs to
+    const Size *glyphsSize = m_font->getGlyphsSize();
+    int spacing = m_font->getGlyphSpacing().width();
+
+    TextLine line;
+    line.start = begin;
+    int x = 0;
+    for(int i = begin; i < end; ++i) {
+        uchar glyph = m_drawText[i];
+        if(glyph == (uchar)'\n' && !(continued && i == begin)) {
+            line.width = (i > line.start && (uchar)m_drawText[i - 1] >= 32) ? x - spacing : x;
+            lines.push_back(std::move(line));
+            line = TextLine();
+            line.start = i;
+            x = 0;
         }
 
-        // render glyph
-        m_glyphsCoords[i] = glyphScreenCoords;
-        m_glyphsTexCoords[i] = glyphTextureCoords;
+        line.glyphsX.push_back(x);
+        if(glyph >= 32)
+            x += glyphsSize[glyph].width() + spacing;
     }
+    line.width = (end > line.start && (uchar)m_drawText[end - 1] >= 32) ? x - spacing : x;
+    lines.push_back(std::move(line));
+}
 
-    if(fireAreaUpdate)
-        onTextAreaUpdate(m_textVirtualOffset, m_textVirtualSize, m_textTotalSize);
+int UITextEdit::getLineAt(int pos)
+{
+    auto it = std::upper_bound(m_lines.begin(), m_lines.end(), pos, [](int pos, const TextLine& line) { return pos < line.start; });
+    return std::max<int>(it - m_lines.begin() - 1, 0);
+}
 
-    g_app.repaint();
+int UITextEdit::getLineOffset(const TextLine& line)
+{
+    if(m_textAlign & Fw::AlignRight)
+        return m_maxLineWidth - line.width;
+    else if(m_textAlign & Fw::AlignHorizontalCenter)
+        return (m_maxLineWidth - line.width) / 2;
+    return 0;
+}
+
+Point UITextEdit::getGlyphPosition(int pos)
+{
+    int line = getLineAt(pos);
+    const TextLine& textLine = m_lines[line];
+    int lineHeight = m_font->getGlyphHeight() + m_font->getGlyphSpacing().height();
+    return Point(getLineOffset(textLine) + textLine.glyphsX[pos - textLine.start], m_font->getYOffset() + line * lineHeight);
+}
+
+Rect UITextEdit::getGlyphCoords(int pos)
+{
+    pos -= m_glyphsCoordsStart;
+    if(pos < 0 || pos >= (int)m_glyphsCoords.size())
+        return Rect();
+    return m_glyphsCoords[pos];
 }
 
 void UITextEdit::setCursorPos(int pos)
@@ -364,7 +570,7 @@ void UITextEdit::setSelection(int start, int end)
 
     m_selectionStart = stdext::clamp<int>(start, 0, (int)m_text.length());
     m_selectionEnd = stdext::clamp<int>(end, 0, (int)m_text.length());
-    recacheGlyphs();
+    recacheSelection();
 }
 
 void UITextEdit::setTextHidden(bool hidden)
@@ -455,6 +661,7 @@ void UITextEdit::removeCharacter(bool right)
 void UITextEdit::blinkCursor()
 {
     m_cursorTicks = g_clock.millis();
+    repaint();
     g_app.repaint();
 }
 
@@ -530,8 +737,8 @@ int UITextEdit::getTextPos(Point pos)
     // find any glyph that is actually on the
     int candidatePos = -1;
     Rect firstGlyphRect, lastGlyphRect;
-    for(int i=0;i<textLength;++i) {
-        Rect clickGlyphRect = m_glyphsCoords[i];
+    for(int i=m_glyphsCoordsStart;i<m_glyphsCoordsStart+(int)m_glyphsCoords.size();++i) {
+        Rect clickGlyphRect = m_glyphsCoords[i - m_glyphsCoordsStart];
         if(!clickGlyphRect.isValid())
             continue;
         if(!firstGlyphRect.isValid())
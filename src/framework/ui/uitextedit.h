@@ -39,7 +39,7 @@ private:
 public:
     void setCursorPos(int pos);
     void setSelection(int start, int end);
-    void setCursorVisible(bool enable) { m_cursorVisible = enable; }
+    void setCursorVisible(bool enable) { m_cursorVisible = enable; repaint(); }
     void setChangeCursorImage(bool enable) { m_changeCursorImage = enable; }
     void setTextHidden(bool hidden);
     void setValidCharacters(const std::string validCharacters) { m_validCharacters = validCharacters; }
@@ -49,8 +49,8 @@ public:
     void setTextVirtualOffset(const Point& offset);
     void setEditable(bool editable) { m_editable = editable; }
     void setSelectable(bool selectable) { m_selectable = selectable; }
-    void setSelectionColor(const Color& color) { m_selectionColor = color; }
-    void setSelectionBackgroundColor(const Color& color) { m_selectionBackgroundColor = color; }
+    void setSelectionColor(const Color& color) { m_selectionColor = color; repaint(); }
+    void setSelectionBackgroundColor(const Color& color) { m_selectionBackgroundColor = color; repaint(); }
     void setAutoScroll(bool autoScroll) { m_autoScroll = autoScroll; }
 
     void moveCursorHorizontally(bool right);
@@ -106,9 +106,26 @@ protected:
     virtual void onTextAreaUpdate(const Point& vitualOffset, const Size& virtualSize, const Size& totalSize);
 
 private:
+    // a line of the displayed text, a line break belongs to the line it starts
+    struct TextLine {
+        int start;
+        int width;
+        std::vector<int> glyphsX;
+    };
+
     void disableUpdates() { m_updatesEnabled = false; }
     void enableUpdates() { m_updatesEnabled = true; }
-    void recacheGlyphs() { m_glyphsMustRecache = true; }
+    void recacheGlyphs() { m_glyphsMustRecache = true; repaint(); }
+    void recacheSelection() { m_selectionMustRecache = true; repaint(); }
+
+    void layoutText();
+    void wrapParagraphs(const std::string& text, int wrapWidth, std::string& wrapped, std::vector<std::pair<int, int>>& paragraphs);
+    void relayoutLines(int start, int oldEnd, int newEnd);
+    void layoutLines(int begin, int end, bool continued, std::vector<TextLine>& lines);
+    int getLineAt(int pos);
+    int getLineOffset(const TextLine& line);
+    Point getGlyphPosition(int pos);
+    Rect getGlyphCoords(int pos);
 
     Rect m_drawArea;
     int m_cursorPos;
@@ -136,12 +153,23 @@ private:
     Color m_selectionColor;
     Color m_selectionBackgroundColor;
 
+    std::string m_layoutText;
+    BitmapFontPtr m_layoutFont;
+    int m_layoutWrapWidth;
+    bool m_layoutHidden;
+    std::vector<TextLine> m_lines;
+    std::vector<std::pair<int, int>> m_paragraphs; // text and wrapped length of each paragraph
+    int m_maxLineWidth;
+
+    // coords of the glyphs on the visible lines only
+    int m_glyphsCoordsStart;
     std::vector<Rect> m_glyphsCoords;
     std::vector<Rect> m_glyphsTexCoords;
 
     CoordsBuffer m_glyphsTextCoordsBuffer;
     CoordsBuffer m_glyphsSelectCoordsBuffer;
     bool m_glyphsMustRecache;
+    bool m_selectionMustRecache;
 };
 
 #endif
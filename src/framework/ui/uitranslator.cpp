@@ -21,8 +21,10 @@
  */
 
 #include "uitranslator.h"
+#include <framework/otml/otmlnode.h>
 #include <framework/stdext/string.h>
 #include <boost/algorithm/string.hpp>
+#include <unordered_map>
 
 Fw::AlignmentFlag Fw::translateAlignment(std::string aligment)
 {
@@ -111,3 +113,158 @@ Fw::AutoFocusPolicy Fw::translateAutoFocusPolicy(std::string policy)
         return Fw::AutoFocusLast;
     return Fw::AutoFocusNone;
 }
+
+Fw::StyleProperty Fw::translateStyleProperty(const OTMLNodePtr& node)
+{
+    static const std::unordered_map<std::string, Fw::StyleProperty> properties = {
+        { "color", Fw::StyleColor },
+        { "x", Fw::StyleX },
+        { "y", Fw::StyleY },
+        { "pos", Fw::StylePos },
+        { "width", Fw::StyleWidth },
+        { "height", Fw::StyleHeight },
+        { "rect", Fw::StyleRect },
+        { "background", Fw::StyleBackground },
+        { "background-color", Fw::StyleBackgroundColor },
+        { "background-offset-x", Fw::StyleBackgroundOffsetX },
+        { "background-offset-y", Fw::StyleBackgroundOffsetY },
+        { "background-offset", Fw::StyleBackgroundOffset },
+        { "background-width", Fw::StyleBackgroundWidth },
+        { "background-height", Fw::StyleBackgroundHeight },
+        { "background-size", Fw::StyleBackgroundSize },
+        { "background-rect", Fw::StyleBackgroundRect },
+        { "icon", Fw::StyleIcon },
+        { "icon-source", Fw::StyleIconSource },
+        { "icon-color", Fw::StyleIconColor },
+        { "icon-offset-x", Fw::StyleIconOffsetX },
+        { "icon-offset-y", Fw::StyleIconOffsetY },
+        { "icon-offset", Fw::StyleIconOffset },
+        { "icon-width", Fw::StyleIconWidth },
+        { "icon-height", Fw::StyleIconHeight },
+        { "icon-size", Fw::StyleIconSize },
+        { "icon-rect", Fw::StyleIconRect },
+        { "icon-clip", Fw::StyleIconClip },
+        { "icon-align", Fw::StyleIconAlign },
+        { "opacity", Fw::StyleOpacity },
+        { "rotation", Fw::StyleRotation },
+        { "enabled", Fw::StyleEnabled },
+        { "visible", Fw::StyleVisible },
+        { "checked", Fw::StyleChecked },
+        { "draggable", Fw::StyleDraggable },
+        { "on", Fw::StyleOn },
+        { "focusable", Fw::StyleFocusable },
+        { "auto-focus", Fw::StyleAutoFocus },
+        { "phantom", Fw::StylePhantom },
+        { "size", Fw::StyleSize },
+        { "fixed-size", Fw::StyleFixedSize },
+        { "clipping", Fw::StyleClipping },
+        { "render-layer", Fw::StyleRenderLayer },
+        { "border", Fw::StyleBorder },
+        { "border-width", Fw::StyleBorderWidth },
+        { "border-width-top", Fw::StyleBorderWidthTop },
+        { "border-width-right", Fw::StyleBorderWidthRight },
+        { "border-width-bottom", Fw::StyleBorderWidthBottom },
+        { "border-width-left", Fw::StyleBorderWidthLeft },
+        { "border-color", Fw::StyleBorderColor },
+        { "border-color-top", Fw::StyleBorderColorTop },
+        { "border-color-right", Fw::StyleBorderColorRight },
+        { "border-color-bottom", Fw::StyleBorderColorBottom },
+        { "border-color-left", Fw::StyleBorderColorLeft },
+        { "margin-top", Fw::StyleMarginTop },
+        { "margin-right", Fw::StyleMarginRight },
+        { "margin-bottom", Fw::StyleMarginBottom },
+        { "margin-left", Fw::StyleMarginLeft },
+        { "margin", Fw::StyleMargin },
+        { "padding-top", Fw::StylePaddingTop },
+        { "padding-right", Fw::StylePaddingRight },
+        { "padding-bottom", Fw::StylePaddingBottom },
+        { "padding-left", Fw::StylePaddingLeft },
+        { "padding", Fw::StylePadding },
+        { "layout", Fw::StyleLayout },
+        { "image-source", Fw::StyleImageSource },
+        { "image-offset-x", Fw::StyleImageOffsetX },
+        { "image-offset-y", Fw::StyleImageOffsetY },
+        { "image-offset", Fw::StyleImageOffset },
+        { "image-width", Fw::StyleImageWidth },
+        { "image-height", Fw::StyleImageHeight },
+        { "image-size", Fw::StyleImageSize },
+        { "image-rect", Fw::StyleImageRect },
+        { "image-clip", Fw::StyleImageClip },
+        { "image-fixed-ratio", Fw::StyleImageFixedRatio },
+        { "image-repeated", Fw::StyleImageRepeated },
+        { "image-smooth", Fw::StyleImageSmooth },
+        { "image-color", Fw::StyleImageColor },
+        { "image-border-top", Fw::StyleImageBorderTop },
+        { "image-border-right", Fw::StyleImageBorderRight },
+        { "image-border-bottom", Fw::StyleImageBorderBottom },
+        { "image-border-left", Fw::StyleImageBorderLeft },
+        { "image-border", Fw::StyleImageBorder },
+        { "image-auto-resize", Fw::StyleImageAutoResize },
+        { "text", Fw::StyleText },
+        { "text-align", Fw::StyleTextAlign },
+        { "text-offset", Fw::StyleTextOffset },
+        { "text-wrap", Fw::StyleTextWrap },
+        { "text-auto-resize", Fw::StyleTextAutoResize },
+        { "text-horizontal-auto-resize", Fw::StyleTextHorizontalAutoResize },
+        { "text-vertical-auto-resize", Fw::StyleTextVerticalAutoResize },
+        { "text-only-upper-case", Fw::StyleTextOnlyUpperCase },
+        { "font", Fw::StyleFont },
+    };
+    // tags are interned, so each distinct tag is translated only once
+    static std::unordered_map<const std::string*, Fw::StyleProperty> cache;
+
+    const std::string& tag = node->tag();
+    auto it = cache.find(&tag);
+    if(it != cache.end())
+        return it->second;
+
+    Fw::StyleProperty property = Fw::StyleUnknown;
+    auto pit = properties.find(tag);
+    if(pit != properties.end())
+        property = pit->second;
+    else if(stdext::starts_with(tag, "anchors."))
+        property = Fw::StyleAnchor;
+    cache[&tag] = property;
+    return property;
+}
+
+bool Fw::translateStateSelector(const OTMLNodePtr& node, int& states, int& excludedStates)
+{
+    struct StateSelector {
+        int states;
+        int excludedStates;
+    };
+    static std::unordered_map<const std::string*, StateSelector> cache;
+
+    const std::string& tag = node->tag();
+    if(tag.empty() || tag[0] != '$')
+        return false;
+
+    auto it = cache.find(&tag);
+    if(it == cache.end()) {
+        StateSelector selector = { 0, 0 };
+        for(std::string stateStr : stdext::split(tag.substr(1), " ")) {
+            if(stateStr.length() == 0)
+                continue;
+
+            bool notstate = (stateStr[0] == '!');
+            if(notstate)
+                stateStr = stateStr.substr(1);
+
+            Fw::WidgetState state = Fw::translateState(stateStr);
+            if(state == Fw::InvalidState) {
+                // an unknown state is never on, so only requiring it can fail the match
+                if(!notstate)
+                    selector.states |= Fw::LastWidgetState;
+            } else if(notstate)
+                selector.excludedStates |= state;
+            else
+                selector.states |= state;
+        }
+        it = cache.insert(std::make_pair(&tag, selector)).first;
+    }
+
+    states = it->second.states;
+    excludedStates = it->second.excludedStates;
+    return true;
+}
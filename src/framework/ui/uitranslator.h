@@ -24,6 +24,7 @@
 #define TRANSLATOR_H
 
 #include "../const.h"
+#include "../otml/declarations.h"
 #include <string>
 
 namespace Fw {
@@ -33,6 +34,12 @@ AnchorEdge translateAnchorEdge(std::string anchorEdge);
 WidgetState translateState(std::string state);
 AutoFocusPolicy translateAutoFocusPolicy(std::string policy);
 
+/// Returns the style property of a node, looked up by its interned tag
+StyleProperty translateStyleProperty(const OTMLNodePtr& node);
+/// Translates a "$state !state" selector tag into the states it requires and excludes,
+/// returns false when the node is not a state selector
+bool translateStateSelector(const OTMLNodePtr& node, int& states, int& excludedStates);
+
 };
 
 #endif
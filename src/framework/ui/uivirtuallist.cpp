@@ -0,0 +1,353 @@
+/*
+ * Copyright (c) 2010-2017 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "uivirtuallist.h"
+#include "uimanager.h"
+#include <framework/otml/otml.h>
+
+UIVirtualList::UIVirtualList()
+{
+    m_itemCount = 0;
+    m_rowHeight = 0;
+    m_columns = 1;
+    m_scrollOffset = 0;
+    m_scrollStep = 0;
+    setClipping(true);
+}
+
+void UIVirtualList::setItemCount(int count)
+{
+    count = std::max<int>(count, 0);
+    if(count == m_itemCount)
+        return;
+
+    bool atMaximum = m_scrollOffset >= getMaxScrollOffset();
+    m_itemCount = count;
+
+    int maxOffset = getMaxScrollOffset();
+    if(m_alwaysScrollMaximum && atMaximum)
+        m_scrollOffset = maxOffset;
+    else
+        m_scrollOffset = std::min<int>(m_scrollOffset, maxOffset);
+
+    // rows still bound to valid indexes are kept, use refresh() when existing items changed
+    updateRows();
+}
+
+void UIVirtualList::setRowStyle(const std::string& rowStyle)
+{
+    if(m_rowStyle == rowStyle)
+        return;
+
+    clearPool();
+    m_rowStyle = rowStyle;
+    updateRows();
+}
+
+void UIVirtualList::setRowHeight(int rowHeight)
+{
+    if(m_rowHeight == rowHeight)
+        return;
+
+    m_rowHeight = rowHeight;
+    m_scrollOffset = std::min<int>(m_scrollOffset, getMaxScrollOffset());
+    updateRows();
+}
+
+void UIVirtualList::setColumns(int columns)
+{
+    columns = std::max<int>(columns, 1);
+    if(m_columns == columns)
+        return;
+
+    m_columns = columns;
+    m_scrollOffset = std::min<int>(m_scrollOffset, getMaxScrollOffset());
+    updateRows();
+}
+
+void UIVirtualList::setScrollOffset(int offset)
+{
+    offset = std::max<int>(std::min<int>(offset, getMaxScrollOffset()), 0);
+    if(offset == m_scrollOffset)
+        return;
+
+    m_scrollOffset = offset;
+    updateRows();
+}
+
+void UIVirtualList::ensureIndexVisible(int index)
+{
+    if(index < 1 || index > m_itemCount || m_rowHeight <= 0)
+        return;
+
+    int top = ((index - 1) / m_columns) * m_rowHeight;
+    int viewHeight = getPaddingRect().height();
+    if(top < m_scrollOffset)
+        setScrollOffset(top);
+    else if(top + m_rowHeight > m_scrollOffset + viewHeight)
+        setScrollOffset(top + m_rowHeight - viewHeight);
+}
+
+void UIVirtualList::refreshIndex(int index)
+{
+    if(UIWidgetPtr row = getRowWidget(index))
+        onRowBind(row, index);
+}
+
+UIWidgetPtr UIVirtualList::getRowWidget(int index)
+{
+    if(index < 1)
+        return nullptr;
+
+    for(uint i = 0; i < m_rows.size(); ++i) {
+        if(m_rowIndexes[i] == index)
+            return m_rows[i];
+    }
+    return nullptr;
+}
+
+int UIVirtualList::getRowIndex(const UIWidgetPtr& row)
+{
+    for(uint i = 0; i < m_rows.size(); ++i) {
+        if(m_rows[i] == row)
+            return m_rowIndexes[i];
+    }
+    return 0;
+}
+
+int UIVirtualList::getFirstVisibleIndex()
+{
+    if(m_itemCount <= 0 || m_rowHeight <= 0)
+        return 0;
+    return (m_scrollOffset / m_rowHeight) * m_columns + 1;
+}
+
+int UIVirtualList::getLastVisibleIndex()
+{
+    if(m_itemCount <= 0 || m_rowHeight <= 0)
+        return 0;
+    int viewHeight = std::max<int>(getPaddingRect().height(), 1);
+    return std::min<int>(((m_scrollOffset + viewHeight - 1) / m_rowHeight + 1) * m_columns, m_itemCount);
+}
+
+int UIVirtualList::getMaxScrollOffset()
+{
+    if(m_rowHeight <= 0)
+        return 0;
+    int lines = (m_itemCount + m_columns - 1) / m_columns;
+    return std::max<int>(lines * m_rowHeight - getPaddingRect().height(), 0);
+}
+
+void UIVirtualList::updatePool()
+{
+    if(m_rowStyle.empty())
+        return;
+
+    // enough rows to cover the viewport plus the partially visible lines at both edges
+    int capacity = 1;
+    if(m_rowHeight > 0)
+        capacity = (std::max<int>(getPaddingRect().height(), 0) / m_rowHeight + 2) * m_columns;
+
+    while((int)m_rows.size() > capacity) {
+        m_rows.back()->destroy();
+        m_rows.pop_back();
+        m_rowIndexes.pop_back();
+    }
+
+    UIWidgetPtr self = static_self_cast<UIWidget>();
+    while((int)m_rows.size() < std::min<int>(capacity, m_itemCount)) {
+        UIWidgetPtr row = g_ui.createWidget(m_rowStyle, self);
+        if(!row) {
+            // the error was already reported, do not keep trying every update
+            m_rowStyle.clear();
+            return;
+        }
+
+        row->setVisible(false);
+        m_rows.push_back(row);
+        m_rowIndexes.push_back(0);
+
+        // without an explicit row height the first row tells it
+        if(m_rowHeight <= 0) {
+            m_rowHeight = std::max<int>(row->getHeight(), 1);
+            capacity = (std::max<int>(getPaddingRect().height(), 0) / m_rowHeight + 2) * m_columns;
+        }
+
+        onRowCreate(row);
+    }
+}
+
+void UIVirtualList::updateRows(bool rebind)
+{
+    if(m_destroyed)
+        return;
+
+    if(rebind)
+        m_rebindRows = true;
+
+    // data source callbacks may change the list again, that is solved right after
+    if(m_updatingRows) {
+        m_rowsDirty = true;
+        return;
+    }
+
+    m_updatingRows = true;
+    for(int pass = 0; pass < 4; ++pass) {
+        m_rowsDirty = false;
+        rebind = m_rebindRows;
+        m_rebindRows = false;
+
+        updatePool();
+
+        std::vector<std::pair<UIWidgetPtr, int>> binds;
+        if(m_rowHeight > 0) {
+            Rect area = getPaddingRect();
+            int columnWidth = area.width() / m_columns;
+            int firstLine = m_scrollOffset / m_rowHeight;
+            int first = firstLine * m_columns + 1;
+            int visible = std::min<int>(m_rows.size(), std::max<int>(m_itemCount - first + 1, 0));
+
+            // rows already showing a visible index keep it, everything else gets recycled
+            std::vector<int> slots(visible, -1);
+            for(uint i = 0; i < m_rows.size(); ++i) {
+                int index = m_rowIndexes[i];
+                if(!rebind && index >= first && index < first + visible && slots[index - first] == -1)
+                    slots[index - first] = i;
+                else
+                    m_rowIndexes[i] = 0;
+            }
+
+            uint freeRow = 0;
+            for(int k = 0; k < visible; ++k) {
+                bool bind = false;
+                if(slots[k] == -1) {
+                    while(m_rowIndexes[freeRow] != 0)
+                        ++freeRow;
+                    slots[k] = freeRow;
+                    m_rowIndexes[freeRow] = first + k;
+                    bind = true;
+                }
+
+                const UIWidgetPtr& row = m_rows[slots[k]];
+                int line = firstLine + k / m_columns;
+                int column = k % m_columns;
+
+                // shown before placed, showing binds unanchored widgets to the parent rect
+                row->setVisible(true);
+                row->setRect(Rect(area.left() + column * columnWidth, area.top() + line * m_rowHeight - m_scrollOffset, columnWidth, m_rowHeight));
+                if(bind)
+                    binds.push_back(std::make_pair(row, first + k));
+            }
+        }
+
+        for(uint i = 0; i < m_rows.size(); ++i) {
+            if(m_rowIndexes[i] == 0)
+                m_rows[i]->setVisible(false);
+        }
+
+        for(const auto& it : binds)
+            onRowBind(it.first, it.second);
+
+        if(!m_rowsDirty || m_destroyed)
+            break;
+    }
+    m_updatingRows = false;
+
+    if(!m_destroyed)
+        onListAreaUpdate(m_scrollOffset, getMaxScrollOffset());
+}
+
+void UIVirtualList::clearPool()
+{
+    for(const UIWidgetPtr& row : m_rows)
+        row->destroy();
+    m_rows.clear();
+    m_rowIndexes.clear();
+}
+
+void UIVirtualList::onStyleApply(const std::string& styleName, const OTMLNodePtr& styleNode)
+{
+    UIWidget::onStyleApply(styleName, styleNode);
+
+    for(const OTMLNodePtr& node : styleNode->children()) {
+        if(node->tag() == "row-height")
+            setRowHeight(node->value<int>());
+        else if(node->tag() == "columns")
+            setColumns(node->value<int>());
+        else if(node->tag() == "scroll-step")
+            setScrollStep(node->value<int>());
+        else if(node->tag() == "always-scroll-maximum")
+            setAlwaysScrollMaximum(node->value<bool>());
+        else if(node->tag() == "row-style")
+            setRowStyle(node->value());
+    }
+}
+
+void UIVirtualList::onGeometryChange(const Rect& oldRect, const Rect& newRect)
+{
+    UIWidget::onGeometryChange(oldRect, newRect);
+
+    // keep sticking to the bottom when the viewport got resized
+    if(m_rowHeight > 0) {
+        int lines = (m_itemCount + m_columns - 1) / m_columns;
+        int oldViewHeight = oldRect.height() - m_padding.top - m_padding.bottom;
+        bool atMaximum = m_scrollOffset >= std::max<int>(lines * m_rowHeight - oldViewHeight, 0);
+        if(m_alwaysScrollMaximum && atMaximum)
+            m_scrollOffset = getMaxScrollOffset();
+        else
+            m_scrollOffset = std::min<int>(m_scrollOffset, getMaxScrollOffset());
+    }
+
+    updateRows();
+}
+
+bool UIVirtualList::onMouseWheel(const Point& mousePos, Fw::MouseWheelDirection direction)
+{
+    if(UIWidget::onMouseWheel(mousePos, direction))
+        return true;
+
+    int step = getScrollStep();
+    int offset = m_scrollOffset + (direction == Fw::MouseWheelUp ? -step : step);
+    offset = std::max<int>(std::min<int>(offset, getMaxScrollOffset()), 0);
+
+    // let the parent scroll when there is nothing left to scroll here
+    if(offset == m_scrollOffset)
+        return false;
+
+    setScrollOffset(offset);
+    return true;
+}
+
+void UIVirtualList::onRowCreate(const UIWidgetPtr& row)
+{
+    callLuaField("onRowCreate", row);
+}
+
+void UIVirtualList::onRowBind(const UIWidgetPtr& row, int index)
+{
+    callLuaField("onRowBind", row, index);
+}
+
+void UIVirtualList::onListAreaUpdate(int scrollOffset, int maxScrollOffset)
+{
+    callLuaField("onListAreaUpdate", scrollOffset, maxScrollOffset);
+}
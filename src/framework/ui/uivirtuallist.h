@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2010-2017 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef UIVIRTUALLIST_H
+#define UIVIRTUALLIST_H
+
+#include "uiwidget.h"
+
+// @bindclass
+class UIVirtualList : public UIWidget
+{
+public:
+    UIVirtualList();
+
+    void setItemCount(int count);
+    void setRowStyle(const std::string& rowStyle);
+    void setRowHeight(int rowHeight);
+    void setColumns(int columns);
+    void setScrollOffset(int offset);
+    void setScrollStep(int step) { m_scrollStep = step; }
+    void setAlwaysScrollMaximum(bool enable) { m_alwaysScrollMaximum = enable; }
+
+    void ensureIndexVisible(int index);
+    void refresh() { updateRows(true); }
+    void refreshIndex(int index);
+
+    UIWidgetPtr getRowWidget(int index);
+    int getRowIndex(const UIWidgetPtr& row);
+    int getFirstVisibleIndex();
+    int getLastVisibleIndex();
+    int getMaxScrollOffset();
+    int getItemCount() { return m_itemCount; }
+    std::string getRowStyle() { return m_rowStyle; }
+    int getRowHeight() { return m_rowHeight; }
+    int getColumns() { return m_columns; }
+    int getScrollOffset() { return m_scrollOffset; }
+    int getScrollStep() { return m_scrollStep > 0 ? m_scrollStep : m_rowHeight; }
+    int getPoolSize() { return m_rows.size(); }
+    bool isAlwaysScrollMaximum() { return m_alwaysScrollMaximum; }
+
+protected:
+    virtual void onStyleApply(const std::string& styleName, const OTMLNodePtr& styleNode);
+    virtual void onGeometryChange(const Rect& oldRect, const Rect& newRect);
+    virtual bool onMouseWheel(const Point& mousePos, Fw::MouseWheelDirection direction);
+    virtual void onRowCreate(const UIWidgetPtr& row);
+    virtual void onRowBind(const UIWidgetPtr& row, int index);
+    virtual void onListAreaUpdate(int scrollOffset, int maxScrollOffset);
+
+private:
+    void updatePool();
+    void updateRows(bool rebind = false);
+    void clearPool();
+
+    std::string m_rowStyle;
+    std::vector<UIWidgetPtr> m_rows;
+    std::vector<int> m_rowIndexes; // item index bound to each pooled row, 0 when unbound
+    int m_itemCount;
+    int m_rowHeight;
+    int m_columns;
+    int m_scrollOffset;
+    int m_scrollStep;
+    stdext::boolean<false> m_alwaysScrollMaximum;
+    stdext::boolean<false> m_updatingRows;
+    stdext::boolean<false> m_rowsDirty;
+    stdext::boolean<false> m_rebindRows;
+};
+
+#endif
@@ -24,12 +24,14 @@
 #include "uimanager.h"
 #include "uianchorlayout.h"
 #include "uitranslator.h"
+#include "uicompiledstyle.h"
 
 #include <framework/core/eventdispatcher.h>
 #include <framework/otml/otmlnode.h>
 #include <framework/graphics/graphics.h>
 #include <framework/platform/platformwindow.h>
 #include <framework/graphics/texturemanager.h>
+#include <framework/graphics/framebuffermanager.h>
 #include <framework/core/application.h>
 #include <framework/luaengine/luainterface.h>
 
@@ -40,6 +42,9 @@ UIWidget::UIWidget()
     m_autoFocusPolicy = Fw::AutoFocusLast;
     m_clickTimer.stop();
     m_autoRepeatDelay = 500;
+    m_layerOpacity = 1.0f;
+    m_layerRedraws = 0;
+    m_appliedStateBlocks = 0;
 
     initBaseStyle();
     initText();
@@ -56,6 +61,24 @@ UIWidget::~UIWidget()
 }
 
 void UIWidget::draw(const Rect& visibleRect, Fw::DrawPane drawPane)
+{
+    // layered widgets keep their foreground in an offscreen buffer that is only redrawn when dirty
+    if(m_renderLayer && drawPane == Fw::ForegroundPane && m_rotation == 0.0f && m_rect.isValid() &&
+       g_graphics.canUseFBO() && g_graphics.canUseBlendFuncSeparate()) {
+        if(!m_layerBypassed) {
+            drawLayer(visibleRect);
+            return;
+        }
+
+        // a descendant draws every frame, so draw directly; it bypasses the layer again if still drawn
+        m_layerBypassed = false;
+        m_layerDirty = true;
+    }
+
+    drawContents(visibleRect, drawPane);
+}
+
+void UIWidget::drawContents(const Rect& visibleRect, Fw::DrawPane drawPane)
 {
     Rect oldClipRect;
     if(m_clipping) {
@@ -85,6 +108,61 @@ void UIWidget::draw(const Rect& visibleRect, Fw::DrawPane drawPane)
     }
 }
 
+void UIWidget::drawLayer(const Rect& visibleRect)
+{
+    if(!m_layer) {
+        m_layer = g_framebuffers.createFrameBuffer();
+        m_layer->setSmooth(false);
+        m_layerDirty = true;
+    }
+
+    if(!m_layer->getTexture() || m_layer->getSize() != m_rect.size()) {
+        m_layer->resize(m_rect.size());
+        m_layerDirty = true;
+    }
+
+    // the opacity is baked into the layer, so descendants clamp to it exactly like the direct path
+    float opacity = g_painter->getOpacity();
+    if(opacity != m_layerOpacity) {
+        m_layerOpacity = opacity;
+        m_layerDirty = true;
+    }
+
+    if(m_layerDirty) {
+        // cleared before drawing, so widgets animating in drawSelf can dirty it again for the next frame
+        m_layerDirty = false;
+
+        m_layer->bind();
+        g_painter->setAlphaWriting(true);
+        g_painter->clear(Color::alpha);
+        g_painter->setDrawOrigin(m_rect.topLeft());
+        g_painter->setOpacity(opacity);
+        drawContents(m_rect, Fw::ForegroundPane);
+        m_layer->release();
+
+        m_layerRedraws++;
+        g_ui.onLayerRedraw();
+    }
+
+    // blending into the cleared layer leaves premultiplied colors, blend them only once more
+    g_painter->setColor(Color::white);
+    g_painter->setOpacity(1.0f);
+    g_painter->setCompositionMode(Painter::CompositionMode_Premultiplied);
+    m_layer->draw(visibleRect, visibleRect.translated(-m_rect.topLeft()));
+    g_painter->resetCompositionMode();
+    g_painter->setOpacity(opacity);
+    g_ui.onLayerBlit();
+}
+
+void UIWidget::releaseLayer()
+{
+    if(!m_layer)
+        return;
+    g_framebuffers.destroyFrameBuffer(m_layer);
+    m_layer = nullptr;
+    m_layerDirty = true;
+}
+
 void UIWidget::drawSelf(Fw::DrawPane drawPane)
 {
     if((drawPane & Fw::ForegroundPane) == 0)
@@ -173,6 +251,8 @@ void UIWidget::addChild(const UIWidgetPtr& child)
         oldLastChild->updateState(Fw::LastState);
     }
 
+    repaint();
+    g_ui.onWidgetHitAreaChange();
     g_ui.onWidgetAppear(child);
 }
 
@@ -211,6 +291,8 @@ void UIWidget::insertChild(int index, const UIWidgetPtr& child)
     child->updateStates();
     updateChildrenIndexStates();
 
+    repaint();
+    g_ui.onWidgetHitAreaChange();
     g_ui.onWidgetAppear(child);
 }
 
@@ -244,6 +326,8 @@ void UIWidget::removeChild(UIWidgetPtr child)
         if(m_autoFocusPolicy != Fw::AutoFocusNone && focusAnother && !m_focusedChild)
             focusPreviousChild(Fw::ActiveFocusReason, true);
 
+        repaint();
+        g_ui.onWidgetHitAreaChange();
         g_ui.onWidgetDisappear(child);
     } else
         g_logger.traceError("attempt to remove an unknown child from a UIWidget");
@@ -389,6 +473,8 @@ void UIWidget::lowerChild(UIWidgetPtr child)
     m_children.erase(it);
     m_children.push_front(child);
     updateChildrenIndexStates();
+    repaint();
+    g_ui.onWidgetHitAreaChange();
 }
 
 void UIWidget::raiseChild(UIWidgetPtr child)
@@ -408,6 +494,8 @@ void UIWidget::raiseChild(UIWidgetPtr child)
     m_children.erase(it);
     m_children.push_back(child);
     updateChildrenIndexStates();
+    repaint();
+    g_ui.onWidgetHitAreaChange();
 }
 
 void UIWidget::moveChildToIndex(const UIWidgetPtr& child, int index)
@@ -433,6 +521,8 @@ void UIWidget::moveChildToIndex(const UIWidgetPtr& child, int index)
     m_children.insert(m_children.begin() + index - 1, child);
     updateChildrenIndexStates();
     updateLayout();
+    repaint();
+    g_ui.onWidgetHitAreaChange();
 }
 
 void UIWidget::lockChild(const UIWidgetPtr& child)
@@ -531,6 +621,11 @@ void UIWidget::applyStyle(const OTMLNodePtr& styleNode)
     if(styleNode->size() == 0)
         return;
 
+    // anchors declared by the style are solved together once the style got applied
+    UILayoutPtr parentLayout = m_parent ? m_parent->getLayout() : nullptr;
+    if(parentLayout)
+        parentLayout->disableUpdates();
+
     m_loadingStyle = true;
     try {
         // translate ! style tags
@@ -548,6 +643,14 @@ void UIWidget::applyStyle(const OTMLNodePtr& styleNode)
         }
 
         onStyleApply(styleNode->tag(), styleNode);
+
+        if(parentLayout) {
+            parentLayout->enableUpdates();
+            if(parentLayout->isUpdatePending() && !parentLayout->isUpdateDisabled())
+                parentLayout->update();
+            parentLayout = nullptr;
+        }
+
         callLuaField("onStyleApply", styleNode->tag(), styleNode);
 
         if(m_firstOnStyle) {
@@ -564,6 +667,12 @@ void UIWidget::applyStyle(const OTMLNodePtr& styleNode)
         g_logger.traceError(stdext::format("failed to apply style to widget '%s': %s", m_id, e.what()));
     }
     m_loadingStyle = false;
+
+    if(parentLayout) {
+        parentLayout->enableUpdates();
+        if(parentLayout->isUpdatePending() && !parentLayout->isUpdateDisabled())
+            parentLayout->update();
+    }
 }
 
 void UIWidget::addAnchor(Fw::AnchorEdge anchoredEdge, const std::string& hookedWidgetId, Fw::AnchorEdge hookedEdge)
@@ -587,10 +696,9 @@ void UIWidget::centerIn(const std::string& hookedWidgetId)
     if(m_destroyed)
         return;
 
-    if(UIAnchorLayoutPtr anchorLayout = getAnchoredLayout()) {
-        anchorLayout->addAnchor(static_self_cast<UIWidget>(), Fw::AnchorHorizontalCenter, hookedWidgetId, Fw::AnchorHorizontalCenter);
-        anchorLayout->addAnchor(static_self_cast<UIWidget>(), Fw::AnchorVerticalCenter, hookedWidgetId, Fw::AnchorVerticalCenter);
-    } else
+    if(UIAnchorLayoutPtr anchorLayout = getAnchoredLayout())
+        anchorLayout->centerIn(static_self_cast<UIWidget>(), hookedWidgetId);
+    else
         g_logger.traceError(stdext::format("cannot add anchors to widget '%s': the parent doesn't use anchors layout", m_id));
 }
 
@@ -599,12 +707,9 @@ void UIWidget::fill(const std::string& hookedWidgetId)
     if(m_destroyed)
         return;
 
-    if(UIAnchorLayoutPtr anchorLayout = getAnchoredLayout()) {
-        anchorLayout->addAnchor(static_self_cast<UIWidget>(), Fw::AnchorLeft, hookedWidgetId, Fw::AnchorLeft);
-        anchorLayout->addAnchor(static_self_cast<UIWidget>(), Fw::AnchorRight, hookedWidgetId, Fw::AnchorRight);
-        anchorLayout->addAnchor(static_self_cast<UIWidget>(), Fw::AnchorTop, hookedWidgetId, Fw::AnchorTop);
-        anchorLayout->addAnchor(static_self_cast<UIWidget>(), Fw::AnchorBottom, hookedWidgetId, Fw::AnchorBottom);
-    } else
+    if(UIAnchorLayoutPtr anchorLayout = getAnchoredLayout())
+        anchorLayout->fill(static_self_cast<UIWidget>(), hookedWidgetId);
+    else
         g_logger.traceError(stdext::format("cannot add anchors to widget '%s': the parent doesn't use anchors layout", m_id));
 }
 
@@ -636,6 +741,9 @@ void UIWidget::updateLayout()
     if(m_layout)
         m_layout->update();
 
+    // padding and size changes move the area children can be hit in
+    g_ui.onWidgetHitAreaChange();
+
     // children can affect the parent layout
     if(UIWidgetPtr parent = getParent())
         if(UILayoutPtr parentLayout = parent->getLayout())
@@ -749,6 +857,8 @@ void UIWidget::bindRectToParent()
 
 void UIWidget::internalDestroy()
 {
+    releaseLayer();
+    g_ui.onWidgetHitAreaChange();
     m_destroyed = true;
     m_visible = false;
     m_enabled = false;
@@ -786,6 +896,24 @@ void UIWidget::destroy()
     internalDestroy();
 }
 
+void UIWidget::repaint()
+{
+    // every layer containing this widget must be redrawn
+    for(UIWidget *widget = this; widget; widget = widget->m_parent.get()) {
+        if(widget->m_renderLayer)
+            widget->m_layerDirty = true;
+    }
+}
+
+void UIWidget::bypassLayers()
+{
+    // widgets drawing every frame would redraw their layers every frame, so layers draw them directly
+    for(UIWidget *widget = m_parent.get(); widget; widget = widget->m_parent.get()) {
+        if(widget->m_renderLayer)
+            widget->m_layerBypassed = true;
+    }
+}
+
 void UIWidget::destroyChildren()
 {
     UILayoutPtr layout = getLayout();
@@ -881,6 +1009,7 @@ bool UIWidget::setRect(const Rect& rect)
         return false;
 
     m_rect = rect;
+    repaint();
 
     // updates own layout
     updateLayout();
@@ -910,16 +1039,21 @@ void UIWidget::setStyle(const std::string& styleName)
         g_logger.traceError(stdext::format("unable to retrieve style '%s': not a defined style", styleName));
         return;
     }
-    styleNode = styleNode->clone();
-    applyStyle(styleNode);
-    m_style = styleNode;
-    updateStyle();
+    setStyleNode(styleNode->clone(), g_ui.getCompiledStyle(styleName));
 }
 
 void UIWidget::setStyleFromNode(const OTMLNodePtr& styleNode)
+{
+    // arbitrary nodes get their states compiled on the first update
+    setStyleNode(styleNode, nullptr);
+}
+
+void UIWidget::setStyleNode(const OTMLNodePtr& styleNode, const UICompiledStylePtr& compiledStyle)
 {
     applyStyle(styleNode);
     m_style = styleNode;
+    m_compiledStyle = compiledStyle;
+    m_appliedStateBlocks = 0;
     updateStyle();
 }
 
@@ -937,6 +1071,8 @@ void UIWidget::setVisible(bool visible)
 {
     if(m_visible != visible) {
         m_visible = visible;
+        repaint();
+        g_ui.onWidgetHitAreaChange();
 
         // hiding a widget make it lose focus
         if(!visible && isFocused()) {
@@ -988,6 +1124,7 @@ void UIWidget::setFocusable(bool focusable)
 void UIWidget::setPhantom(bool phantom)
 {
     m_phantom = phantom;
+    g_ui.onWidgetHitAreaChange();
 }
 
 void UIWidget::setDraggable(bool draggable)
@@ -1018,6 +1155,17 @@ void UIWidget::setVirtualOffset(const Point& offset)
         m_layout->update();
 }
 
+void UIWidget::setRenderLayer(bool enable)
+{
+    if(m_renderLayer == enable)
+        return;
+
+    m_renderLayer = enable;
+    if(!enable)
+        releaseLayer();
+    repaint();
+}
+
 bool UIWidget::isAnchored()
 {
     if(UIWidgetPtr parent = getParent())
@@ -1415,6 +1563,17 @@ void UIWidget::updateStyle()
     if(!m_style)
         return;
 
+    if(!m_compiledStyle)
+        m_compiledStyle = UICompiledStylePtr(new UICompiledStyle(m_style));
+
+    if(m_compiledStyle->isCacheable()) {
+        OTMLNodePtr newStateStyle = m_compiledStyle->getStateStyle(m_states, m_appliedStateBlocks);
+        applyStyle(newStateStyle);
+        m_stateStyle = newStateStyle;
+        return;
+    }
+
+    // styles with too many state blocks to track are merged on every update
     OTMLNodePtr newStateStyle = OTMLNode::create();
 
     // copy only the changed styles from default style
@@ -1425,31 +1584,15 @@ void UIWidget::updateStyle()
         }
     }
 
-    // checks for states combination
+    // checks for states combination, selectors are translated once per distinct tag
     for(const OTMLNodePtr& style : m_style->children()) {
-        if(stdext::starts_with(style->tag(), "$")) {
-            std::string statesStr = style->tag().substr(1);
-            std::vector<std::string> statesSplit = stdext::split(statesStr, " ");
-
-            bool match = true;
-            for(std::string stateStr : statesSplit) {
-                if(stateStr.length() == 0)
-                    continue;
-
-                bool notstate = (stateStr[0] == '!');
-                if(notstate)
-                    stateStr = stateStr.substr(1);
-
-                bool stateOn = hasState(Fw::translateState(stateStr));
-                if((!notstate && !stateOn) || (notstate && stateOn))
-                    match = false;
-            }
+        int states, excludedStates;
+        if(!Fw::translateStateSelector(style, states, excludedStates))
+            continue;
 
-            // merge states styles
-            if(match) {
-                newStateStyle->merge(style);
-            }
-        }
+        // merge states styles
+        if((m_states & states) == states && !(m_states & excludedStates))
+            newStateStyle->merge(style);
     }
 
     //TODO: prevent setting already set proprieties
@@ -1471,6 +1614,7 @@ void UIWidget::onStyleApply(const std::string& styleName, const OTMLNodePtr& sty
     parseImageStyle(styleNode);
     parseTextStyle(styleNode);
 
+    repaint();
     g_app.repaint();
 }
 
@@ -1487,6 +1631,7 @@ void UIWidget::onGeometryChange(const Rect& oldRect, const Rect& newRect)
 
     callLuaField("onGeometryChange", oldRect, newRect);
 
+    repaint();
     g_app.repaint();
 }
 
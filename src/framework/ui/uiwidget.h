@@ -58,6 +58,19 @@ protected:
 
     friend class UIManager;
 
+private:
+    void drawContents(const Rect& visibleRect, Fw::DrawPane drawPane);
+    void drawLayer(const Rect& visibleRect);
+    void releaseLayer();
+
+    FrameBufferPtr m_layer;
+    stdext::boolean<false> m_renderLayer;
+    stdext::boolean<true> m_layerDirty;
+    stdext::boolean<false> m_layerBypassed;
+    float m_layerOpacity;
+    int m_layerRedraws;
+
+protected:
     std::string m_id;
     Rect m_rect;
     Point m_virtualOffset;
@@ -113,6 +126,8 @@ public:
     void bindRectToParent();
     void destroy();
     void destroyChildren();
+    void repaint();
+    void bypassLayers();
 
     void setId(const std::string& id);
     void setParent(const UIWidgetPtr& parent);
@@ -128,11 +143,12 @@ public:
     void setPhantom(bool phantom);
     void setDraggable(bool draggable);
     void setFixedSize(bool fixed);
-    void setClipping(bool clipping) { m_clipping = clipping; }
+    void setClipping(bool clipping) { m_clipping = clipping; repaint(); }
     void setLastFocusReason(Fw::FocusReason reason);
     void setAutoFocusPolicy(Fw::AutoFocusPolicy policy);
     void setAutoRepeatDelay(int delay) { m_autoRepeatDelay = delay; }
     void setVirtualOffset(const Point& offset);
+    void setRenderLayer(bool enable);
 
     bool isAnchored();
     bool isChildLocked(const UIWidgetPtr& child);
@@ -171,10 +187,13 @@ private:
     void updateStates();
     void updateChildrenIndexStates();
     void updateStyle();
+    void setStyleNode(const OTMLNodePtr& styleNode, const UICompiledStylePtr& compiledStyle);
 
     stdext::boolean<false> m_updateStyleScheduled;
     stdext::boolean<true> m_firstOnStyle;
     OTMLNodePtr m_stateStyle;
+    UICompiledStylePtr m_compiledStyle;
+    uint64 m_appliedStateBlocks;
     int m_states;
 
 
@@ -245,6 +264,7 @@ public:
     bool isFixedSize() { return m_fixedSize; }
     bool isClipping() { return m_clipping; }
     bool isDestroyed() { return m_destroyed; }
+    bool isRenderLayer() { return m_renderLayer; }
 
     bool hasChildren() { return m_children.size() > 0; }
     bool containsMarginPoint(const Point& point) { return getMarginRect().contains(point); }
@@ -266,6 +286,7 @@ public:
     Point getVirtualOffset() { return m_virtualOffset; }
     std::string getStyleName() { return m_style->tag(); }
     Point getLastClickPosition() { return m_lastClickPosition; }
+    int getLayerRedraws() { return m_layerRedraws; }
 
 
 // base style
@@ -302,36 +323,36 @@ public:
     void setHeight(int height) { resize(getWidth(), height); }
     void setSize(const Size& size) { resize(size.width(), size.height()); }
     void setPosition(const Point& pos) { move(pos.x, pos.y); }
-    void setColor(const Color& color) { m_color = color; }
-    void setBackgroundColor(const Color& color) { m_backgroundColor = color; }
-    void setBackgroundOffsetX(int x) { m_backgroundRect.setX(x); }
-    void setBackgroundOffsetY(int y) { m_backgroundRect.setX(y); }
-    void setBackgroundOffset(const Point& pos) { m_backgroundRect.move(pos); }
-    void setBackgroundWidth(int width) { m_backgroundRect.setWidth(width); }
-    void setBackgroundHeight(int height) { m_backgroundRect.setHeight(height); }
-    void setBackgroundSize(const Size& size) { m_backgroundRect.resize(size); }
-    void setBackgroundRect(const Rect& rect) { m_backgroundRect = rect; }
+    void setColor(const Color& color) { m_color = color; repaint(); }
+    void setBackgroundColor(const Color& color) { m_backgroundColor = color; repaint(); }
+    void setBackgroundOffsetX(int x) { m_backgroundRect.setX(x); repaint(); }
+    void setBackgroundOffsetY(int y) { m_backgroundRect.setX(y); repaint(); }
+    void setBackgroundOffset(const Point& pos) { m_backgroundRect.move(pos); repaint(); }
+    void setBackgroundWidth(int width) { m_backgroundRect.setWidth(width); repaint(); }
+    void setBackgroundHeight(int height) { m_backgroundRect.setHeight(height); repaint(); }
+    void setBackgroundSize(const Size& size) { m_backgroundRect.resize(size); repaint(); }
+    void setBackgroundRect(const Rect& rect) { m_backgroundRect = rect; repaint(); }
     void setIcon(const std::string& iconFile);
-    void setIconColor(const Color& color) { m_iconColor = color; }
-    void setIconOffsetX(int x) { m_iconOffset.x = x; }
-    void setIconOffsetY(int y) { m_iconOffset.y = y; }
-    void setIconOffset(const Point& pos) { m_iconOffset = pos; }
-    void setIconWidth(int width) { m_iconRect.setWidth(width); }
-    void setIconHeight(int height) { m_iconRect.setHeight(height); }
-    void setIconSize(const Size& size) { m_iconRect.resize(size); }
-    void setIconRect(const Rect& rect) { m_iconRect = rect; }
-    void setIconClip(const Rect& rect) { m_iconClipRect = rect; }
-    void setIconAlign(Fw::AlignmentFlag align) { m_iconAlign = align; }
-    void setBorderWidth(int width) { m_borderWidth.set(width); updateLayout(); }
-    void setBorderWidthTop(int width) { m_borderWidth.top = width; }
-    void setBorderWidthRight(int width) { m_borderWidth.right = width; }
-    void setBorderWidthBottom(int width) { m_borderWidth.bottom = width; }
-    void setBorderWidthLeft(int width) { m_borderWidth.left = width; }
-    void setBorderColor(const Color& color) { m_borderColor.set(color); updateLayout(); }
-    void setBorderColorTop(const Color& color) { m_borderColor.top = color; }
-    void setBorderColorRight(const Color& color) { m_borderColor.right = color; }
-    void setBorderColorBottom(const Color& color) { m_borderColor.bottom = color; }
-    void setBorderColorLeft(const Color& color) { m_borderColor.left = color; }
+    void setIconColor(const Color& color) { m_iconColor = color; repaint(); }
+    void setIconOffsetX(int x) { m_iconOffset.x = x; repaint(); }
+    void setIconOffsetY(int y) { m_iconOffset.y = y; repaint(); }
+    void setIconOffset(const Point& pos) { m_iconOffset = pos; repaint(); }
+    void setIconWidth(int width) { m_iconRect.setWidth(width); repaint(); }
+    void setIconHeight(int height) { m_iconRect.setHeight(height); repaint(); }
+    void setIconSize(const Size& size) { m_iconRect.resize(size); repaint(); }
+    void setIconRect(const Rect& rect) { m_iconRect = rect; repaint(); }
+    void setIconClip(const Rect& rect) { m_iconClipRect = rect; repaint(); }
+    void setIconAlign(Fw::AlignmentFlag align) { m_iconAlign = align; repaint(); }
+    void setBorderWidth(int width) { m_borderWidth.set(width); updateLayout(); repaint(); }
+    void setBorderWidthTop(int width) { m_borderWidth.top = width; repaint(); }
+    void setBorderWidthRight(int width) { m_borderWidth.right = width; repaint(); }
+    void setBorderWidthBottom(int width) { m_borderWidth.bottom = width; repaint(); }
+    void setBorderWidthLeft(int width) { m_borderWidth.left = width; repaint(); }
+    void setBorderColor(const Color& color) { m_borderColor.set(color); updateLayout(); repaint(); }
+    void setBorderColorTop(const Color& color) { m_borderColor.top = color; repaint(); }
+    void setBorderColorRight(const Color& color) { m_borderColor.right = color; repaint(); }
+    void setBorderColorBottom(const Color& color) { m_borderColor.bottom = color; repaint(); }
+    void setBorderColorLeft(const Color& color) { m_borderColor.left = color; repaint(); }
     void setMargin(int margin) { m_margin.set(margin); updateParentLayout(); }
     void setMarginHorizontal(int margin) { m_margin.right = m_margin.left = margin; updateParentLayout(); }
     void setMarginVertical(int margin) { m_margin.bottom = m_margin.top = margin; updateParentLayout(); }
@@ -346,8 +367,8 @@ public:
     void setPaddingRight(int padding) { m_padding.right = padding; updateLayout(); }
     void setPaddingBottom(int padding) { m_padding.bottom = padding; updateLayout(); }
     void setPaddingLeft(int padding) { m_padding.left = padding; updateLayout(); }
-    void setOpacity(float opacity) { m_opacity = stdext::clamp<float>(opacity, 0.0f, 1.0f); }
-    void setRotation(float degrees) { m_rotation = degrees; }
+    void setOpacity(float opacity) { m_opacity = stdext::clamp<float>(opacity, 0.0f, 1.0f); repaint(); }
+    void setRotation(float degrees) { m_rotation = degrees; repaint(); }
 
     int getX() { return m_rect.x(); }
     int getY() { return m_rect.y(); }
@@ -400,8 +421,11 @@ private:
     void initImage();
     void parseImageStyle(const OTMLNodePtr& styleNode);
 
-    void updateImageCache() { m_imageMustRecache = true; }
+    void updateImageCache() { m_imageMustRecache = true; repaint(); }
     void configureBorderImage() { m_imageBordered = true; updateImageCache(); }
+    void applyImageTexture(const TexturePtr& texture);
+
+    std::string m_imageAsyncSource;
 
     CoordsBuffer m_imageCoordsBuffer;
     Rect m_imageCachedScreenCoords;
@@ -424,6 +448,8 @@ protected:
 
 public:
     void setImageSource(const std::string& source);
+    /// Decodes the image in background, the widget shows it once it is uploaded
+    void setImageSourceAsync(const std::string& source);
     void setImageClip(const Rect& clipRect) { m_imageClipRect = clipRect; updateImageCache(); }
     void setImageOffsetX(int x) { m_imageRect.setX(x); updateImageCache(); }
     void setImageOffsetY(int y) { m_imageRect.setY(y); updateImageCache(); }
@@ -432,10 +458,10 @@ public:
     void setImageHeight(int height) { m_imageRect.setHeight(height); updateImageCache(); }
     void setImageSize(const Size& size) { m_imageRect.resize(size); updateImageCache(); }
     void setImageRect(const Rect& rect) { m_imageRect = rect; updateImageCache(); }
-    void setImageColor(const Color& color) { m_imageColor = color; updateImageCache(); }
+    void setImageColor(const Color& color) { m_imageColor = color; repaint(); }
     void setImageFixedRatio(bool fixedRatio) { m_imageFixedRatio = fixedRatio; updateImageCache(); }
     void setImageRepeated(bool repeated) { m_imageRepeated = repeated; updateImageCache(); }
-    void setImageSmooth(bool smooth) { m_imageSmooth = smooth; }
+    void setImageSmooth(bool smooth) { m_imageSmooth = smooth; repaint(); }
     void setImageAutoResize(bool autoResize) { m_imageAutoResize = autoResize; }
     void setImageBorderTop(int border) { m_imageBorder.top = border; configureBorderImage(); }
     void setImageBorderRight(int border) { m_imageBorder.right = border; configureBorderImage(); }
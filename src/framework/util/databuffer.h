@@ -93,6 +93,12 @@ public:
 
     inline DataBuffer &operator<<(const T &t) { add(t); return *this; }
 
+    inline void swap(DataBuffer& other) {
+        std::swap(m_size, other.m_size);
+        std::swap(m_capacity, other.m_capacity);
+        std::swap(m_buffer, other.m_buffer);
+    }
+
 private:
     uint m_size;
     uint m_capacity;
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2010-2017 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "xmlcache.h"
+
+#include <framework/core/resourcemanager.h>
+#include <framework/core/filestream.h>
+
+enum {
+    XML_CACHE_SIGNATURE = 0x4358544F, // OTXC
+    XML_CACHE_FORMAT = 2
+};
+
+// sources may change within the same second keeping their size, so they are matched by content
+static bool getSourceInfo(const std::string& source, uint64& hash, uint& size)
+{
+    try {
+        FileBufferPtr buffer = g_resources.readFileBuffer(source);
+        hash = stdext::fnv1a64((const uint8*)buffer->data(), buffer->size());
+        size = buffer->size();
+        return true;
+    } catch(stdext::exception&) {
+        return false;
+    }
+}
+
+FileStreamPtr XmlCache::open(const std::string& cacheFile, const std::vector<std::string>& sources, uint16 version)
+{
+    if(!g_resources.fileExists(cacheFile))
+        return nullptr;
+
+    try {
+        FileStreamPtr fin = g_resources.openFile(cacheFile);
+        fin->cache();
+
+        if(fin->getU32() != XML_CACHE_SIGNATURE || fin->getU16() != XML_CACHE_FORMAT || fin->getU16() != version ||
+           fin->getU32() != sources.size())
+            return nullptr;
+
+        for(const std::string& source : sources) {
+            uint64 hash;
+            uint size;
+            if(!getSourceInfo(source, hash, size))
+                return nullptr;
+            if(fin->getString() != source || fin->getU64() != hash || fin->getU32() != size)
+                return nullptr;
+        }
+        return fin;
+    } catch(stdext::exception& e) {
+        g_logger.debug(stdext::format("Discarding xml cache '%s': %s", cacheFile, e.what()));
+    }
+    return nullptr;
+}
+
+FileStreamPtr XmlCache::create(const std::string& cacheFile, const std::vector<std::string>& sources, uint16 version)
+{
+    if(g_resources.getWriteDir().empty())
+        return nullptr;
+
+    std::vector<std::pair<uint64, uint>> infos(sources.size());
+    for(uint i = 0; i < sources.size(); ++i) {
+        if(!getSourceInfo(sources[i], infos[i].first, infos[i].second))
+            return nullptr;
+    }
+
+    try {
+        g_resources.makeDir("xmlcache");
+        FileStreamPtr fout = g_resources.createFile(cacheFile);
+        fout->cache();
+
+        fout->addU32(XML_CACHE_SIGNATURE);
+        fout->addU16(XML_CACHE_FORMAT);
+        fout->addU16(version);
+        fout->addU32(sources.size());
+        for(uint i = 0; i < sources.size(); ++i) {
+            fout->addString(sources[i]);
+            fout->addU64(infos[i].first);
+            fout->addU32(infos[i].second);
+        }
+        return fout;
+    } catch(stdext::exception& e) {
+        g_logger.debug(stdext::format("Unable to create xml cache '%s': %s", cacheFile, e.what()));
+    }
+    return nullptr;
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2010-2017 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef XMLCACHE_H
+#define XMLCACHE_H
+
+#include <framework/core/declarations.h>
+
+/**
+ * Binary caches of data read from xml files. A cache is only valid while
+ * all of its source files keep the same size and content hash.
+ */
+namespace XmlCache
+{
+    /// Returns the cache positioned after its header, or nullptr when it is missing or stale
+    FileStreamPtr open(const std::string& cacheFile, const std::vector<std::string>& sources, uint16 version);
+    /// Returns a cached stream with the header already written, or nullptr when caching is not possible
+    FileStreamPtr create(const std::string& cacheFile, const std::vector<std::string>& sources, uint16 version);
+}
+
+#endif
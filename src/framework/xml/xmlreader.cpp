@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2010-2017 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "xmlreader.h"
+
+XmlReader::XmlReader(const std::string& buffer) :
+    m_begin(buffer.data()),
+    m_pos(buffer.data()),
+    m_end(buffer.data() + buffer.size()),
+    m_token(None),
+    m_attributeCount(0),
+    m_depth(-1),
+    m_level(0),
+    m_emptyElement(false),
+    m_pendingEnd(false)
+{
+}
+
+bool XmlReader::next()
+{
+    // empty elements report their end right after the start
+    if(m_pendingEnd) {
+        m_pendingEnd = false;
+        m_token = EndElement;
+        m_attributeCount = 0;
+        m_depth = --m_level;
+        return true;
+    }
+
+    while(true) {
+        // text between tags is not used
+        m_pos = (const char*)memchr(m_pos, '<', m_end - m_pos);
+        if(!m_pos) {
+            m_pos = m_end;
+            if(m_level > 0)
+                throwError("unexpected end of document");
+            m_token = None;
+            return false;
+        }
+
+        ++m_pos;
+        if(m_pos >= m_end)
+            throwError("unexpected end of document");
+
+        if(*m_pos == '?') {
+            skipPast("?>");
+            continue;
+        }
+
+        if(*m_pos == '!') {
+            if(m_end - m_pos >= 3 && strncmp(m_pos, "!--", 3) == 0)
+                skipPast("-->");
+            else if(m_end - m_pos >= 8 && strncmp(m_pos, "![CDATA[", 8) == 0)
+                skipPast("]]>");
+            else {
+                // doctype, with an optional internal subset
+                while(m_pos < m_end && *m_pos != '>' && *m_pos != '[')
+                    ++m_pos;
+                if(m_pos < m_end && *m_pos == '[')
+                    skipPast("]");
+                skipPast(">");
+            }
+            continue;
+        }
+
+        if(*m_pos == '/') {
+            ++m_pos;
+            readName(m_name);
+            skipSpaces();
+            if(m_pos >= m_end || *m_pos != '>')
+                throwError("expected '>'");
+            ++m_pos;
+            if(m_level == 0)
+                throwError(stdext::format("unexpected end tag '%s'", m_name));
+
+            m_token = EndElement;
+            m_attributeCount = 0;
+            m_emptyElement = false;
+            m_depth = --m_level;
+            return true;
+        }
+
+        readTag();
+        return true;
+    }
+}
+
+const std::string *XmlReader::findAttribute(const char *name)
+{
+    for(uint i = 0; i < m_attributeCount; ++i) {
+        if(m_attributes[i].first == name)
+            return &m_attributes[i].second;
+    }
+    return nullptr;
+}
+
+void XmlReader::readTag()
+{
+    readName(m_name);
+
+    // attribute strings are reused between tags to avoid allocations
+    m_attributeCount = 0;
+    while(true) {
+        skipSpaces();
+        if(m_pos >= m_end)
+            throwError("unexpected end of document");
+
+        if(*m_pos == '>') {
+            ++m_pos;
+            m_emptyElement = false;
+            break;
+        }
+
+        if(*m_pos == '/') {
+            ++m_pos;
+            if(m_pos >= m_end || *m_pos != '>')
+                throwError("expected '>'");
+            ++m_pos;
+            m_emptyElement = true;
+            break;
+        }
+
+        if(m_attributeCount == m_attributes.size())
+            m_attributes.resize(m_attributeCount + 1);
+        std::pair<std::string, std::string>& attribute = m_attributes[m_attributeCount++];
+
+        readName(attribute.first);
+        skipSpaces();
+        if(m_pos >= m_end || *m_pos != '=')
+            throwError(stdext::format("expected '=' after attribute '%s'", attribute.first));
+        ++m_pos;
+        skipSpaces();
+        readValue(attribute.second);
+    }
+
+    m_token = StartElement;
+    m_depth = m_level++;
+    m_pendingEnd = m_emptyElement;
+}
+
+void XmlReader::readName(std::string& out)
+{
+    const char *start = m_pos;
+    while(m_pos < m_end && !isspace((uchar)*m_pos) && *m_pos != '=' && *m_pos != '>' && *m_pos != '/')
+        ++m_pos;
+    if(m_pos == start)
+        throwError("expected a name");
+    out.assign(start, m_pos);
+}
+
+void XmlReader::readValue(std::string& out)
+{
+    if(m_pos >= m_end || (*m_pos != '"' && *m_pos != '\''))
+        throwError("expected a quoted value");
+
+    char quote = *m_pos++;
+    const char *start = m_pos;
+    const char *end = (const char*)memchr(m_pos, quote, m_end - m_pos);
+    if(!end)
+        throwError("unterminated attribute value");
+    m_pos = end + 1;
+
+    const char *entity = (const char*)memchr(start, '&', end - start);
+    if(!entity) {
+        out.assign(start, end);
+        return;
+    }
+
+    out.assign(start, entity);
+    for(const char *p = entity; p < end; ++p) {
+        if(*p != '&') {
+            out += *p;
+            continue;
+        }
+
+        const char *semicolon = (const char*)memchr(p, ';', end - p);
+        if(!semicolon) {
+            out += *p;
+            continue;
+        }
+
+        std::string name(p + 1, semicolon);
+        if(name == "lt")
+            out += '<';
+        else if(name == "gt")
+            out += '>';
+        else if(name == "amp")
+            out += '&';
+        else if(name == "quot")
+            out += '"';
+        else if(name == "apos")
+            out += '\'';
+        else if(name.size() > 1 && name[0] == '#') {
+            ulong code = name[1] == 'x' ? strtoul(name.c_str() + 2, nullptr, 16) : strtoul(name.c_str() + 1, nullptr, 10);
+            if(code < 0x80)
+                out += (char)code;
+            else if(code < 0x800) {
+                out += (char)(0xC0 | (code >> 6));
+                out += (char)(0x80 | (code & 0x3F));
+            } else if(code < 0x10000) {
+                out += (char)(0xE0 | ((code >> 12) & 0x0F));
+                out += (char)(0x80 | ((code >> 6) & 0x3F));
+                out += (char)(0x80 | (code & 0x3F));
+            } else if(code <= 0x10FFFF) {
+                out += (char)(0xF0 | ((code >> 18) & 0x07));
+                out += (char)(0x80 | ((code >> 12) & 0x3F));
+                out += (char)(0x80 | ((code >> 6) & 0x3F));
+                out += (char)(0x80 | (code & 0x3F));
+            } else {
+                // not a code point
+                out.append(p, semicolon + 1);
+            }
+        } else {
+            // unknown entities are kept as they are
+            out.append(p, semicolon + 1);
+        }
+        p = semicolon;
+    }
+}
+
+void XmlReader::skipSpaces()
+{
+    while(m_pos < m_end && isspace((uchar)*m_pos))
+        ++m_pos;
+}
+
+void XmlReader::skipPast(const char *end)
+{
+    const char *found = std::search(m_pos, m_end, end, end + strlen(end));
+    if(found == m_end)
+        throwError(stdext::format("expected '%s'", end));
+    m_pos = found + strlen(end);
+}
+
+void XmlReader::throwError(const std::string& message)
+{
+    int line = 1 + std::count(m_begin, std::min(m_pos, m_end), '\n');
+    stdext::throw_exception(stdext::format("%s at line %d", message, line));
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2010-2017 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef XMLREADER_H
+#define XMLREADER_H
+
+#include <framework/global.h>
+
+/**
+ * Forward only xml reader, elements are visited in document order without
+ * building a tree. Text, comments, declarations and CDATA sections are skipped.
+ */
+class XmlReader
+{
+public:
+    enum Token {
+        None,
+        StartElement,
+        EndElement
+    };
+
+    XmlReader(const std::string& buffer);
+
+    /// Advances to the next start or end tag, returns false at the end of the document
+    bool next();
+
+    Token token() { return m_token; }
+    const std::string& name() { return m_name; }
+    /// Depth of the current element, the root element is at depth 0
+    int depth() { return m_depth; }
+    bool isEmptyElement() { return m_emptyElement; }
+
+    bool hasAttribute(const char *name) { return findAttribute(name) != nullptr; }
+    std::string attribute(const char *name) {
+        const std::string *value = findAttribute(name);
+        return value ? *value : std::string();
+    }
+
+    template<typename T>
+    T readType(const char *name) {
+        const std::string *value = findAttribute(name);
+        return value ? castValue<T>(*value) : T();
+    }
+
+private:
+    const std::string *findAttribute(const char *name);
+    void readTag();
+    void readName(std::string& out);
+    void readValue(std::string& out);
+    void skipSpaces();
+    void skipPast(const char *end);
+    void throwError(const std::string& message);
+
+    template<typename T>
+    static typename std::enable_if<std::is_integral<T>::value, T>::type castValue(const std::string& value) {
+        return (T)strtol(value.c_str(), nullptr, 10);
+    }
+    template<typename T>
+    static typename std::enable_if<!std::is_integral<T>::value, T>::type castValue(const std::string& value) {
+        return stdext::unsafe_cast<T>(value);
+    }
+
+    const char *m_begin;
+    const char *m_pos;
+    const char *m_end;
+    Token m_token;
+    std::string m_name;
+    std::vector<std::pair<std::string, std::string>> m_attributes;
+    uint m_attributeCount;
+    int m_depth;
+    int m_level;
+    bool m_emptyElement;
+    bool m_pendingEnd;
+};
+
+#endif